@@ -0,0 +1,51 @@
+// Benchmarks for rum. Built with `make bench` and run from the repo root
+// with `./bench.exe [name]`, or `./rum-bench [name]` on Linux. Runs all
+// benchmarks if no name is given.
+
+#pragma once
+
+#include "rum.h"
+
+// Returns time in seconds from an arbitrary starting point.
+double BenchNow();
+// Loads config, theme and languages without opening the editor.
+void BenchLoadConfig();
+// Opens filepath in an editor of the given size that renders to the headless terminal.
+void BenchEditorOpen(char *filepath, int width, int height);
+// Opens filepath in an editor that renders to the given terminal backend.
+void BenchEditorOpenEx(char *filepath, TermBackend backend);
+void BenchEditorClose();
+// Prints a result line with consistent formatting.
+void BenchReport(const char *name, const char *format, ...);
+// Fills text with size bytes of log lines, the needle only appears in the last
+// one. Writes start of each line to lineStarts, followed by the end of text.
+// Returns number of lines. Free lineStarts.
+int BenchMakeLog(char *text, int size, int **lineStarts, char *needle);
+
+#define BENCH_MAX_FILE KB(16) // Max size of a file written by BenchMakeTree
+
+// Writes the path of entry i of a tree, relative to its root, to path, which
+// holds MAX_PATH bytes, and its contents to data, which holds BENCH_MAX_FILE
+// bytes. Returns the length of the contents, -1 if the entry is a directory.
+typedef int (*BenchEntryFunc)(int i, char *path, char *data, void *arg);
+
+// Writes numEntries files and directories under root, creating directories
+// as needed. Paths use '/'. Returns false on failure.
+bool BenchMakeTree(char *root, int numEntries, BenchEntryFunc entry, void *arg);
+// Removes root and everything under it.
+void BenchRemoveTree(char *root);
+
+void BenchSyntax();
+void BenchRender();
+void BenchColorDepth();
+void BenchInput();
+void BenchSearch();
+void BenchFindPrompt();
+void BenchSearchThreads();
+void BenchGrep();
+void BenchIndex();
+void BenchExplorer();
+void BenchFinder();
+void BenchReplace();
+void BenchRegex();
+void BenchStartup();
@@ -0,0 +1,130 @@
+// Opening a directory of 50K entries in the file explorer, against the loop it
+// used before: list everything, then format each entry and insert directories
+// at the end of the directories so far.
+
+#include "bench.h"
+#include <time.h>
+
+#define EXPLORER_DIR "bench_explorer"
+#define EXPLORER_DIRS 5000   // Directories in the listed directory
+#define EXPLORER_FILES 45000 // Files in the listed directory
+
+#define EXPLORER_SIZE (EXPLORER_DIRS + EXPLORER_FILES)
+
+// Entries are created out of order so listing order does not match the
+// sorted order. Files hold up to 255 bytes.
+static int explorerEntry(int n, char *path, char *data, void *arg)
+{
+    (void)arg;
+    int i = (n * 7919) % EXPLORER_SIZE;
+    if (i < EXPLORER_DIRS)
+    {
+        sprintf(path, "dir_%05d", i);
+        return -1;
+    }
+
+    sprintf(path, "file_%05d.txt", i - EXPLORER_DIRS);
+    memset(data, 'x', i % 256);
+    return i % 256;
+}
+
+static Buffer *newExplorerBuffer()
+{
+    Buffer *b = BufferNew();
+    b->exPaths = StrArrayNew(KB(0.5));
+    return b;
+}
+
+// The explorer before listings were read on a thread. Returns ms.
+static double oldList(char *dir)
+{
+    Buffer *b = newExplorerBuffer();
+    double start = BenchNow();
+
+    int numFiles = 0;
+    DirEntry *files = IoListDir(dir, &numFiles);
+    char lineFormatString[1024];
+    int numDirs = 0;
+
+    for (int i = 0; i < numFiles; i++)
+    {
+        DirEntry *file = &files[i];
+
+        char fileSizeS[64];
+        StrNumberToReadable(file->size, fileSizeS);
+
+        char date[64];
+        time_t modified = (time_t)file->modified;
+        strftime(date, 64, "%d.%m.%Y", localtime(&modified));
+
+        int filenameLen = strlen(file->name);
+        int lineLen = sprintf(lineFormatString, "%s %s %s", fileSizeS, date, file->name);
+        int row = file->isDir ? (++numDirs) : -1;
+
+        Line *line = BufferInsertLineEx(b, row, lineFormatString, lineLen);
+        line->exPathId = StrArraySet(&b->exPaths, file->name, filenameLen);
+        line->isPath = true;
+        line->isDir = file->isDir;
+    }
+    MemFree(files);
+
+    double ms = (BenchNow() - start) * 1e3;
+    BufferFree(b);
+    return ms;
+}
+
+// Reads the listing like the explorer does. Writes ms until the first rows
+// were shown to firstMs. Returns ms until all rows are sorted.
+static double newList(char *dir, double *firstMs, int *numRows)
+{
+    Buffer *b = newExplorerBuffer();
+    int firstRow = b->numLines;
+    double start = BenchNow();
+    *firstMs = 0;
+
+    DirList *list = DirListStart(dir);
+    while (!DirListRead(list, b))
+    {
+        if (*firstMs == 0 && b->numLines > firstRow)
+            *firstMs = (BenchNow() - start) * 1e3;
+        TimeSleep(1);
+    }
+
+    double ms = (BenchNow() - start) * 1e3;
+    if (*firstMs == 0)
+        *firstMs = ms;
+
+    *numRows = b->numLines - firstRow;
+    DirListFree(list);
+    BufferFree(b);
+    return ms;
+}
+
+void BenchExplorer()
+{
+    if (!BenchMakeTree(EXPLORER_DIR, EXPLORER_SIZE, explorerEntry, NULL))
+    {
+        printf("  failed to write %s\n", EXPLORER_DIR);
+        BenchRemoveTree(EXPLORER_DIR);
+        return;
+    }
+
+    char dir[PATH_MAX];
+    IoGetCwd(dir, PATH_MAX);
+    strcat(dir, "/" EXPLORER_DIR);
+
+    // Listings of a directory changed in the same second are not kept
+    TimeSleep(1100);
+
+    int numRows;
+    double firstMs;
+    BenchReport("old loop", "%8.1f ms", oldList(dir));
+
+    double ms = newList(dir, &firstMs, &numRows);
+    BenchReport("listed on a thread", "%8.1f ms  first rows after %.1f ms, %d entries", ms, firstMs, numRows);
+
+    ms = newList(dir, &firstMs, &numRows);
+    BenchReport("opened again, cached", "%8.1f ms", ms);
+
+    BenchRemoveTree(EXPLORER_DIR);
+}
@@ -0,0 +1,121 @@
+// Ranking a tree of 200K file paths with the fuzzy file finder, one key at a
+// time like in the prompt, by number of threads. The tree is written once and
+// listed warm.
+
+#include "bench.h"
+
+#define FINDER_DIR "bench_finder"
+#define FINDER_DIRS 50     // Top level directories
+#define FINDER_SUBDIRS 20  // Directories in each top level one
+#define FINDER_FILES 200   // Files in each subdirectory
+#define NUM_WORDS 16
+
+static char *words[NUM_WORDS] = {
+    "buffer", "render", "input", "screen", "syntax", "config", "parser", "window",
+    "thread", "search", "editor", "cursor", "string", "module", "handler", "network",
+};
+
+static char *extensions[] = {".c", ".h", ".txt", ".json"};
+
+#define FINDER_SIZE (FINDER_DIRS * FINDER_SUBDIRS * FINDER_FILES)
+
+// Empty files named from a few words, like source files in a project.
+static int finderFile(int k, char *path, char *data, void *arg)
+{
+    (void)data;
+    (void)arg;
+    int d = k / (FINDER_SUBDIRS * FINDER_FILES), s = k / FINDER_FILES % FINDER_SUBDIRS, f = k % FINDER_FILES;
+    sprintf(path, "%s_%02d/%s%s_%02d/%s_%s_%03d%s", words[d % NUM_WORDS], d, words[(d + s) % NUM_WORDS], words[(s * 7) % NUM_WORDS], s,
+            words[(f * 3 + s) % NUM_WORDS], words[(f * 5 + d) % NUM_WORDS], f, extensions[f % 4]);
+    return 0;
+}
+
+// Types query one key at a time, then deletes it again. Writes the slowest key
+// to maxMs and the average backspace to deleteMs. Returns average ms per key.
+static double typeQuery(Finder *f, char *query, double *maxMs, double *deleteMs, int *numMatches)
+{
+    char *results[FINDER_MAX_RESULTS];
+    int numResults;
+    int length = strlen(query);
+    double total = 0;
+    *maxMs = 0;
+
+    for (int i = 1; i <= length; i++)
+    {
+        double start = BenchNow();
+        *numMatches = FinderQuery(f, query, i, results, &numResults);
+        double ms = (BenchNow() - start) * 1e3;
+        total += ms;
+        *maxMs = max(*maxMs, ms);
+    }
+
+    double start = BenchNow();
+    for (int i = length - 1; i >= 1; i--)
+        FinderQuery(f, query, i, results, &numResults);
+    *deleteMs = (BenchNow() - start) * 1e3 / (length - 1);
+
+    // Back to the empty query, so the next one starts from all files
+    FinderQuery(f, query, 0, results, &numResults);
+    return total / length;
+}
+
+// Ranks all files against query from scratch, without the matches of a
+// shorter query. Returns ms.
+static double fullScan(Finder *f, char *query)
+{
+    char *results[FINDER_MAX_RESULTS];
+    int numResults;
+    FinderQuery(f, query, 0, results, &numResults);
+
+    double start = BenchNow();
+    FinderQuery(f, query, strlen(query), results, &numResults);
+    double ms = (BenchNow() - start) * 1e3;
+
+    FinderQuery(f, query, 0, results, &numResults);
+    return ms;
+}
+
+void BenchFinder()
+{
+    if (!BenchMakeTree(FINDER_DIR, FINDER_SIZE, finderFile, NULL))
+    {
+        printf("  failed to write %s\n", FINDER_DIR);
+        BenchRemoveTree(FINDER_DIR);
+        return;
+    }
+
+    double start = BenchNow();
+    Finder *f = FinderStart(FINDER_DIR);
+    int numFiles;
+    while (!FinderDone(f, &numFiles))
+        TimeSleep(1);
+    BenchReport("listing", "%8.1f ms  %d files", (BenchNow() - start) * 1e3, numFiles);
+
+    char *queries[] = {"rendcurs_12", "bufferhandlr", "net/conf.json"};
+    int cpus = CpuCount();
+
+    for (int q = 0; q < 3; q++)
+    {
+        for (int n = 1;; n = min(n * 2, cpus))
+        {
+            WorkerSetCount(n);
+
+            double maxMs, deleteMs;
+            int numMatches;
+            double avg = typeQuery(f, queries[q], &maxMs, &deleteMs, &numMatches);
+            double scan = fullScan(f, queries[q]);
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s, %d threads", queries[q], n);
+            BenchReport(name, "%6.2f ms/key  slowest %6.2f ms  backspace %5.2f ms  from scratch %6.2f ms  %d matches",
+                        avg, maxMs, deleteMs, scan, numMatches);
+
+            if (n == cpus)
+                break;
+        }
+    }
+
+    WorkerSetCount(0);
+    FinderFree(f);
+    BenchRemoveTree(FINDER_DIR);
+}
@@ -0,0 +1,230 @@
+// Searches a synthetic source tree with :grep, by number of threads. The tree
+// is written once and searched warm, so the page cache holds all files. The
+// trigram index is measured on the same tree.
+
+#include "bench.h"
+
+#define TREE_DIR "bench_tree"
+#define TREE_DIRS 50      // Top level directories
+#define TREE_SUBDIRS 4    // Directories in each top level one
+#define TREE_FILES 100    // Files in each subdirectory
+#define NEEDLE_EVERY 50   // Every nth file has a matching line
+#define POOL_SIZE KB(256) // Log text files are cut from
+#define CHANGE_EVERY 100  // Every nth file is changed before the index is updated
+#define QUERY_RUNS 1000   // Index lookups timed for the average
+
+#define TREE_SIZE (TREE_DIRS * TREE_SUBDIRS * TREE_FILES)
+
+typedef struct logPool
+{
+    char *text;
+    int size;
+} logPool;
+
+// Writes the path of file k, relative to TREE_DIR.
+static void treePath(char *dest, int k)
+{
+    sprintf(dest, "d%02d/s%d/f%03d.txt", k / (TREE_SUBDIRS * TREE_FILES), k / TREE_FILES % TREE_SUBDIRS, k % TREE_FILES);
+}
+
+// 2 to 8 KB of log lines, some with a matching line and some binary.
+static int treeFile(int k, char *path, char *data, void *arg)
+{
+    logPool *pool = arg;
+    int length = KB(2) + (k * 7919) % KB(6);
+    int offset = (k * 104729) % (pool->size - length);
+    memcpy(data, pool->text + offset, length);
+    if (k % NEEDLE_EVERY == 0)
+        length += sprintf(data + length, "\n2024-03-28 12:00:00 ERROR worker-7: connection refused\n");
+
+    // Some object files in between
+    if (k % TREE_FILES % 25 == 24)
+        data[length / 2] = 0;
+
+    treePath(path, k);
+    return length;
+}
+
+// Writes the tree. Returns number of files, 0 on failure.
+static int makeTree()
+{
+    logPool pool = {.text = MemAlloc(POOL_SIZE)};
+    int *starts;
+    int numLines = BenchMakeLog(pool.text, POOL_SIZE, &starts, "unused");
+    pool.size = starts[numLines - 1]; // Without the needle line
+    MemFree(starts);
+
+    bool ok = BenchMakeTree(TREE_DIR, TREE_SIZE, treeFile, &pool);
+    MemFree(pool.text);
+    return ok ? TREE_SIZE : 0;
+}
+
+// Runs grep until all files are searched. Returns ms.
+static double runGrep(char *pattern, GrepStats *stats)
+{
+    Buffer *b = BufferNew();
+    b->exPaths = StrArrayNew(KB(4));
+    b->isResults = true;
+
+    double start = BenchNow();
+    Grep *g = GrepStart(pattern, strlen(pattern), TREE_DIR);
+    AssertNotNull(g);
+
+    while (!GrepRead(g, b))
+        TimeSleep(1);
+
+    double ms = (BenchNow() - start) * 1e3;
+    *stats = GrepGetStats(g);
+    GrepFree(g);
+    BufferFree(b);
+    return ms;
+}
+
+void BenchGrep()
+{
+    int numFiles = makeTree();
+    if (numFiles == 0)
+    {
+        printf("  failed to write %s\n", TREE_DIR);
+        BenchRemoveTree(TREE_DIR);
+        return;
+    }
+
+    int cpus = CpuCount();
+    GrepStats stats;
+    runGrep("connection refused", &stats); // Warm up the page cache
+    printf("  %d files, %d binary, %d CPUs\n", stats.files, stats.binary, cpus);
+
+    char *patterns[] = {"connection refused", "\\v(ERROR|FATAL) worker-\\d+: conn"};
+    for (int p = 0; p < 2; p++)
+    {
+        double single = 0;
+        for (int n = 1;; n = min(n * 2, cpus))
+        {
+            WorkerSetCount(n);
+            double ms = runGrep(patterns[p], &stats);
+            if (n == 1)
+                single = ms;
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s, %d threads", patterns[p], n);
+            BenchReport(name, "%8.1f ms  %8.0f files/s  %5.2fx  %d matches", ms, stats.files / ms * 1e3, single / ms, stats.matches);
+
+            if (n == cpus)
+                break;
+        }
+    }
+
+    WorkerSetCount(0);
+    BenchRemoveTree(TREE_DIR);
+}
+
+// Builds or updates the index. Returns ms.
+static double buildIndex(IndexStats *stats)
+{
+    double start = BenchNow();
+    if (!IndexBuild(TREE_DIR, stats))
+        printf("  failed to write index\n");
+    return (BenchNow() - start) * 1e3;
+}
+
+void BenchIndex()
+{
+    int numFiles = makeTree();
+    if (numFiles == 0)
+    {
+        printf("  failed to write %s\n", TREE_DIR);
+        BenchRemoveTree(TREE_DIR);
+        return;
+    }
+
+    // Files changed in the second the index is written are not trusted
+    TimeSleep(1100);
+
+    char indexPath[MAX_PATH];
+    snprintf(indexPath, MAX_PATH, TREE_DIR "/" INDEX_FILENAME);
+
+    int cpus = CpuCount();
+    GrepStats grepStats;
+    IndexStats stats;
+    runGrep("connection refused", &grepStats); // Warm up the page cache
+    printf("  %d files, %d CPUs\n", numFiles, cpus);
+
+    double single = 0;
+    for (int n = 1;; n = min(n * 2, cpus))
+    {
+        remove(indexPath);
+        WorkerSetCount(n);
+        double ms = buildIndex(&stats);
+        if (n == 1)
+            single = ms;
+
+        char name[64];
+        snprintf(name, sizeof(name), "build, %d threads", n);
+        BenchReport(name, "%8.1f ms  %8.0f files/s  %5.2fx  %.1f MB", ms, stats.files / ms * 1e3, single / ms, (double)stats.bytes / MB(1));
+
+        if (n == cpus)
+            break;
+    }
+
+    WorkerSetCount(0);
+    double ms = buildIndex(&stats);
+    BenchReport("update, nothing changed", "%8.1f ms  %d files read", ms, stats.read);
+
+    // Grow some files so their size changes
+    char rel[MAX_PATH], path[MAX_PATH];
+    char *line = "\n2024-03-29 08:00:00 WARN worker-2: retrying\n";
+    for (int k = 0; k < numFiles; k += CHANGE_EVERY)
+    {
+        treePath(rel, k);
+        IoJoinPath(path, MAX_PATH, TREE_DIR, rel);
+
+        int size;
+        char *data = IoReadFile(path, &size);
+        data = MemRealloc(data, size + strlen(line));
+        memcpy(data + size, line, strlen(line));
+        IoWriteFile(path, data, size + strlen(line));
+        MemFree(data);
+    }
+
+    ms = buildIndex(&stats);
+    char name[64];
+    snprintf(name, sizeof(name), "update, 1 in %d changed", CHANGE_EVERY);
+    BenchReport(name, "%8.1f ms  %d files read", ms, stats.read);
+
+    char *patterns[] = {"connection refused", "\\vconnection \\w+"};
+    for (int p = 0; p < 2; p++)
+    {
+        TrigramIndex *idx = IndexLoad(TREE_DIR);
+        AssertNotNull(idx);
+        char *word = p == 0 ? patterns[p] : "connection ";
+
+        double start = BenchNow();
+        int candidates = 0;
+        for (int i = 0; i < QUERY_RUNS; i++)
+        {
+            bool *found = IndexQuery(idx, word, strlen(word));
+            for (int k = 0; i == 0 && k < IndexNumFiles(idx); k++)
+                candidates += found[k];
+            MemFree(found);
+        }
+
+        double queryUs = (BenchNow() - start) * 1e6 / QUERY_RUNS;
+        IndexFree(idx);
+
+        double indexed = runGrep(patterns[p], &grepStats);
+        int skipped = grepStats.skipped;
+        remove(indexPath);
+        double plain = runGrep(patterns[p], &grepStats);
+        buildIndex(&stats);
+
+        snprintf(name, sizeof(name), "%s, lookup", patterns[p]);
+        BenchReport(name, "%8.1f us  %d candidate files", queryUs, candidates);
+        snprintf(name, sizeof(name), "%s, grep", patterns[p]);
+        BenchReport(name, "%8.1f ms  without index %.1f ms  %5.2fx  %d files skipped",
+                    indexed, plain, plain / indexed, skipped);
+    }
+
+    remove(indexPath);
+    BenchRemoveTree(TREE_DIR);
+}
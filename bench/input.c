@@ -0,0 +1,57 @@
+#include "bench.h"
+
+#define WIDTH 120
+#define HEIGHT 40
+#define NUM_EVENTS 10000
+#define FILEPATH "src/buffer/buffer.c"
+
+// Typical editing: moving around, then typing a word and leaving insert mode
+static char script[] = "jjjjjjlllwwbihello \x1bkkkjjjjjwwjj";
+
+static InputInfo makeEvent(int i)
+{
+    char c = script[i % (sizeof(script) - 1)];
+    return (InputInfo){
+        .eventType = INPUT_KEYDOWN,
+        .keyCode = c == '\x1b' ? K_ESCAPE : toupper(c),
+        .asciiChar = c,
+        .ctrlDown = false,
+    };
+}
+
+// Queues up to burst events at a time and renders after each EditorHandleInput,
+// like the main loop does. A burst of 1 renders once per event.
+static void run(char *name, int burst)
+{
+    BenchEditorOpen(FILEPATH, WIDTH, HEIGHT);
+    Render();
+    ScreenFlush();
+
+    int frames = 0;
+    int event = 0;
+    double start = BenchNow();
+
+    while (event < NUM_EVENTS)
+    {
+        for (int i = 0; i < burst && event < NUM_EVENTS; i++)
+            if (EditorQueueInput(makeEvent(event)))
+                event++;
+
+        if (EditorHandleInput() != NIL)
+            break;
+
+        Render();
+        ScreenFlush();
+        frames++;
+    }
+
+    double elapsed = BenchNow() - start;
+    BenchReport(name, "%6d frames  %8.1f ms total  %6.2f us/event", frames, elapsed * 1e3, elapsed * 1e6 / NUM_EVENTS);
+    BenchEditorClose();
+}
+
+void BenchInput()
+{
+    run("one frame per event", 1);
+    run("drained", INPUT_QUEUE_SIZE);
+}
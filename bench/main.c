@@ -0,0 +1,192 @@
+#include "bench.h"
+
+#include <stdarg.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define makeDir(path) _mkdir(path)
+#define removeDir(path) _rmdir(path)
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#define makeDir(path) mkdir(path, 0755)
+#define removeDir(path) rmdir(path)
+#endif
+
+extern Editor editor;
+extern Config config;
+extern Colors colors;
+
+typedef struct benchmark
+{
+    char *name;
+    void (*run)();
+    char *description;
+} benchmark;
+
+static benchmark benchmarks[] = {
+    {"syntax", BenchSyntax, "Syntax highlighting throughput per language"},
+    {"render", BenchRender, "Bytes written to the terminal per frame"},
+    {"colors", BenchColorDepth, "Bytes written per frame for each color depth"},
+    {"input", BenchInput, "Frames and time to handle a burst of key events"},
+    {"search", BenchSearch, "Substring search throughput against the old find loop"},
+    {"find", BenchFindPrompt, "Time per key typed in the Find prompt in a 2M line file"},
+    {"search-threads", BenchSearchThreads, "Time to find all matches in a 128 MB buffer by number of threads"},
+    {"grep", BenchGrep, "Time to grep a tree of 20K files by number of threads"},
+    {"index", BenchIndex, "Time to build and update a trigram index of 20K files, and grep with it"},
+    {"explorer", BenchExplorer, "Time to open a directory of 50K entries in the file explorer, and to open it again"},
+    {"finder", BenchFinder, "Time per key typed in the fuzzy file finder over 200K paths, by number of threads"},
+    {"replace", BenchReplace, "Time to replace 1M matches at once against one edit per match"},
+    {"regex", BenchRegex, "Regex search throughput and time on inputs that make backtracking blow up"},
+    {"startup", BenchStartup, "Time to first frame and key to frame latency in a terminal"},
+};
+
+double BenchNow()
+{
+    return TimeNow();
+}
+
+void BenchLoadConfig()
+{
+    if (LoadConfig(&config) != NIL)
+        ErrorExit("Failed to load config file");
+    if (LoadTheme(config.theme, &colors) != NIL)
+        ErrorExit("Failed to load theme");
+    if (LoadLanguages() != NIL)
+        ErrorExit("Failed to load syntax files");
+}
+
+void BenchEditorOpen(char *filepath, int width, int height)
+{
+    // Render to an in-memory terminal without input
+    BenchEditorOpenEx(filepath, TermHeadlessBackend(NULL, width, height));
+}
+
+void BenchEditorOpenEx(char *filepath, TermBackend backend)
+{
+    EditorPadding(PAD_BUFFER_SIZE);
+
+    if (TermInit(backend) != NIL)
+        ErrorExit("Failed to initialize terminal");
+    ScreenInvalidate();
+
+    EditorNewBuffer();
+    EditorSetActiveBuffer(0);
+    EditorSetMode(MODE_EDIT);
+
+    if (EditorOpenFile(filepath) != NIL)
+        ErrorExitf("File '%s' not found", filepath);
+
+    SetError(NULL);
+}
+
+void BenchEditorClose()
+{
+    for (int i = 0; i < editor.numBuffers; i++)
+        BufferFree(editor.buffers[i]);
+
+    editor.numBuffers = 0;
+    TermFree();
+}
+
+void BenchReport(const char *name, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    printf("  %-24s ", name);
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+// Creates dir and its parents, unless dir is made, the last one created.
+static void makeDirs(char *dir, char *made)
+{
+    if (!strcmp(dir, made))
+        return;
+
+    for (char *p = strchr(dir, '/'); p != NULL; p = strchr(p + 1, '/'))
+    {
+        *p = 0;
+        makeDir(dir);
+        *p = '/';
+    }
+
+    makeDir(dir);
+    strcpy(made, dir);
+}
+
+bool BenchMakeTree(char *root, int numEntries, BenchEntryFunc entry, void *arg)
+{
+    char *data = MemAlloc(BENCH_MAX_FILE);
+    AssertNotNull(data);
+    char made[MAX_PATH] = {0};
+    char rel[MAX_PATH];
+    char path[MAX_PATH];
+    bool ok = true;
+
+    for (int i = 0; i < numEntries && ok; i++)
+    {
+        int length = entry(i, rel, data, arg);
+        ok = IoJoinPath(path, MAX_PATH, root, rel);
+        if (!ok)
+            break;
+
+        if (length < 0)
+        {
+            makeDirs(path, made);
+            continue;
+        }
+
+        char *slash = strrchr(path, '/');
+        *slash = 0;
+        makeDirs(path, made);
+        *slash = '/';
+        ok = IoWriteFile(path, data, length);
+    }
+
+    MemFree(data);
+    return ok;
+}
+
+void BenchRemoveTree(char *root)
+{
+    int count;
+    DirEntry *entries = IoListDir(root, &count);
+    char path[MAX_PATH];
+
+    for (int i = 0; entries != NULL && i < count; i++)
+    {
+        DirEntry *e = &entries[i];
+        if (!strcmp(e->name, ".") || !strcmp(e->name, "..") || !IoJoinPath(path, MAX_PATH, root, e->name))
+            continue;
+
+        if (e->isDir && !e->isLink)
+            BenchRemoveTree(path);
+        else
+            remove(path);
+    }
+
+    if (entries != NULL)
+        MemFree(entries);
+    removeDir(root);
+}
+
+int main(int argc, char **argv)
+{
+    int numBenchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+    BenchLoadConfig();
+
+    for (int i = 0; i < numBenchmarks; i++)
+    {
+        benchmark b = benchmarks[i];
+        if (argc > 1 && strcmp(argv[1], b.name))
+            continue;
+
+        printf("%s: %s\n", b.name, b.description);
+        b.run();
+        printf("\n");
+    }
+
+    return EXIT_SUCCESS;
+}
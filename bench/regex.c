@@ -0,0 +1,123 @@
+// Regex search throughput on log lines, and time on inputs where a
+// backtracking engine takes exponential time. Compared with the libc regex
+// engine where it is available.
+
+#include "bench.h"
+
+#define TEXT_SIZE MB(64)
+#define NUM_PASSES 2
+
+#ifndef _WIN32
+#include <regex.h>
+#endif
+
+// Tests each line. Returns GB/s.
+static double measureLines(char *text, int *starts, int numLines, char *pattern)
+{
+    Regex *re = RegexCompile(pattern, strlen(pattern), false);
+    AssertNotNull(re);
+
+    int found = 0;
+    double start = BenchNow();
+
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+        for (int i = 0; i < numLines; i++)
+            found += RegexTest(re, text + starts[i], starts[i + 1] - starts[i] - 1);
+
+    double elapsed = BenchNow() - start;
+    if (found != NUM_PASSES)
+        printf("  expected one match per pass, got %d\n", found / NUM_PASSES);
+
+    RegexFree(re);
+    return (double)starts[numLines] * NUM_PASSES / elapsed / 1e9;
+}
+
+#ifndef _WIN32
+
+// Same as measureLines with the libc regex engine. Returns GB/s.
+static double measureLibc(char *text, int *starts, int numLines, char *pattern)
+{
+    regex_t re;
+    if (regcomp(&re, pattern, REG_EXTENDED | REG_NOSUB) != 0)
+        return 0;
+
+    // Only a part of the text, it is slow
+    numLines /= 16;
+    double start = BenchNow();
+
+    for (int i = 0; i < numLines; i++)
+    {
+        regmatch_t range = {.rm_so = 0, .rm_eo = starts[i + 1] - starts[i] - 1};
+        regexec(&re, text + starts[i], 1, &range, REG_STARTEND);
+    }
+
+    double elapsed = BenchNow() - start;
+    regfree(&re);
+    return (double)starts[numLines] / elapsed / 1e9;
+}
+
+#endif
+
+// Searches text for pattern with RegexTest and RegexFind. Returns ns/byte.
+static void measureWorstCase(char *name, char *pattern, char *text, int length)
+{
+    Regex *re = RegexCompile(pattern, strlen(pattern), false);
+    AssertNotNull(re);
+
+    double start = BenchNow();
+    bool found = RegexTest(re, text, length);
+    double test = BenchNow() - start;
+
+    int s, e;
+    start = BenchNow();
+    found |= RegexFind(re, text, length, 0, &s, &e);
+    double find = BenchNow() - start;
+
+    BenchReport(name, "%6.2f ns/byte test  %6.2f ns/byte find  %s", test * 1e9 / length, find * 1e9 / length, found ? "match" : "no match");
+    RegexFree(re);
+}
+
+void BenchRegex()
+{
+    char *text = MemAlloc(TEXT_SIZE);
+    int *starts;
+    int numLines = BenchMakeLog(text, TEXT_SIZE, &starts, "request timeout after 30 s");
+    printf("  %d lines, one match\n", numLines);
+
+    char *patterns[] = {
+        "ERROR.*timeout",                // Literal prefix, found with substring search
+        "(ERROR|FATAL) worker-\\d+: .*t", // No prefix, every byte through the DFA
+        "worker-\\d+: request t",         // Literal prefix on every line
+    };
+
+    for (int i = 0; i < (int)(sizeof(patterns) / sizeof(patterns[0])); i++)
+    {
+        double rum = measureLines(text, starts, numLines, patterns[i]);
+#ifndef _WIN32
+        double libc = measureLibc(text, starts, numLines, patterns[i]);
+        BenchReport(patterns[i], "%6.2f GB/s  libc %6.3f GB/s", rum, libc);
+#else
+        BenchReport(patterns[i], "%6.2f GB/s", rum);
+#endif
+    }
+
+    MemFree(starts);
+
+    // Nested repetition that fails at the end, exponential with backtracking
+    for (int length = KB(1); length <= MB(1); length *= 32)
+    {
+        memset(text, 'x', length);
+        char name[32];
+        sprintf(name, "(x+x+)+y, %d KB", length / KB(1));
+        measureWorstCase(name, "(x+x+)+y", text, length);
+    }
+
+    // Needs a DFA state for each of the 2^21 last 21 characters, so the
+    // cache is flushed all the time
+    srand(1);
+    for (int i = 0; i < MB(1); i++)
+        text[i] = "ab"[rand() % 2];
+    measureWorstCase("a[ab]{20}c, 1024 KB", "a[ab]{20}c", text, MB(1));
+
+    MemFree(text);
+}
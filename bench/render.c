@@ -0,0 +1,163 @@
+#include "bench.h"
+
+#define WIDTH 120
+#define HEIGHT 40
+#define NUM_FRAMES 400
+#define FILEPATH "src/buffer/buffer.c"
+
+extern Editor editor;
+extern Config config;
+extern Colors colors;
+
+typedef struct frameStats
+{
+    long long in;
+    long long out;
+    long long escapes;
+    int maxOut;
+    int frames;
+} frameStats;
+
+static void frame(frameStats *s)
+{
+    long long escapes = CbEscapeBytes();
+    Render();
+    ScreenFlush();
+
+    s->escapes += CbEscapeBytes() - escapes;
+    ScreenStats stats = ScreenGetStats();
+    s->out += stats.lastFrameOut;
+    s->maxOut = max(s->maxOut, stats.lastFrameOut);
+    s->frames++;
+}
+
+static void report(char *name, frameStats s, ScreenStats before, double elapsed)
+{
+    ScreenStats after = ScreenGetStats();
+    long long in = after.bytesIn - before.bytesIn;
+    double writes = (double)(after.writes - before.writes) / s.frames;
+
+    BenchReport(name, "%7lld B/frame drawn  %6lld B escapes  %6lld B/frame written  %6d max  %4.2f writes/frame  %6.1f us/frame",
+                in / s.frames, s.escapes / s.frames, s.out / s.frames, s.maxOut, writes, elapsed * 1e6 / s.frames);
+}
+
+static void run(char *name, void (*step)(int i))
+{
+    frameStats s = {0};
+    ScreenStats before = ScreenGetStats();
+    double start = BenchNow();
+
+    for (int i = 0; i < NUM_FRAMES; i++)
+    {
+        step(i);
+        frame(&s);
+    }
+
+    report(name, s, before, BenchNow() - start);
+}
+
+static void stepIdle(int i)
+{
+    (void)i;
+}
+
+static void stepCursor(int i)
+{
+    int dy = (i / 20) % 2 == 0 ? 1 : -1;
+    CursorMove(curBuffer, (i % 3) - 1, dy);
+}
+
+static void stepTyping(int i)
+{
+    char c = 'a' + (i % 26);
+    BufferWrite(curBuffer, &c, 1);
+}
+
+static void stepScroll(int i)
+{
+    (void)i;
+    CursorMove(curBuffer, 0, curBuffer->textH);
+}
+
+void BenchRender()
+{
+    BenchEditorOpen(FILEPATH, WIDTH, HEIGHT);
+
+    // First frame draws everything
+    frameStats first = {0};
+    ScreenStats before = ScreenGetStats();
+    double start = BenchNow();
+    frame(&first);
+    report("first frame", first, before, BenchNow() - start);
+
+    run("no change", stepIdle);
+    run("cursor movement", stepCursor);
+
+    // Every line number changes when the cursor moves
+    config.relativeNumbers = true;
+    run("cursor, relative numbers", stepCursor);
+    config.relativeNumbers = false;
+
+    run("typing", stepTyping);
+
+    CursorSetPos(curBuffer, 0, 0, false);
+    run("page down", stepScroll);
+
+    // Synchronized output adds a fixed number of bytes to frames that draw
+    bool sync = config.syncOutput;
+    config.syncOutput = true;
+    CursorSetPos(curBuffer, 0, 0, false);
+    run("page down, synced", stepScroll);
+    config.syncOutput = sync;
+
+    // Search matches are found while drawing the rows on screen
+    MatchIndexBuild(curBuffer, "b", 1);
+    curBuffer->showMarkedLines = true;
+    CursorSetPos(curBuffer, 0, 0, false);
+    run("page down, search marked", stepScroll);
+    run("typing, search marked", stepTyping);
+
+    BenchEditorClose();
+}
+
+// Bytes written per frame when paging through the file, for a color depth.
+static double pageDownBytes(ColorDepth depth)
+{
+    config.colorDepth = depth;
+    if (LoadTheme(config.theme, &colors) != NIL)
+        ErrorExit("Failed to load theme");
+
+    CursorSetPos(curBuffer, 0, 0, false);
+    ScreenInvalidate();
+
+    frameStats s = {0};
+    for (int i = 0; i < NUM_FRAMES; i++)
+    {
+        stepScroll(i);
+        frame(&s);
+    }
+
+    return (double)s.out / s.frames;
+}
+
+void BenchColorDepth()
+{
+    BenchEditorOpen(FILEPATH, WIDTH, HEIGHT);
+    ColorDepth depth = config.colorDepth;
+
+    char *names[] = {"truecolor", "256 colors", "16 colors"};
+    ColorDepth depths[] = {COLOR_DEPTH_TRUE, COLOR_DEPTH_256, COLOR_DEPTH_16};
+    double truecolor = 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        double bytes = pageDownBytes(depths[i]);
+        if (i == 0)
+            truecolor = bytes;
+        BenchReport(names[i], "%8.0f B/frame  %5.1f%% saved", bytes, 100.0 * (truecolor - bytes) / truecolor);
+    }
+
+    config.colorDepth = depth;
+    LoadTheme(config.theme, &colors);
+    BenchEditorClose();
+}
@@ -0,0 +1,103 @@
+// Replacing every match in a file with ReplaceText, against deleting and
+// writing each match like TypingDeleteMany and TypingWrite do.
+
+#include "bench.h"
+
+extern Editor editor;
+
+#define REPLACE_FILE "bench_replace.txt"
+#define REPLACE_MATCHES 1000000 // Matches in each file
+#define EDIT_MATCHES 2000       // Matches replaced one at a time, it is slow
+
+// Replaces the first count matches of search one edit at a time, with an undo
+// for each delete and write. Returns ms.
+static double replaceEach(char *search, char *replace, int count)
+{
+    int searchLen = strlen(search);
+    int replaceLen = strlen(replace);
+    Searcher s;
+    SearchInit(&s, search, searchLen, false);
+
+    double start = BenchNow();
+    for (int row = 0; row < curBuffer->numLines && count > 0; row++)
+    {
+        Line *line = &curBuffer->lines[row];
+        char *p;
+        int col = 0;
+
+        while (count > 0 && (p = SearchFind(&s, line->chars + col, line->length - col)) != NULL)
+        {
+            col = p - line->chars;
+            UndoSaveActionEx(A_DELETE, row, col, p, searchLen);
+            BufferDeleteEx(curBuffer, row, col + searchLen, searchLen);
+            BufferWriteEx(curBuffer, row, col, replace, replaceLen);
+            UndoSaveActionEx(A_WRITE, row, col, replace, replaceLen);
+            col += replaceLen;
+            count--;
+        }
+    }
+
+    return (BenchNow() - start) * 1e3;
+}
+
+// Replaces value_ in text both ways and reports the time for all matches.
+static void measureFile(char *name, char *text, int size)
+{
+    if (!IoWriteFile(REPLACE_FILE, text, size))
+    {
+        printf("  failed to write %s\n", REPLACE_FILE);
+        return;
+    }
+
+    BenchEditorOpen(REPLACE_FILE, 120, 40);
+    remove(REPLACE_FILE);
+    printf("  %s\n", name);
+
+    double ms = replaceEach("value_", "result_", EDIT_MATCHES);
+    int undoBytes = curBuffer->undos.length * sizeof(EditorAction);
+    BenchReport("edit per match", "%8.0f ms  undo %4.0f MB  estimated from %d matches",
+                ms * REPLACE_MATCHES / EDIT_MATCHES, (double)undoBytes * REPLACE_MATCHES / EDIT_MATCHES / MB(1), EDIT_MATCHES);
+
+    // Undo each edit so both replace the same text
+    while (curBuffer->undos.length > 0)
+        Undo();
+
+    char *patterns[] = {"value_", "\\vvalue_\\d+"};
+    for (int p = 0; p < 2; p++)
+    {
+        double start = BenchNow();
+        int count = ReplaceText(patterns[p], strlen(patterns[p]), "result_", 7, 0, curBuffer->numLines - 1, true);
+        double replaceMs = (BenchNow() - start) * 1e3;
+        EditorAction *a = &curBuffer->undos.undos[curBuffer->undos.length - 1];
+        int undoBytes = sizeof(EditorAction) + a->textLen;
+
+        start = BenchNow();
+        Undo();
+        double undoMs = (BenchNow() - start) * 1e3;
+
+        BenchReport(patterns[p], "%8.1f ms  undo %4.0f MB  %d matches, undo took %.1f ms",
+                    replaceMs, (double)undoBytes / MB(1), count, undoMs);
+    }
+
+    BenchEditorClose();
+}
+
+void BenchReplace()
+{
+    char *text = MemAlloc(MB(32));
+    int size = 0;
+
+    // Two matches on each line
+    for (int i = 0; i < REPLACE_MATCHES / 2; i++)
+        size += sprintf(text + size, "    value_%d = compute(value_%d, %d);\n", i % 1000, i % 37, i);
+    measureFile("500K lines of code", text, size);
+
+    // Minified data on a single line
+    size = 0;
+    for (int i = 0; i < REPLACE_MATCHES; i++)
+        size += sprintf(text + size, "{\"value_%d\":%d},", i % 1000, i % 37);
+    text[size++] = '\n';
+    measureFile("one 17 MB line", text, size);
+
+    MemFree(text);
+}
@@ -0,0 +1,326 @@
+#include "bench.h"
+
+extern Editor editor;
+
+#define TEXT_SIZE MB(64)
+#define NUM_PASSES 4
+
+// The loop find() used before: checks every byte against the first character
+// and compares the whole pattern on a hit.
+static char *oldFind(char *line, int length, char *search, int searchLen)
+{
+    char firstc = search[0];
+    for (int col = 0; col < length; col++)
+    {
+        char c = line[col];
+        if (c != firstc || col > length - searchLen)
+            continue;
+
+        bool found = true;
+        for (int i = 0; i < searchLen; i++)
+        {
+            if (line[col + i] != search[i])
+                found = false;
+        }
+
+        if (found)
+            return line + col;
+    }
+
+    return NULL;
+}
+
+int BenchMakeLog(char *text, int size, int **lineStarts, char *needle)
+{
+    char *levels[] = {"INFO", "DEBUG", "WARN", "TRACE"};
+    int numLines = 0;
+    int cap = 1024;
+    int *starts = MemAlloc(cap * sizeof(int));
+
+    int pos = 0;
+    for (int i = 0; pos < size - 256; i++)
+    {
+        if (numLines == cap)
+        {
+            cap *= 2;
+            starts = MemRealloc(starts, cap * sizeof(int));
+        }
+
+        starts[numLines++] = pos;
+        pos += sprintf(text + pos, "2024-03-%02d 12:%02d:%02d %s worker-%d: processed request %d for client %d in %d ms\n",
+                       i % 28 + 1, i % 60, (i * 7) % 60, levels[i % 4], i % 16, i, (i * 31) % 1000, i % 97);
+    }
+
+    starts[numLines++] = pos;
+    pos += sprintf(text + pos, "2024-03-28 12:00:00 ERROR worker-0: %s\n", needle);
+    starts[numLines] = pos;
+
+    *lineStarts = starts;
+    return numLines;
+}
+
+// Searches each line like find() does. Returns GB/s.
+static double measureLines(char *text, int *starts, int numLines, char *needle, int impl, bool ignoreCase)
+{
+    int length = strlen(needle);
+    Searcher s;
+    if (impl >= 0 && !SearchInitEx(&s, needle, length, ignoreCase, impl))
+        return 0;
+
+    int found = 0;
+    double start = BenchNow();
+
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (int i = 0; i < numLines; i++)
+        {
+            char *line = text + starts[i];
+            int lineLength = starts[i + 1] - starts[i];
+
+            char *match = impl >= 0 ? SearchFind(&s, line, lineLength) : oldFind(line, lineLength, needle, length);
+            found += match != NULL;
+        }
+    }
+
+    double elapsed = BenchNow() - start;
+    if (found != NUM_PASSES)
+        printf("  expected one match per pass, got %d\n", found / NUM_PASSES);
+
+    return (double)starts[numLines] * NUM_PASSES / elapsed / 1e9;
+}
+
+// Searches the text as one block. Returns GB/s.
+static double measureBlock(char *text, int size, char *needle, int impl, bool ignoreCase)
+{
+    Searcher s;
+    if (!SearchInitEx(&s, needle, strlen(needle), ignoreCase, impl))
+        return 0;
+
+    double start = BenchNow();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        if (SearchFind(&s, text, size) == NULL)
+            printf("  needle not found\n");
+    }
+
+    return (double)size * NUM_PASSES / (BenchNow() - start) / 1e9;
+}
+
+void BenchSearch()
+{
+    char *needles[] = {"connection refused", "fail"};
+    char *implNames[] = {"scalar", "sse2", "avx2"};
+    char *text = MemAlloc(TEXT_SIZE);
+
+    for (int n = 0; n < 2; n++)
+    {
+        int *starts;
+        int numLines = BenchMakeLog(text, TEXT_SIZE, &starts, needles[n]);
+        int size = starts[numLines];
+        printf("  \"%s\", %d lines\n", needles[n], numLines);
+
+        BenchReport("old loop, lines", "%6.2f GB/s", measureLines(text, starts, numLines, needles[n], -1, false));
+
+        for (int impl = SEARCH_SCALAR; impl <= SEARCH_AVX2; impl++)
+        {
+            for (int fold = 0; fold < 2; fold++)
+            {
+                char name[32];
+                sprintf(name, "%s%s, lines", implNames[impl], fold ? " ignore case" : "");
+                double lines = measureLines(text, starts, numLines, needles[n], impl, fold);
+                double block = measureBlock(text, size, needles[n], impl, fold);
+
+                if (lines == 0)
+                    BenchReport(name, "not supported");
+                else
+                    BenchReport(name, "%6.2f GB/s  %6.2f GB/s as one block", lines, block);
+            }
+        }
+
+        MemFree(starts);
+    }
+
+    MemFree(text);
+}
+
+#define FIND_LINES 2000000
+#define FIND_FILE "bench_find.txt"
+#define MAX_KEYS (MAX_SEARCH * 2)
+
+// Keys for the Find prompt. Given out one at a time when the prompt waits for
+// input, like a user typing the next key after seeing the result.
+static InputInfo keys[MAX_KEYS];
+static int numKeys = 0;
+static int nextKey = 0;
+
+static int readKeyWhenWaiting(InputInfo *events, int max, bool block)
+{
+    if (!block || max == 0 || nextKey == numKeys)
+        return 0;
+
+    events[0] = keys[nextKey++];
+    return 1;
+}
+
+static void addKey(KeyCode keyCode, char asciiChar)
+{
+    keys[numKeys++] = (InputInfo){.eventType = INPUT_KEYDOWN, .keyCode = keyCode, .asciiChar = asciiChar};
+}
+
+// Types query into the Find prompt one key at a time, then deletes it again.
+// Returns average ms per key for each half.
+static void typeQuery(char *query, double *typeMs, double *deleteMs)
+{
+    int length = strlen(query);
+    numKeys = nextKey = 0;
+    for (int i = 0; i < length; i++)
+        addKey(toupper(query[i]), query[i]);
+    addKey(K_ESCAPE, 27);
+
+    double start = BenchNow();
+    FindPrompt();
+    *typeMs = (BenchNow() - start) * 1e3 / length;
+
+    // Same query, then backspace all but the first character
+    numKeys = nextKey = 0;
+    for (int i = 0; i < length; i++)
+        addKey(toupper(query[i]), query[i]);
+    for (int i = 0; i < length - 1; i++)
+        addKey(K_BACKSPACE, 8);
+    addKey(K_ESCAPE, 27);
+
+    start = BenchNow();
+    FindPrompt();
+    double total = (BenchNow() - start) * 1e3;
+    *deleteMs = (total - *typeMs * length) / (length - 1);
+}
+
+// Queues the whole query and enter at once, so each key arrives while the
+// search for the previous one is running. Returns total ms.
+static double typeAhead(char *query)
+{
+    int length = strlen(query);
+    for (int i = 0; i < length; i++)
+    {
+        InputInfo key = {.eventType = INPUT_KEYDOWN, .keyCode = toupper(query[i]), .asciiChar = query[i]};
+        EditorQueueInput(key);
+    }
+
+    InputInfo enter = {.eventType = INPUT_KEYDOWN, .keyCode = K_ENTER, .asciiChar = '\r'};
+    EditorQueueInput(enter);
+
+    double start = BenchNow();
+    FindPrompt();
+    return (BenchNow() - start) * 1e3;
+}
+
+// Writes a log file of size bytes to path. Returns false on failure.
+static bool writeLog(char *path, int size)
+{
+    char *text = MemAlloc(size);
+    int *starts;
+    int numLines = BenchMakeLog(text, size, &starts, "request timeout after 30 s");
+
+    bool ok = IoWriteFile(path, text, starts[numLines]);
+    if (!ok)
+        printf("  failed to write %s\n", path);
+
+    MemFree(starts);
+    MemFree(text);
+    return ok;
+}
+
+void BenchFindPrompt()
+{
+    char *text = MemAlloc(MB(96));
+    int size = 0;
+    for (int i = 0; i < FIND_LINES; i++)
+        size += sprintf(text + size, "line %d: value_%d = compute(%d);\n", i, i % 1000, i % 37);
+    size += sprintf(text + size, "the needle_in_the_haystack is here\n");
+
+    if (!IoWriteFile(FIND_FILE, text, size))
+    {
+        printf("  failed to write %s\n", FIND_FILE);
+        MemFree(text);
+        return;
+    }
+    MemFree(text);
+
+    TermBackend backend = TermHeadlessBackend(NULL, 120, 40);
+    backend.readInput = readKeyWhenWaiting;
+    BenchEditorOpenEx(FIND_FILE, backend);
+    remove(FIND_FILE);
+    Render(); // Sets buffer size, which the prompt is sized by
+
+    char *query = "needle_in_the_haystack";
+    double typeMs, deleteMs;
+    typeQuery(query, &typeMs, &deleteMs);
+    BenchReport("typing", "%8.2f ms/key", typeMs);
+    BenchReport("backspace", "%8.2f ms/key", deleteMs);
+    BenchReport("type-ahead", "%8.2f ms for %d keys", typeAhead(query), (int)strlen(query));
+
+    BenchEditorClose();
+}
+
+#define THREADS_FILE "bench_threads.txt"
+#define THREADS_SIZE MB(128)
+
+// Time to find all matches in the buffer with the given number of threads.
+// Returns ms.
+static double measureBuild(char *word, int workers)
+{
+    WorkerSetCount(workers);
+    double start = BenchNow();
+    MatchIndexBuild(curBuffer, word, strlen(word));
+    return (BenchNow() - start) * 1e3;
+}
+
+void BenchSearchThreads()
+{
+    if (!writeLog(THREADS_FILE, THREADS_SIZE))
+        return;
+
+    BenchEditorOpen(THREADS_FILE, 120, 40);
+    remove(THREADS_FILE);
+
+    int cpus = CpuCount();
+    printf("  %d lines, %d CPUs\n", curBuffer->numLines, cpus);
+
+    char *words[] = {"request timeout", "request timeout\\c", "\\v(ERROR|FATAL) worker-\\d+"};
+    for (int w = 0; w < 3; w++)
+    {
+        double single = 0;
+        for (int n = 1;; n = min(n * 2, cpus))
+        {
+            double ms = measureBuild(words[w], n);
+            if (n == 1)
+                single = ms;
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s, %d threads", words[w], n);
+            BenchReport(name, "%8.2f ms  %6.2f GB/s  %5.2fx", ms, THREADS_SIZE / ms / 1e6, single / ms);
+
+            if (n == cpus)
+                break;
+        }
+    }
+
+    // Word on every 16th line, from the middle of the buffer
+    WorkerSetCount(0);
+    char *word = "worker-3:";
+    CursorPos from = {.row = curBuffer->numLines / 2};
+
+    double start = BenchNow();
+    MatchIndexStart(curBuffer, word, strlen(word), from);
+
+    Match m;
+    while (!MatchIndexFirst(curBuffer, &m) && !MatchIndexWait(curBuffer, 1))
+        ;
+    double first = BenchNow() - start;
+    MatchIndexWait(curBuffer, -1);
+    double all = BenchNow() - start;
+
+    BenchReport("first match from middle", "%8.2f ms  all %d matches %.2f ms", first * 1e3, curBuffer->matches.count, all * 1e3);
+
+    BenchEditorClose();
+}
@@ -0,0 +1,160 @@
+// Runs the editor on a pseudo terminal in a child process, using the POSIX
+// backend, and measures the time until each frame arrives. Frames are written
+// with synchronized output so the end of a frame can be found in the output.
+
+#include "bench.h"
+
+#define WIDTH 120
+#define HEIGHT 40
+#define NUM_LOADS 100
+#define NUM_KEYS 400
+#define TIMEOUT_MS 2000
+#define FILEPATH "src/buffer/buffer.c"
+
+extern Config config;
+extern Colors colors;
+
+#ifdef _WIN32
+
+void BenchStartup()
+{
+    printf("  only supported on POSIX systems\n");
+}
+
+#else
+
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define FRAME_END "\x1b[?2026l" // SYNC_END, last sequence in a frame that draws
+
+static int master = -1; // Pseudo terminal connected to the editor
+
+// Main loop of the editor, runs in the child process until ctrl-q.
+static void runEditor()
+{
+    config.syncOutput = true;
+    BenchEditorOpenEx(FILEPATH, TermPosixBackend());
+
+    Render();
+    while (EditorHandleInput() == NIL)
+        Render();
+
+    exit(EXIT_SUCCESS);
+}
+
+// Reads editor output until the end of a frame. Returns false on timeout.
+static bool waitFrame()
+{
+    static int matched = 0; // Length of FRAME_END matched so far
+    int length = strlen(FRAME_END);
+    char buf[KB(16)];
+
+    while (true)
+    {
+        struct pollfd pfd = {.fd = master, .events = POLLIN};
+        if (poll(&pfd, 1, TIMEOUT_MS) <= 0)
+            return false;
+
+        int n = read(master, buf, sizeof(buf));
+        if (n <= 0)
+            return false;
+
+        for (int i = 0; i < n; i++)
+        {
+            if (buf[i] == FRAME_END[matched])
+                matched++;
+            else
+                matched = buf[i] == FRAME_END[0];
+
+            // The editor waits for the next key after a frame, so this is the last byte
+            if (matched == length)
+            {
+                matched = 0;
+                return true;
+            }
+        }
+    }
+}
+
+// Sends keys one at a time and waits for the frame each of them draws.
+static bool measureKeys(char *name, char *keys[2])
+{
+    double total = 0;
+    double slowest = 0;
+
+    for (int i = 0; i < NUM_KEYS; i++)
+    {
+        // Changes direction every 20 keys so every key moves the view
+        char *key = keys[(i / 20) % 2];
+
+        double start = BenchNow();
+        if (write(master, key, strlen(key)) == -1 || !waitFrame())
+        {
+            printf("  no frame after key %d\n", i);
+            return false;
+        }
+
+        double elapsed = BenchNow() - start;
+        total += elapsed;
+        slowest = max(slowest, elapsed);
+    }
+
+    BenchReport(name, "%8.1f us avg  %8.1f us max", total * 1e6 / NUM_KEYS, slowest * 1e6);
+    return true;
+}
+
+void BenchStartup()
+{
+    // Languages are only loaded once, so they are not part of this
+    double start = BenchNow();
+    for (int i = 0; i < NUM_LOADS; i++)
+    {
+        LoadConfig(&config);
+        LoadTheme(config.theme, &colors);
+    }
+    BenchReport("config and theme", "%8.1f us", (BenchNow() - start) * 1e6 / NUM_LOADS);
+
+    // Child gets a copy of anything left in the stdout buffer
+    fflush(stdout);
+
+    struct winsize size = {.ws_col = WIDTH, .ws_row = HEIGHT};
+    start = BenchNow();
+
+    pid_t pid = forkpty(&master, NULL, NULL, &size);
+    if (pid == -1)
+    {
+        printf("  failed to open pseudo terminal\n");
+        return;
+    }
+    if (pid == 0)
+        runEditor();
+
+    bool ok = waitFrame();
+    if (ok)
+        BenchReport("first frame", "%8.1f us", (BenchNow() - start) * 1e6);
+    else
+        printf("  no first frame\n");
+
+    char *arrows[2] = {"\x1b[B", "\x1b[A"};
+    char *blocks[2] = {"J", "K"};
+
+    ok = ok && measureKeys("cursor movement", arrows);
+    ok = ok && measureKeys("next/prev blank line", blocks);
+
+    if (ok)
+    {
+        char quit = 'q' - 96; // ctrl-q
+        ok = write(master, &quit, 1) == 1;
+    }
+    if (!ok)
+        kill(pid, SIGKILL);
+
+    waitpid(pid, NULL, 0);
+    close(master);
+}
+
+#endif
@@ -0,0 +1,114 @@
+#include "bench.h"
+
+#define NUM_LINES 20000
+#define NUM_PASSES 10
+#define LINE_SIZE 256
+
+// Writes a line of typical looking code for lang to dest. Returns length.
+static int makeLine(Language *lang, int i, char *dest)
+{
+    Keyword k = lang->keywords[i % max(lang->numKeywords, 1)];
+    int indent = (i % 4) * 4;
+
+    int length = sprintf(dest, "%*s%.*s value_%d = call_%d(%d.%d, \"text %d\", other) + x%d;",
+                         indent, "", k.length, k.word, i, i % 97, i, i % 10, i, i % 13);
+
+    if (i % 4 == 0 && strlen(lang->comment) > 0)
+        length += sprintf(dest + length, " %s trailing comment %d", lang->comment, i);
+
+    return length;
+}
+
+// Highlights all lines with lang. Returns MB/s and writes ns per line.
+static double measure(Language *lang, char lines[][LINE_SIZE], int *lengths, double *nsPerLine)
+{
+    Buffer *b = BufferNew();
+    b->lang = lang;
+
+    long long bytes = 0;
+    double start = BenchNow();
+
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        b->hlState = LEX_NORMAL;
+        for (int i = 0; i < NUM_LINES; i++)
+        {
+            HlLine line = {
+                .line = lines[i],
+                .length = lengths[i],
+                .rawLength = lengths[i],
+                .row = i,
+            };
+
+            ColorLine(b, line);
+            bytes += lengths[i];
+        }
+    }
+
+    double elapsed = BenchNow() - start;
+    BufferFree(b);
+    *nsPerLine = elapsed * 1e9 / ((double)NUM_LINES * NUM_PASSES);
+    return (double)bytes / elapsed / MB(1);
+}
+
+void BenchSyntax()
+{
+    static char lines[NUM_LINES][LINE_SIZE];
+    static int lengths[NUM_LINES];
+
+    int numLanguages = SyntaxNumLanguages();
+    if (numLanguages == 0)
+    {
+        printf("  no languages loaded\n");
+        return;
+    }
+
+    for (int l = 0; l < numLanguages; l++)
+    {
+        Language *lang = SyntaxGetLanguage(l);
+        for (int i = 0; i < NUM_LINES; i++)
+            lengths[i] = makeLine(lang, i, lines[i]);
+
+        double nsPerLine;
+        double mbs = measure(lang, lines, lengths, &nsPerLine);
+        BenchReport(lang->name, "%8.1f MB/s  %6.0f ns/line  %3d keywords", mbs, nsPerLine, lang->numKeywords);
+    }
+
+    // Same text with a language that has the maximum number of keywords,
+    // lookup cost should not depend on the size of the keyword table.
+    Language *base = SyntaxGetLanguage(0);
+    Language big = *base;
+
+    char words[SYNTAX_MAX_KEYWORDS][SYNTAX_WORD_SIZE];
+    byte kinds[SYNTAX_MAX_KEYWORDS];
+    int n = 0;
+
+    for (; n < base->numKeywords; n++)
+    {
+        memcpy(words[n], base->keywords[n].word, SYNTAX_WORD_SIZE);
+        kinds[n] = base->keywords[n].kind;
+    }
+    for (; n < SYNTAX_MAX_KEYWORDS; n++)
+    {
+        sprintf(words[n], "keyword_%d", n);
+        kinds[n] = WORD_KEYWORD;
+    }
+
+    if (!SyntaxCompileKeywords(&big, words, kinds, n))
+    {
+        printf("  failed to compile keyword table\n");
+        return;
+    }
+
+    for (int i = 0; i < NUM_LINES; i++)
+        lengths[i] = makeLine(base, i, lines[i]);
+
+    double baseNs, bigNs;
+    double baseMbs = measure(base, lines, lengths, &baseNs);
+    double bigMbs = measure(&big, lines, lengths, &bigNs);
+    BenchReport(base->name, "%8.1f MB/s  %6.0f ns/line  %3d keywords", baseMbs, baseNs, base->numKeywords);
+    BenchReport(base->name, "%8.1f MB/s  %6.0f ns/line  %3d keywords", bigMbs, bigNs, big.numKeywords);
+
+    MemFree(big.keywords);
+    MemFree(big.slots);
+}
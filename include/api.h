@@ -53,6 +53,79 @@ CursorPos FindNext(char *search, int length);
 // Returns prev instance of search term in file from current cursor position
 CursorPos FindPrev(char *search, int length);
 
+// Starts searching all files under dir for pattern on worker threads. Lines
+// starting with \v are a regex and \c and \C set the case, like in
+// FindPrompt. Returns NULL if the pattern is empty or not a valid regex. Free
+// with GrepFree.
+Grep *GrepStart(char *pattern, int length, char *dir);
+// Appends "path:row:col: text" lines for files searched since the last call to
+// b, in the order the files were found. exPaths of b must be initialized.
+// Returns true when all files are searched or the search was stopped.
+bool GrepRead(Grep *g, Buffer *b);
+GrepStats GrepGetStats(Grep *g);
+// Stops the search if it is still running and frees it.
+void GrepFree(Grep *g);
+// Opens the file on the current line of grep results at the match. Returns
+// false if the line is not a result.
+bool GrepJump();
+
+// Starts listing all files under dir on a thread, for FinderQuery. Hidden
+// files and directories are skipped. Free with FinderFree.
+Finder *FinderStart(char *dir);
+// Writes the number of files listed so far to numFiles. Returns true when all
+// files are listed.
+bool FinderDone(Finder *f, int *numFiles);
+// Ranks the files listed so far by how well their path matches query, in order
+// with gaps allowed, like fzf. Case is ignored unless the query has an
+// uppercase letter. Writes paths relative to dir of the best FINDER_MAX_RESULTS
+// files to results, best first, and their number to numResults. Paths are
+// valid until FinderFree. Returns the number of files that match.
+int FinderQuery(Finder *f, char *query, int length, char **results, int *numResults);
+// Stops listing if it is still running and frees the finder.
+void FinderFree(Finder *f);
+// Prompts for a file under the working directory, showing the best matches
+// of the typed query, and opens the chosen one.
+void FinderPrompt();
+
+// Starts listing the directory at the absolute path dir on a reader thread.
+// Returns a finished listing if dir has not changed since it was last listed.
+// Free with DirListFree.
+DirList *DirListStart(char *dir);
+// Appends explorer rows for entries listed since the last call to the end of
+// b. When the listing is done the rows are replaced by all entries sorted,
+// directories first. exPaths of b must be initialized. Returns true when done.
+bool DirListRead(DirList *l, Buffer *b);
+// Stops listing. The next DirListRead sorts the entries listed so far.
+void DirListStop(DirList *l);
+// Frees the listing. Finished listings are kept for DirListStart.
+void DirListFree(DirList *l);
+
+// Writes a trigram index of the files under dir to INDEX_FILENAME in dir, or
+// updates it if there is one. Only files that changed are read. Writes stats
+// if not NULL. Returns false if the index could not be written.
+bool IndexBuild(char *dir, IndexStats *stats);
+// Loads the index of dir. Returns NULL if there is none or it is not valid.
+TrigramIndex *IndexLoad(char *dir);
+void IndexFree(TrigramIndex *idx);
+int IndexNumFiles(TrigramIndex *idx);
+// Returns the number of the file at path, relative to the indexed directory,
+// or -1 if it is not in the index or changed since it was indexed.
+int IndexFindFile(TrigramIndex *idx, const char *path, long long size, long long modified);
+// Returns an array of IndexNumFiles flags set for files that may contain
+// text, ignoring case. NULL if text is too short to tell. Free the array.
+bool *IndexQuery(TrigramIndex *idx, const char *text, int length);
+
+// Replaces matches of search with replace on rows from to to, inclusive. Only
+// the first match on each line is replaced unless all is true. A search
+// starting with \v is a regex, \c and \C set the case like in FindPrompt.
+// Undone as one action. Returns number of replacements, -1 if the regex is
+// not valid.
+int ReplaceText(char *search, int searchLen, char *replace, int replaceLen, int from, int to, bool all);
+// Runs a substitute command: [range]s/old/new/[g]. The range is % for all
+// lines, or line numbers like 10,20, where . is the cursor row and $ the last
+// row. Returns false if cmd is not a substitute command.
+bool ReplaceCommand(char *cmd);
+
 // Pastes OS clipboard text at current cursor pos
 void PasteFromClipboard();
 void CopyToClipboard();
@@ -15,6 +15,9 @@ void BufferDeleteEx(Buffer *buf, int row, int col, int count);
 // Inserts new line at row. If row is -1 line is appended to end of file. Returns new line.
 Line *BufferInsertLine(Buffer *buf, int row);
 Line *BufferInsertLineEx(Buffer *b, int row, char *text, int textLen);
+// Replaces the text of row with chars, which the buffer takes ownership of.
+// chars must be zero filled up to cap. Returns the old text, free with MemFree.
+char *BufferSwapLine(Buffer *b, int row, char *chars, int length, int cap);
 // Deletes line at row and move all lines below upwards.
 void BufferDeleteLine(Buffer *buf, int row);
 // Copies and removes all characters behind the cursor position,
@@ -46,15 +49,53 @@ char *BufferGetMarkedText(Buffer *b);
 char *BufferGetLinePath(Buffer *b, Line *line);
 // Sets current search word in buffer. NULL is accepted.
 void BufferSetSearchWord(Buffer *b, char *search, int length);
-// Marks part of a line with yellow background for search.
-void BufferMarkLine(Buffer *b, int row, int col, int length);
-// Unmarks all lines after a search.
-void BufferUnmarkAll(Buffer *b);
 // Sets filename for buffer and marks it as an open file
 void BufferSetFilename(Buffer *b, char *filepath);
 // Sets filetype for buffer. Only affects syntax hl. Returns true if set successfully.
 bool BufferSetFileType(Buffer *b, const char *extension);
 
+// Makes sure the render cache can hold numRows rows.
+void LineCacheReserve(Buffer *b, int numRows);
+// Returns cached render of row if it was rendered with the same key, otherwise NULL.
+LineCacheEntry *LineCacheGet(Buffer *b, int row, LineCacheKey *key);
+// Stores the final colored bytes of row.
+void LineCachePut(Buffer *b, int row, LineCacheKey *key, char *data, int length, int stateOut);
+void LineCacheFree(Buffer *b);
+
+// Finds all matches of search in the buffer. Length 0 clears the index.
+void MatchIndexBuild(Buffer *b, char *search, int length);
+// Starts finding all matches of search on worker threads, beginning at from. The
+// buffer must not change until MatchIndexWait returns true or the index is cleared.
+void MatchIndexStart(Buffer *b, char *search, int length, CursorPos from);
+// Waits up to ms for the search to finish, forever if negative. Returns true
+// when all matches are in the index.
+bool MatchIndexWait(Buffer *b, int ms);
+// Writes the first match at or after from to m, wrapping around, while the
+// search is still running. Returns false if it is not known yet.
+bool MatchIndexFirst(Buffer *b, Match *m);
+// Keeps only the matches of search, which must start with the current search word.
+void MatchIndexNarrow(Buffer *b, char *search, int length);
+// Removes all matches and the search word. Stops a running search.
+void MatchIndexClear(Buffer *b);
+// Removes the matches but keeps the search word, so many rows can be changed
+// without updating the index for each. Returns the length to resume with.
+int MatchIndexPause(Buffer *b);
+// Searches the buffer again for the word it had before MatchIndexPause.
+void MatchIndexResume(Buffer *b, int length);
+// Searches row again after it was edited.
+void MatchIndexUpdateRow(Buffer *b, int row);
+// Moves matches down after a line was inserted at row, and searches it.
+void MatchIndexInsertRow(Buffer *b, int row);
+// Removes matches on row and moves the ones below up.
+void MatchIndexDeleteRow(Buffer *b, int row);
+// Returns index of first match at or after row/col, count if there is none.
+int MatchIndexLowerBound(Buffer *b, int row, int col);
+// Searches row for the search word without the index, so rows can be marked
+// while the index is built. Writes number of matches to count. The matches are
+// valid until the next call.
+Match *MatchIndexSearchRow(Buffer *b, int row, int *count);
+void MatchIndexFree(Buffer *b);
+
 // Sets cursor position in buffer space, scrolls if necessary. keepX is true when the cursor
 // should keep the current max width when moving vertically, only really used with CursorMove.
 void CursorSetPos(Buffer *buf, int x, int y, bool keepX);
@@ -6,6 +6,10 @@ typedef struct CmdOptions
     bool hasFile;
     bool rawMode;
     char filename[MAX_PATH];
+
+    bool headless;         // Use the headless terminal
+    char script[MAX_PATH]; // Key script for headless terminal
+    int width, height;     // Size of headless terminal
 } CmdOptions;
 
 CmdOptions ProcessArgs(int argc, char **argv);
\ No newline at end of file
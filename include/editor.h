@@ -12,7 +12,7 @@ void EditorInit(CmdOptions options);
 void EditorFree();
 // Sets editor input mode
 void EditorSetMode(InputMode mode);
-// Waits for input and takes action for insert mode.
+// Waits for input and handles all pending input events before returning.
 Error EditorHandleInput();
 // Loads file into buffer. Filepath must either be an absolute path
 // or name of a file in the same directory as working directory.
@@ -21,6 +21,8 @@ Error EditorOpenFile(char *filepath);
 Error EditorSaveFile();
 // Loads help text into a new buffer and displays it.
 void EditorShowHelp();
+// Returns pointer to at least length space characters. Only valid until next call.
+char *EditorPadding(int length);
 // Returns index of new buffer
 int EditorNewBuffer();
 // Splits buffers, setting the right to an empty buffer
@@ -35,11 +37,23 @@ void EditorCloseBuffer(int idx);
 // Opens tab selection menu
 void EditorPromptTabSwap();
 // Hangs when waiting for input. Returns error if read failed. Writes to info.
+// Flushes the screen before waiting when there are no pending events.
 Error EditorReadInput(InputInfo *info);
+// Returns true if there are input events waiting to be read.
+bool EditorHasInput();
+// Writes the next input event to info without removing it. Returns false if
+// there is none.
+bool EditorPeekInput(InputInfo *info);
+// Adds event to the end of the input queue. Resize events are dropped if one
+// is already queued. Returns false if the queue is full.
+bool EditorQueueInput(InputInfo info);
 // Opens a new read-only folder buffer in the same directory as the current open file,
 // or the workspace root if no file is open. Sets the input mode to MODE_EXPLORE.
 void EditorOpenFileExplorer();
 void EditorOpenFileExplorerEx(char *directory);
+// Searches files under dir for pattern and lists matching lines in a read-only
+// buffer, which replaces the current one. Results jump to the match on enter.
+void EditorGrep(char *pattern, char *dir);
 // Prompts user for command input
 void EditorPromptCommand();
 
@@ -61,6 +75,8 @@ Error HandleExploreMode(InputInfo *info);
 Error LoadConfig(Config *config);
 // Loads theme data into colors. Returns false on failure.
 Error LoadTheme(char *name, Colors *colors);
+// Loads and compiles all language definitions in config/syntax.
+Error LoadLanguages();
 // Looks for files in the directory of the executable, eg. config, runtime etc.
 // Returns pointer to file data, NULL on error. Writes to size. Remember to free!
 char *ReadConfigFile(const char *file, int *size);
@@ -73,10 +89,33 @@ void UndoSaveAction(Action type, char *text, int textLen);
 void UndoSaveActionEx(Action type, int row, int col, char *text, int textLen);
 // Joins last n actions under same undo call.
 void UndoJoin(int n);
+// Appends the text of row before it is changed to lines.
+void UndoAddLine(UndoLines *lines, int row, char *text, int length);
+// Saves lines as one undo that restores all of them and sets the cursor to
+// row/col. Takes ownership of the lines data.
+void UndoSaveLines(UndoLines *lines, int row, int col);
 
+// Initializes terminal using backend. Returns error on failure.
+Error TermInit(TermBackend backend);
+void TermFree();
 // Updates terminal buffer size to fill windows. Sets values to editor.
 void TermUpdateSize();
-// Sets cursor position in terminal
-void TermSetCursorPos(int x, int y);
-void TermSetCursorVisible(bool visible);
-void TermWrite(char *string, int length);
\ No newline at end of file
+void TermWrite(char *string, int length);
+// Reads up to max input events into events. Waits for at least one event if
+// block is true. Returns number of events read, -1 on error.
+int TermReadInput(InputInfo *events, int max, bool block);
+
+// Returns key down event for ascii character c, with the key code the console reports.
+InputInfo TermCharEvent(char c);
+
+// Win32 console backend.
+TermBackend TermConsoleBackend();
+// POSIX terminal backend using termios raw mode and the alternate screen.
+TermBackend TermPosixBackend();
+// Renders to an in-memory terminal and reads keys from script file, or nothing if
+// script is NULL. Prints a report and exits when the script has been read.
+TermBackend TermHeadlessBackend(char *script, int width, int height);
+// Prints frame stats and contents of the headless terminal to stdout.
+void HeadlessReport();
+// Returns row y of the headless terminal screen, not NULL terminated.
+char *HeadlessRow(int y);
\ No newline at end of file
@@ -10,9 +10,14 @@
 
 #define KB(n) ((n) * 1024)       // n kilobytes
 #define MB(n) (KB(n) * 1024)     // n megabytes
-#define RENDER_BUFFER_SIZE MB(1) // Constant max size of buffer used for rendering
+#define CB_CHUNK_SIZE KB(64)     // CharBuf stores grow in multiples of this size
 
-#define SYNTAX_NAME_LEN 16         // Length of extension name in syntax file
+#define SYNTAX_NAME_LEN 16         // Length of language name in syntax file
+#define SYNTAX_WORD_SIZE 32        // Max size of keyword in syntax file, including NULL
+#define SYNTAX_MAX_EXTENSIONS 8    // Max number of file extensions per language
+#define SYNTAX_MAX_PREFIXES 4      // Max number of object prefixes per language
+#define SYNTAX_MAX_LANGUAGES 32    // Max number of loaded languages
+#define SYNTAX_MAX_KEYWORDS 256    // Max number of keywords and types per language
 #define THEME_NAME_LEN 32          // Length of name in theme file
 #define DEFAULT_TAB_SIZE 4         // Defaults to this if config not found
 #define BUFFER_DEFAULT_LINE_CAP 32 // Buffers are created with this defualt cap
@@ -22,14 +27,24 @@
 #define SYNTAX_COMMENT_SIZE 8      // Max size of comment string
 #define FILE_EXTENSION_SIZE 16     // Max length of file extension name
 #define MAX_PATH 260               // Windows specific but used anyway
-#define MAX_SEARCH 64              // Max search string in buffer
+#define MAX_SEARCH 256             // Max search string in buffer
+#define GREP_MAX_RESULTS 100000    // Max matching lines shown by :grep
+#define INDEX_FILENAME ".rumindex" // Trigram index written by :index in the indexed directory
+#define BINARY_CHECK KB(8)         // Files with a zero byte this close to the start are binary
+#define FINDER_MAX_RESULTS 100     // Best matches kept by the file finder
+#define MAX_WORKERS 64             // Max threads one search, grep, index or finder job runs on
 #define MAX_ARGS 16                // Maximum arg count for editor command
 #define COLOR_SIZE 13              // Size of a color string including NULL
 #define COLOR_BYTE_LENGTH 19       // Number of bytes in a color sequence
 #define EDITOR_BUFFER_CAP 16       // Max number of buffers that can be open at one time, not dymamic
-#define PAD_BUFFER_SIZE 512        // Size of padding buffer
+#define PAD_BUFFER_SIZE 512        // Initial size of padding buffer, grows when needed
+#define INPUT_QUEUE_SIZE 512       // Max number of input events waiting to be handled
+#define GUTTER_MIN_DIGITS 4        // Line numbers are padded to at least this many digits
+#define HEADLESS_WIDTH 120         // Default size of headless terminal
+#define HEADLESS_HEIGHT 40         //
 
 #define RUM_CONFIG_FILEPATH "config/config.json"
+#define RUM_SYNTAX_DIR "config/syntax"
 #define RUM_DEFAULT_THEME "gruvbox"
 
 typedef enum Error
@@ -43,8 +58,14 @@ typedef enum Error
     ERR_INPUT_READ_FAIL,
 } Error;
 
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <limits.h>
+#endif
+
 #include <stdbool.h>
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -6,9 +6,40 @@ void Render();
 // Sets command line error message. NULL for no message.
 void SetError(char *error);
 
+// Output counters, updated by ScreenFlush.
+typedef struct ScreenStats
+{
+    int frames;           // Number of flushes that wrote to the terminal
+    int writes;           // Number of terminal writes
+    long long bytesIn;    // Bytes drawn to the screen grid
+    long long bytesOut;   // Bytes written to the terminal
+    int lastFrameIn;      // Bytes drawn since the previous flush
+    int lastFrameOut;     // Bytes written by the last flush
+} ScreenStats;
+
+// Draws to the screen grid at the current position. Colors escapes are parsed
+// and set the current colors. Nothing is written to the terminal until flushed.
 void ScreenWrite(char *string, int length);
 void ScreenWriteAt(int x, int y, char *text);
 void ScreenColor(char *bg, char *fg);
 void ScreenColorReset();
 void ScreenBg(char *col);
 void ScreenFg(char *col);
+// Sets the draw position. The terminal cursor is put here on flush.
+void ScreenSetPos(int x, int y);
+void ScreenSetCursorVisible(bool visible);
+// Writes all cells that changed since the last flush, the cursor position
+// and visibility to the terminal in a single write.
+void ScreenFlush();
+// Scrolls rows top to bottom (inclusive) up by n rows, or down if n is negative.
+// The terminal scrolls the region on next flush, so only exposed rows need to be
+// written. Rows keep their content, drawing the new frame as usual is still required.
+void ScreenScroll(int top, int bottom, int n);
+// Redraws the whole screen on next flush.
+void ScreenInvalidate();
+ScreenStats ScreenGetStats();
+
+// Returns index of nearest color in the 256 or 16 color palette. Rgb is 0xRRGGBB.
+int ScreenColorIndex(unsigned rgb, ColorDepth depth);
+// Returns the palette color nearest to rgb as 0xRRGGBB. Bits above the color are kept.
+unsigned ScreenQuantizeColor(unsigned rgb, ColorDepth depth);
@@ -1,27 +1,5 @@
 #pragma once
 
-#define MAX_TOKEN_WORD 128
-
-typedef struct SyntaxToken
-{
-    bool isSymbol;
-    bool isWord;
-    bool isNumber;
-    bool isString;
-    bool eof;
-
-    char word[MAX_TOKEN_WORD];
-    int wordLength;
-    int pos;
-} SyntaxToken;
-
-typedef struct LineIterator
-{
-    const char *line;
-    int lineLength;
-    int pos;
-} LineIterator;
-
 typedef struct HlLine
 {
     char *line;    // Line pointer, must not be freed
@@ -31,16 +9,12 @@ typedef struct HlLine
     bool isCurrentLine;
 } HlLine;
 
-// Creates new iterator to use when looping over tokens in line
-LineIterator NewLineIterator(const char *line, int lineLength);
-
-// Gets next 'token' in line. Either an ascii word string or a single symbol.
-// Returns token with eof set to true on end of line.
-SyntaxToken GetNextToken(LineIterator *iter);
-
-// Returns true if sequence was found, and also keeps iteration made to iter.
-// Otherwise iteration is reset to where it was.
-bool MatchSymbolSequence(LineIterator *iter, char *sequence);
+// Lexer state carried over from one line to the next.
+typedef enum LexState
+{
+    LEX_NORMAL,
+    LEX_BLOCK_COMMENT,
+} LexState;
 
 // Returns pointer to highlight buffer. Must NOT be freed. Line is the
 // pointer to the line contents and the length is excluding the NULL
@@ -53,8 +27,22 @@ HlLine HighlightLine(Buffer *b, HlLine line);
 // Marks part of line for things like search. Only call if buffer line enables it.
 HlLine MarkLine(HlLine line, int start, int end);
 
-// Language highlighters
-
-void langC(HlLine line, LineIterator *iter, CharBuf *cb);
-void langPy(HlLine line, LineIterator *iter, CharBuf *cb);
-void langJson(HlLine line, LineIterator *iter, CharBuf *cb);
\ No newline at end of file
+// Resets lang and sets the default character classes for words and numbers.
+void SyntaxInitLanguage(Language *lang);
+// Adds class to all characters in chars.
+void SyntaxSetCharClass(Language *lang, const char *chars, CharClass class);
+// Builds the perfect hash table for the given words. Duplicates are ignored.
+// Returns false if no collision free table could be made.
+bool SyntaxCompileKeywords(Language *lang, char words[][SYNTAX_WORD_SIZE], byte *kinds, int numWords);
+// Finishes compiling lang and adds it to the list of languages. Returns false if full.
+bool SyntaxAddLanguage(Language *lang);
+// Returns language with the given file extension or name. NULL if not found.
+Language *SyntaxFindLanguage(const char *extension);
+// Returns kind of word if it is a keyword or type name in lang.
+WordKind SyntaxLookupWord(Language *lang, const char *word, int length);
+int SyntaxNumLanguages();
+Language *SyntaxGetLanguage(int idx);
+
+// Shared lexer for all languages. Appends the colored line to cb. State is the
+// lexer state at the beginning of the line and is updated to the state at the end.
+void SyntaxColorLine(Language *lang, HlLine line, CharBuf *cb, int *state);
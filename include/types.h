@@ -18,6 +18,22 @@ typedef struct CursorPos
 
 typedef unsigned char byte;
 
+// Color escapes written to the terminal.
+typedef enum ColorDepth
+{
+    COLOR_DEPTH_TRUE, // 24-bit rgb colors
+    COLOR_DEPTH_256,  // xterm 256 color palette
+    COLOR_DEPTH_16,   // Basic 16 colors
+} ColorDepth;
+
+// How search words without \c or \C match letters.
+typedef enum SearchCase
+{
+    SEARCH_CASE_EXACT,  // Case must match
+    SEARCH_CASE_IGNORE, // Any case matches
+    SEARCH_CASE_SMART,  // Any case, unless the word has an uppercase letter
+} SearchCase;
+
 // Editor configuration loaded from config file. Editor must be reloaded for all
 // changes to take effect. Config is global and affects all buffers.
 typedef struct Config
@@ -27,6 +43,10 @@ typedef struct Config
     bool useCRLF;               // Use CRLF line endings. (NOT IMPLEMENTED)
     byte tabSize;               // Amount of spaces a tab equals
     char theme[THEME_NAME_LEN]; // Default theme
+    bool syncOutput;            // Wrap frames in synchronized update sequences
+    ColorDepth colorDepth;      // Theme colors are quantized to this palette
+    bool relativeNumbers;       // Line numbers are relative to the cursor row
+    SearchCase searchCase;      // Case matching of search words
 
     // Set by command line options
 
@@ -46,6 +66,7 @@ typedef enum Action
     A_DELETE_LINE, // Delete line only
     A_INSERT_LINE, // Insert line only
     A_OVERWRITE,   // Overwriting text
+    A_LINES,       // Restore the text of many lines, see UndoSaveLines
 } Action;
 
 // Object representing an executable action by the editor (write, delete, etc).
@@ -73,6 +94,15 @@ typedef struct UndoList
     EditorAction *undos;
 } UndoList;
 
+// Old text of lines changed by one command. Each line is stored as its row and
+// length followed by the text.
+typedef struct UndoLines
+{
+    char *data;
+    int length;
+    int cap;
+} UndoLines;
+
 #define COL_RESET "\x1b[0m"
 #define COL_HL "135;138;000"
 
@@ -81,6 +111,7 @@ typedef struct UndoList
 typedef struct Colors
 {
     char name[32];
+    int version;               // Incremented every time a theme is loaded
     char bg0[COLOR_SIZE];      // Editor background
     char bg1[COLOR_SIZE];      // Statusbar and current line bg
     char bg2[COLOR_SIZE];      // Comments, line numbers
@@ -96,6 +127,17 @@ typedef struct Colors
     char userType[COLOR_SIZE]; // User defined type/macro
 } Colors;
 
+#define CELL_COLOR_SET (1 << 24) // Set for colors that are not the terminal default
+
+// Single character on screen with its colors. Colors are packed as 0xRRGGBB
+// with CELL_COLOR_SET, or 0 for the terminal default color.
+typedef struct Cell
+{
+    unsigned fg;
+    unsigned bg;
+    char ch;
+} Cell;
+
 // Event types for InputInfo object.
 typedef enum InputEventType
 {
@@ -133,6 +175,20 @@ typedef struct InputInfo
     bool ctrlDown;
 } InputInfo;
 
+// Terminal implementation used by the Term functions. Selected at startup.
+typedef struct TermBackend
+{
+    char *name;
+    Error (*init)();
+    void (*free)();
+    // Writes current size of terminal to width and height.
+    void (*getSize)(int *width, int *height);
+    void (*write)(char *string, int length);
+    // Reads up to max events. Waits for at least one if block is true.
+    // Returns number of events read, -1 on error.
+    int (*readInput)(InputInfo *events, int max, bool block);
+} TermBackend;
+
 // Each buffer has a cursor object attached to it. The cursor essentially holds
 // a pointer to the text to be edited in the Buffer as well as were to place the
 // cursor on-screen.
@@ -155,10 +211,7 @@ typedef struct Line
     int length;
     int indent; // Updated on cursor movement
     char *chars;
-
-    bool isMarked; // By search
-    int hlStart;
-    int hlEnd;
+    unsigned version; // Unique stamp, changes on every edit of the line
 
     // These fields are used when a buffer is open as directory in the explorer
     bool isPath;  // Is this a directory entry in explorer?
@@ -166,32 +219,177 @@ typedef struct Line
     int exPathId; // Id to StrArray in buffer with the filename
 } Line;
 
-// All filetypes recognized by the editor and
-// with syntax highlighting available.
-typedef enum FileType
+// Character classes used by the shared lexer. Each language compiles its
+// definition into a 256 entry table of these flags.
+typedef enum CharClass
+{
+    CC_WORD_START = 1 << 0, // Can start a word
+    CC_WORD = 1 << 1,       // Can be part of a word
+    CC_DIGIT = 1 << 2,      // Starts a number
+    CC_NUMBER = 1 << 3,     // Can be part of a number
+    CC_STRING = 1 << 4,     // String delimiter
+    CC_BRACKET = 1 << 5,    // Bracket or separator
+    CC_SYMBOL = 1 << 6,     // Operator symbol
+    CC_SPECIAL = 1 << 7,    // First char of a comment, macro or object prefix
+} CharClass;
+
+// Kind of word stored in the keyword table of a language.
+typedef enum WordKind
+{
+    WORD_NONE,
+    WORD_KEYWORD,
+    WORD_TYPE,
+} WordKind;
+
+// Entry in the perfect hash table of keywords and type names.
+typedef struct Keyword
+{
+    char word[SYNTAX_WORD_SIZE];
+    byte length;
+    byte kind;
+} Keyword;
+
+// Language definition loaded from config/syntax and compiled into
+// lookup tables used by the shared lexer.
+typedef struct Language
+{
+    char name[SYNTAX_NAME_LEN];
+    char extensions[SYNTAX_MAX_EXTENSIONS][FILE_EXTENSION_SIZE];
+    int numExtensions;
+
+    char comment[SYNTAX_COMMENT_SIZE];           // Line comment, eg. //
+    char blockCommentStart[SYNTAX_COMMENT_SIZE]; // Block comment begin, eg. /*
+    char blockCommentEnd[SYNTAX_COMMENT_SIZE];   // Block comment end, eg. */
+    char macroPrefix[SYNTAX_COMMENT_SIZE];       // Prefix for macros and decorators, eg. # or @
+    char includeWord[SYNTAX_COMMENT_SIZE];       // Macro after which <...> is a string, eg. include
+    char objectPrefixes[SYNTAX_MAX_PREFIXES][SYNTAX_COMMENT_SIZE]; // Member access, eg. . and ->
+    int numObjectPrefixes;
+
+    bool functions; // Highlight words followed by (
+    bool userTypes; // Highlight capitalized words and words followed by another word
+
+    byte charClass[256];   // CharClass flags for each byte
+    Keyword *keywords;     // Keywords and type names
+    int numKeywords;
+    unsigned short *slots; // Perfect hash table, index into keywords + 1. 0 is empty
+    unsigned hashSeed;
+    unsigned hashMask; // Table size - 1, size is a power of two
+} Language;
+
+// Everything that affects how a line is rendered. A cached render is
+// only reused if all fields match.
+typedef struct LineCacheKey
+{
+    unsigned version; // Line version
+    int offx;         // Horizontal scroll
+    int length;       // Rendered length
+    int state;        // Lexer state at line start
+    int theme;        // Colors version
+    Language *lang;   // NULL if syntax is disabled
+    bool isCurrentLine;
+    bool isSelected;
+    int selStart; // Selection columns, -1 for end of line
+    int selEnd;
+    bool isMarked;       // Search matches are drawn
+    unsigned markSearch; // Match index version, changes with the search word
+} LineCacheKey;
+
+// Cached final colored bytes of a rendered line.
+typedef struct LineCacheEntry
+{
+    bool valid;
+    LineCacheKey key;
+    int stateOut; // Lexer state at line end
+    int length;
+    int cap;
+    char *data;
+} LineCacheEntry;
+
+// Rendered lines indexed by row modulo cap. Cap is a power of two.
+typedef struct LineCache
 {
-    FT_UNKNOWN,
-    FT_C,
-    FT_PYTHON,
-    FT_JSON,
-} FileType;
+    int cap;
+    LineCacheEntry *entries;
+} LineCache;
+
+// Position of a search match.
+typedef struct Match
+{
+    int row;
+    int col;
+    int length;
+} Match;
+
+// Search of a whole buffer running on worker threads, see src/buffer/match.c.
+typedef struct SearchJob SearchJob;
+
+// All matches of a search word in a buffer, sorted by row then column.
+// Overlapping matches of a plain word are included. A search word starting
+// with \v is a regex, see src/util/regex.c. \c and \C anywhere in the word
+// set the case matching, see SearchParseCase.
+typedef struct MatchIndex
+{
+    Match *matches;
+    int count;
+    int cap;
+    char search[MAX_SEARCH]; // Word the matches are for, length 0 if none
+    int length;
+    char needle[MAX_SEARCH]; // Search word without \c and \C
+    int needleLength;
+    bool ignoreCase;
+    bool isRegex;
+    Regex *regex;      // NULL if the regex is not valid
+    Searcher searcher; // For the needle if it is not a regex
+    unsigned version;  // Changes when the search word does
+    SearchJob *job;   // Search still running, matches are empty until it is done
+} MatchIndex;
+
+// Search of all files under a directory, see src/rum/grep.c.
+typedef struct Grep Grep;
+
+typedef struct GrepStats
+{
+    int files;      // Files searched
+    int binary;     // Files skipped because they are binary
+    int matches;    // Matching lines
+    int skipped;    // Files not read because the index shows they can not match
+    bool truncated; // Stopped at GREP_MAX_RESULTS matches
+} GrepStats;
+
+// Listing of a directory for the file explorer, see src/rum/explorer.c.
+typedef struct DirList DirList;
+
+// Fuzzy search of all file paths under a directory, see src/rum/finder.c.
+typedef struct Finder Finder;
+
+// Trigram index of the files under a directory, see src/rum/index.c.
+typedef struct TrigramIndex TrigramIndex;
+
+typedef struct IndexStats
+{
+    int files; // Files in the index
+    int read;  // Files read, the rest were unchanged since the last build
+    int bytes; // Size of the index file
+} IndexStats;
 
 // A buffer holds text, usually a file, and is editable.
 typedef struct Buffer
 {
     Cursor cursor;
 
-    bool isFile;   // Does the buffer contain a file?
-    bool isDir;    // Is this a folder open in the explorer?
-    bool dirty;    // Has the buffer changed since last save?
-    bool readOnly; // Is file read-only? Default for non-file buffers like help.
+    bool isFile;    // Does the buffer contain a file?
+    bool isDir;     // Is this a folder open in the explorer?
+    bool isResults; // Is this a list of grep results? Path lines jump to the match.
+    bool dirty;     // Has the buffer changed since last save?
+    bool readOnly;  // Is file read-only? Default for non-file buffers like help.
 
     // Set to true if a loaded file uses tabs. Rum always uses spaces for indentation
     // but will convert spaces to tabs when saving and vice versa when loading a file.
     bool useTabs;
 
     char filepath[MAX_PATH]; // Full path to file
-    FileType fileType;
+    Language *lang;          // Language used for syntax highlighting, NULL if none
+    int hlState;             // Lexer state carried between rendered lines
 
     char search[MAX_SEARCH]; // Current search word
     int searchLen;
@@ -215,7 +413,9 @@ typedef struct Buffer
     CursorPos hlA;
     CursorPos hlB;
 
-    StrArray exPaths; // File explorer paths in order
+    StrArray exPaths;   // File explorer paths in order
+    LineCache cache;    // Rendered lines
+    MatchIndex matches; // Search matches
 } Buffer;
 
 typedef enum InputMode
@@ -231,10 +431,6 @@ typedef enum InputMode
 // The Editor contains the buffers and the current state of the editor.
 typedef struct Editor
 {
-    HANDLE hbuffer; // Handle for created screen buffer
-    HANDLE hstdout; // NOT USED
-    HANDLE hstdin;  // Console input
-
     int width, height; // Total size of editor
     int numBuffers;    // Number of open buffers
     int activeBuffer;  // The buffer currently in focus
@@ -247,6 +443,7 @@ typedef struct Editor
     Buffer *buffers[EDITOR_BUFFER_CAP];
     InputMode mode;
 
-    char *renderBuffer;              // Written to before flushing to terminal
-    char padBuffer[PAD_BUFFER_SIZE]; // Region filled with space characters
+    CbStore renderStore; // Written to before flushing to terminal
+    char *padBuffer;     // Region filled with space characters, see EditorPadding
+    int padSize;         //
 } Editor;
\ No newline at end of file
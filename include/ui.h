@@ -27,6 +27,9 @@ UiResult UiGetTextInput(char *prompt, int maxSize);
 // Prompts user to choose an item from the list. Prompt may be NULL. Remember to check status.
 UiResult UiPromptList(char **items, int numItems, char *prompt);
 UiResult UiPromptListEx(char **items, int numItems, char *prompt, int startIdx);
+// Draws items in a bordered list without waiting for input. x and y are the
+// position of the first item. Items longer than the list are cut.
+void UiDrawList(char **items, int numItems, char *prompt, int selected, int x, int y, int width);
 // Unused
 void UiShowCompletion(char **items, int numItems, int selected);
 // Shows textbox in current buffer. Closed with enter. Is made scrollable if text overflows.
@@ -36,3 +39,6 @@ void UiTextbox(const char *text);
 // UI_CANCEL - if input should cancel (user pressed escape)
 // UI_CONTINUE - if function should be called again to get next char
 UiStatus UiInputBox(char *prompt, char *outBuf, int *outLen, int maxLen);
+// Draws the input box with text without waiting for input. Used to show it
+// again after rendering while the caller is busy.
+void UiDrawInputBox(char *prompt, char *text);
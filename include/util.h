@@ -1,5 +1,10 @@
 #pragma once
 
+#ifndef min // Defined by windows.h
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
 #define clamp(MIN, MAX, v) (max(min((v), (MAX)), (MIN)))
 #define capValue(v, MAX) \
     {                    \
@@ -24,21 +29,43 @@ char *StrMemStr(char *buf, char *substr, size_t size);
 // If the path is not withing home, the returned pointer is just path.
 char *StrGetShortPath(char *path);
 void StrReplace(char *s, char find, char replace);
+// Reverses s in place. Returns s.
+char *StrReverse(char *s);
+// Writes decimal digits of n to dest, not NULL terminated. Returns number of digits.
+int StrFromInt(char *dest, unsigned int n);
+// Returns number of decimal digits in n.
+int StrNumDigits(unsigned int n);
 // Converts n to a readable format: 18200 -> 18K etc. Unsafe.
 void StrNumberToReadable(unsigned long long n, char *dest);
 // Returns true if c is a printable ascii character
 bool isChar(char c);
 
-// Used to store text before rendering.
+// Growable memory used by CharBufs. Kept between frames so rendering does
+// not allocate once the store has grown to fit the screen.
+typedef struct CbStore
+{
+    char *data;
+    int cap;
+} CbStore;
+
+// Used to store text before rendering. Grows its store when full, so buffer
+// and pos are only valid until the next write.
 typedef struct CharBuf
 {
+    CbStore *store;
     char *buffer;
     char *pos;
+    char *end;
     int lineLength;
+    char *bg; // Current colors, NULL if unknown. Used to skip redundant escapes
+    char *fg; //
 } CharBuf;
 
-// Returns empty CharBuf mapped to input buffer.
-CharBuf CbNew(char *buffer);
+// Makes sure store can hold at least size bytes. Keeps existing contents.
+void CbStoreReserve(CbStore *store, int size);
+void CbStoreFree(CbStore *store);
+// Returns empty CharBuf writing to store.
+CharBuf CbNew(CbStore *store);
 // Resets buffer to starting state. Does not memclear the internal buffer.
 void CbReset(CharBuf *buf);
 void CbAppend(CharBuf *buf, char *src, int length);
@@ -52,6 +79,11 @@ void CbBg(CharBuf *buf, char *bg);
 void CbFg(CharBuf *buf, char *fg);
 // Adds COL_RESET to buffer
 void CbColorReset(CharBuf *buf);
+// Sets the current colors without writing them. Used after appending text that
+// already contains color escapes, or when the buffer continues another one.
+void CbSetColorState(CharBuf *buf, char *bg, char *fg);
+// Returns total number of escape bytes written by all CharBufs.
+long long CbEscapeBytes();
 // Prints buffer at x, y with accumulated length only.
 void CbRender(CharBuf *buf, int x, int y);
 // Returns total byte length written to buffer
@@ -69,6 +101,94 @@ int StrArraySet(StrArray *a, char *source, int length);
 char *StrArrayGet(StrArray *a, int idx);
 void StrArrayFree(StrArray *a);
 
+typedef enum SearchImpl
+{
+    SEARCH_SCALAR,
+    SEARCH_SSE2,
+    SEARCH_AVX2,
+} SearchImpl;
+
+// Prepared substring search for one needle. The needle is not copied.
+typedef struct Searcher
+{
+    const char *needle;
+    int length;
+    bool ignoreCase;         // ASCII letters match in either case
+    char lower[MAX_SEARCH];  // Lowercase needle when ignoring case
+    char firstMask;          // 0x20 if ignoring case and the first byte is a letter
+    char lastMask;           // Same for the last byte
+    int skip[256];           // Horspool shift for each byte
+    char *(*func)(const struct Searcher *s, const char *haystack, int length);
+} Searcher;
+
+// Prepares search for needle using the fastest implementation the CPU supports.
+// Needles longer than MAX_SEARCH can not ignore case.
+void SearchInit(Searcher *s, const char *needle, int length, bool ignoreCase);
+// Same as SearchInit with a given implementation. Returns false if the CPU does not support it.
+bool SearchInitEx(Searcher *s, const char *needle, int length, bool ignoreCase, SearchImpl impl);
+// Returns the implementation used by SearchInit.
+SearchImpl SearchBestImpl();
+// Returns pointer to the first match in haystack, NULL if there is none.
+char *SearchFind(const Searcher *s, const char *haystack, int length);
+// Returns true if the first length bytes of a and b only differ in the case of ASCII letters.
+bool SearchEqualFold(const char *a, const char *b, int length);
+// Removes \c and \C from search and writes the rest to dest, which holds MAX_SEARCH
+// bytes. \c ignores case, \C matches it, otherwise config.searchCase decides. Smart
+// case ignores case unless search has an uppercase letter. Returns length of dest.
+int SearchParseCase(char *dest, const char *search, int length, bool *ignoreCase);
+
+// Compiled regular expression, see src/util/regex.c for the syntax.
+typedef struct Regex Regex;
+
+// Compiles pattern. Letters match in either case if ignoreCase is true. Returns
+// NULL if it is not a valid regex.
+Regex *RegexCompile(const char *pattern, int length, bool ignoreCase);
+void RegexFree(Regex *re);
+// Returns true if text contains a match. Runs on a cached DFA, which is usually
+// faster than RegexFind, but slower when the states are flushed often, as in
+// a[ab]{20}c.
+bool RegexTest(Regex *re, const char *text, int length);
+// Finds the leftmost match at or after from. Writes the match to start and end,
+// end is exclusive. Returns false if there is none.
+bool RegexFind(Regex *re, const char *text, int length, int from, int *start, int *end);
+// Returns the literal text every match starts with, lowercase if ignoring
+// case. Writes its length to length, which may be 0.
+const char *RegexPrefix(Regex *re, int *length);
+
+// File or directory entry returned by IoListDir.
+typedef struct DirEntry
+{
+    char name[MAX_PATH];
+    bool isDir;
+    bool isLink; // Symbolic link or junction, isDir tells what it points to
+    unsigned long long size;
+    long long modified; // Last write time in seconds since the unix epoch
+} DirEntry;
+
+// Called by IoWalkDir for each file. path is relative to the walked directory.
+// Returns false to stop the walk.
+typedef bool (*WalkFunc)(const char *path, DirEntry *e, void *arg);
+
+// Writes dir/path to dest, which holds size bytes. Paths in the working
+// directory, "." or "", get no prefix. Returns false if dest was truncated.
+bool IoJoinPath(char *dest, int size, const char *dir, const char *path);
+// Calls func for every file under dir, depth first and in name order. Hidden
+// files and directories, starting with a dot, are skipped, and so are linked
+// directories, which may link back to a parent, and paths that do not fit in
+// PATH_MAX.
+void IoWalkDir(const char *dir, WalkFunc func, void *arg);
+
+// Sets number of worker threads used by buffer search, grep, the index and the
+// file finder, 0 for one per CPU.
+void WorkerSetCount(int count);
+// Returns number of worker threads to start, from 1 to MAX_WORKERS.
+int WorkerCount();
+
+// The functions below are implemented per platform in src/platform.
+
+// Returns time in seconds from an arbitrary starting point.
+double TimeNow();
+
 void *MemAlloc(int size);
 void *MemZeroAlloc(int size);
 void *MemRealloc(void *ptr, int newSize);
@@ -76,7 +196,44 @@ void MemFree(void *ptr);
 
 // Read file realitive to cwd. Writes to size. Returns null on failure. Free content pointer.
 char *IoReadFile(const char *filepath, int *size);
+// Maps file read-only into memory. Writes its size to size. Returns NULL on
+// failure or if the file is empty. Unmap with IoUnmapFile.
+char *IoMapFile(const char *filepath, int *size);
+void IoUnmapFile(char *data, int size);
 // Truncates file or creates new one if it doesnt exist. Returns true on success.
 bool IoWriteFile(const char *filepath, char *data, int size);
 // Returns true if the file exists
-bool IoFileExists(char *filepath);
\ No newline at end of file
+bool IoFileExists(char *filepath);
+// Lists all entries in directory, including . and .. Writes number of entries to
+// count. Returns NULL on failure. Free returned array.
+DirEntry *IoListDir(const char *dir, int *count);
+
+typedef struct DirReader DirReader;
+
+// Opens directory to read its entries one at a time, in no particular order.
+// Returns NULL on failure. Close with IoCloseDir.
+DirReader *IoOpenDir(const char *dir);
+// Writes the next entry to e. Returns false when all entries are read.
+bool IoReadDir(DirReader *d, DirEntry *e);
+void IoCloseDir(DirReader *d);
+// Returns last write time of file or directory in seconds since the unix
+// epoch, -1 if it does not exist.
+long long IoModifiedTime(const char *path);
+// Changes the current working directory. Returns true on success.
+bool IoSetCwd(const char *dir);
+// Writes absolute path of current working directory to dest. Returns true on success.
+bool IoGetCwd(char *dest, int size);
+// Writes directory of the executable, including the trailing separator, to dest.
+void IoExeDir(char *dest, int size);
+
+typedef struct Thread Thread;
+typedef void (*ThreadFunc)(void *arg);
+
+// Runs func(arg) on a new thread. Returns NULL on failure.
+Thread *ThreadStart(ThreadFunc func, void *arg);
+// Waits for thread to finish and frees it.
+void ThreadJoin(Thread *thread);
+// Returns number of logical CPUs, at least 1.
+int CpuCount();
+// Pauses the calling thread for ms milliseconds.
+void TimeSleep(int ms);
@@ -6,6 +6,13 @@ extern Editor editor;
 extern Colors colors;
 extern Config config;
 
+// Gives line a new unique version so cached renders of it are invalidated.
+static inline void lineChanged(Line *line)
+{
+    static unsigned version = 0;
+    line->version = ++version;
+}
+
 // Reallocs lines char array to new size.
 static void bufferExtendLine(Buffer *b, int row, int new_size)
 {
@@ -50,12 +57,16 @@ Buffer *BufferNew()
 
 void BufferFree(Buffer *b)
 {
+    // Stops a running search first, it reads the lines
+    MatchIndexFree(b);
+
     for (int i = 0; i < b->numLines; i++)
         MemFree(b->lines[i].chars);
 
-    if (b->isDir)
+    if (b->isDir || b->isResults)
         StrArrayFree(&b->exPaths);
 
+    LineCacheFree(b);
     MemFree(b->lines);
     MemFree(b);
 }
@@ -82,7 +93,8 @@ void BufferWriteEx(Buffer *b, int row, int col, char *source, int length)
 
     memcpy(line->chars + col, source, length);
     line->length += length;
-    line->isMarked = false;
+    lineChanged(line);
+    MatchIndexUpdateRow(b, row);
     b->dirty = true;
 }
 
@@ -107,7 +119,8 @@ void BufferOverWriteEx(Buffer *b, int row, int col, char *source, int length)
 
     memcpy(line->chars + col, source, length);
     line->length = max(line->length, col + length);
-    line->isMarked = false;
+    lineChanged(line);
+    MatchIndexUpdateRow(b, row);
     b->dirty = true;
 }
 
@@ -135,7 +148,8 @@ void BufferDeleteEx(Buffer *b, int row, int col, int count)
 
     memset(line->chars + line->length, 0, line->cap - line->length);
     line->length -= count;
-    line->isMarked = false;
+    lineChanged(line);
+    MatchIndexUpdateRow(b, row);
     b->dirty = true;
 }
 
@@ -218,13 +232,31 @@ Line *BufferInsertLineEx(Buffer *b, int row, char *text, int textLen)
         .isPath = false,
     };
 
+    lineChanged(&line);
     memcpy(&b->lines[row], &line, sizeof(Line));
     b->numLines++;
     b->dirty = true;
+    MatchIndexInsertRow(b, row);
 
     return &b->lines[row];
 }
 
+// Replaces the text of row with chars. Returns the old text.
+char *BufferSwapLine(Buffer *b, int row, char *chars, int length, int cap)
+{
+    Assert(length < cap);
+    Line *line = &b->lines[row];
+    char *old = line->chars;
+
+    line->chars = chars;
+    line->length = length;
+    line->cap = cap;
+    lineChanged(line);
+    MatchIndexUpdateRow(b, row);
+    b->dirty = true;
+    return old;
+}
+
 // Deletes line at row and move all lines below upwards.
 void BufferDeleteLine(Buffer *b, int row)
 {
@@ -240,10 +272,13 @@ void BufferDeleteLine(Buffer *b, int row)
     {
         memset(line->chars, 0, line->cap);
         line->length = 0;
+        lineChanged(line);
+        MatchIndexUpdateRow(b, row);
         return;
     }
 
     MemFree(line->chars);
+    MatchIndexDeleteRow(b, row);
     Line *pos = b->lines + row + 1;
 
     if (row != b->lineCap - 1)
@@ -278,7 +313,10 @@ void BufferMoveTextDownEx(Buffer *b, int row, int col)
     to->length += length;
     from->length -= length;
     b->dirty = true;
-    from->isMarked = to->isMarked = false;
+    lineChanged(from);
+    lineChanged(to);
+    MatchIndexUpdateRow(b, row);
+    MatchIndexUpdateRow(b, row + 1);
 }
 
 // Copies and removes all characters behind the cursor position,
@@ -309,7 +347,10 @@ int BufferMoveTextUpEx(Buffer *b, int row, int col)
     memcpy(to->chars + to->length, from->chars, from->length);
     to->length += from->length;
     b->dirty = true;
-    from->isMarked = to->isMarked = false;
+    lineChanged(from);
+    lineChanged(to);
+    MatchIndexUpdateRow(b, row);
+    MatchIndexUpdateRow(b, row - 1);
     return toLength;
 }
 
@@ -343,13 +384,104 @@ void BufferScroll(Buffer *b)
     Assert(b->cursor.offy >= 0);
 }
 
-static void renderLine(Buffer *b, CharBuf *cb, int idx, int maxWidth)
+// Line number column of a buffer. The number is kept as right aligned digits
+// and stepped from one row to the next, so only rows where the number jumps
+// are converted from an int.
+typedef struct gutter
+{
+    char text[16]; // Padded digits, padX characters
+    int width;
+    int number; // Number in text, -1 if not set
+} gutter;
+
+static gutter gutterNew(Buffer *b)
+{
+    // Wide enough for the last line number
+    b->padX = max(StrNumDigits(b->numLines), GUTTER_MIN_DIGITS) + 2;
+    return (gutter){.width = b->padX, .number = -1};
+}
+
+static void gutterSet(gutter *g, int n)
+{
+    char digits[12];
+    int length = StrFromInt(digits, n);
+    memset(g->text, ' ', g->width);
+    memcpy(g->text + g->width - 1 - length, digits, length);
+    g->number = n;
+}
+
+// Adds 1 or -1 to the number in place.
+static void gutterStep(gutter *g, int delta)
+{
+    int i = g->width - 2;
+
+    if (delta > 0)
+    {
+        while (g->text[i] == '9')
+            g->text[i--] = '0';
+        g->text[i] = g->text[i] == ' ' ? '1' : g->text[i] + 1;
+    }
+    else
+    {
+        while (g->text[i] == '0')
+            g->text[i--] = '9';
+        g->text[i]--;
+
+        // Remove leading zero, eg. 10 -> 09 -> 9
+        if (g->text[i] == '0' && i < g->width - 2 && g->text[i - 1] == ' ')
+            g->text[i] = ' ';
+    }
+
+    g->number += delta;
+}
+
+// Writes the line number of row to the gutter. With relative numbers the
+// cursor row shows its absolute number and the others their distance to it.
+static void gutterUpdate(gutter *g, Buffer *b, int row)
+{
+    int n = row + 1;
+    if (config.relativeNumbers && row != b->cursor.row)
+        n = abs(row - b->cursor.row);
+
+    int delta = n - g->number;
+    if (g->number >= 0 && (delta == 1 || (delta == -1 && n > 0)))
+        gutterStep(g, delta);
+    else if (delta != 0)
+        gutterSet(g, n);
+}
+
+// Marks the search matches on row, which starts at column offx and is length
+// characters long. Overlapping matches are merged into one mark. Only rows that
+// are drawn are searched, and the result is kept in the line cache until the
+// line or the search word changes.
+static HlLine markMatches(Buffer *b, HlLine line, int offx, int length)
+{
+    int count;
+    Match *matches = MatchIndexSearchRow(b, line.row, &count);
+
+    for (int i = 0; i < count;)
+    {
+        int start = matches[i].col;
+        int end = start + matches[i].length;
+        for (i++; i < count && matches[i].col <= end; i++)
+            end = max(end, matches[i].col + matches[i].length);
+
+        start = max(start - offx, 0);
+        end = min(end - offx, length);
+        if (start < end)
+            line = MarkLine(line, start, end);
+    }
+
+    return line;
+}
+
+static void renderLine(Buffer *b, CharBuf *cb, gutter *g, int idx, int maxWidth)
 {
     // Hide text when ui is open to not clutter view
     if (editor.uiOpen && curBuffer->id == b->id)
     {
         CbColor(cb, colors.bg0, colors.fg0);
-        CbAppend(cb, editor.padBuffer, maxWidth);
+        CbRepeat(cb, ' ', maxWidth);
         return;
     }
 
@@ -362,14 +494,12 @@ static void renderLine(Buffer *b, CharBuf *cb, int idx, int maxWidth)
 
         // Line background color
         bool isCurrentLine = b->id == editor.activeBuffer && b->cursor.row == row && !b->showHighlight && b->showCurrentLineMark;
-        isCurrentLine ? CbColor(cb, colors.bg1, colors.fg0) : CbColor(cb, colors.bg0, colors.bg2);
+        char *lineBg = isCurrentLine ? colors.bg1 : colors.bg0;
+        CbColor(cb, lineBg, isCurrentLine ? colors.fg0 : colors.bg2);
 
         // Line numbers
-        {
-            char numbuf[12];
-            sprintf(numbuf, " %4d ", (short)(row + 1));
-            CbAppend(cb, numbuf, b->padX);
-        }
+        gutterUpdate(g, b, row);
+        CbAppend(cb, g->text, g->width);
 
         // Line contents
         CbFg(cb, colors.fg0);
@@ -383,7 +513,7 @@ static void renderLine(Buffer *b, CharBuf *cb, int idx, int maxWidth)
         if (lineLength == 0)
         {
             renderLength = 1;
-            lineBegin = editor.padBuffer;
+            lineBegin = " ";
         }
 
         // Add color and highlights to line
@@ -396,29 +526,62 @@ static void renderLine(Buffer *b, CharBuf *cb, int idx, int maxWidth)
                 .isCurrentLine = isCurrentLine,
             };
 
-            if (config.syntaxEnabled)
-                finalLine = ColorLine(b, finalLine);
-
-            if (b->showHighlight)
-                finalLine = HighlightLine(b, finalLine);
-
-            if (b->showMarkedLines && line.isMarked)
-                finalLine = MarkLine(finalLine, line.hlStart, line.hlEnd);
+            LineCacheKey key = {
+                .version = line.version,
+                .offx = b->cursor.offx,
+                .length = renderLength,
+                .state = b->hlState,
+                .theme = colors.version,
+                .lang = config.syntaxEnabled ? b->lang : NULL,
+                .isCurrentLine = isCurrentLine,
+                .isMarked = b->showMarkedLines && b->matches.needleLength > 0 && editor.mode != MODE_VISUAL && editor.mode != MODE_VISUAL_LINE,
+                .markSearch = b->matches.version,
+            };
 
-            CbAppend(cb, finalLine.line, finalLine.length);
+            if (b->showHighlight && !config.rawMode)
+            {
+                CursorPos start, end;
+                BufferOrderHighlightPoints(b, &start, &end);
+                key.isSelected = row >= start.row && row <= end.row;
+                key.selStart = start.row == row ? start.col : 0;
+                key.selEnd = end.row == row ? end.col : -1;
+            }
+
+            LineCacheEntry *cached = LineCacheGet(b, row, &key);
+            if (cached != NULL)
+            {
+                CbAppend(cb, cached->data, cached->length);
+                CbSetColorState(cb, lineBg, colors.fg0);
+                b->hlState = cached->stateOut;
+            }
+            else
+            {
+                if (config.syntaxEnabled)
+                    finalLine = ColorLine(b, finalLine);
+
+                if (key.isSelected)
+                    finalLine = HighlightLine(b, finalLine);
+
+                if (key.isMarked)
+                    finalLine = markMatches(b, finalLine, b->cursor.offx, renderLength);
+
+                LineCachePut(b, row, &key, finalLine.line, finalLine.length, b->hlState);
+                CbAppend(cb, finalLine.line, finalLine.length);
+                CbSetColorState(cb, lineBg, colors.fg0);
+            }
         }
 
         // Padding after
         if (renderLength < textW)
         {
-            CbAppend(cb, editor.padBuffer, textW - renderLength);
+            CbRepeat(cb, ' ', textW - renderLength);
         }
     }
     else
     {
         CbColor(cb, colors.bg0, colors.bg2);
         CbAppend(cb, "~", 1);
-        CbAppend(cb, editor.padBuffer, maxWidth - 1);
+        CbRepeat(cb, ' ', maxWidth - 1);
     }
 }
 
@@ -474,6 +637,19 @@ static void renderStatusLine(Buffer *b, CharBuf *cb, int maxWidth)
         char fInfo[256];
         int infoLen = 0;
 
+        // Search matches, with the number of the one under the cursor
+        MatchIndex *idx = &b->matches;
+        if (b->showMarkedLines && idx->count > 0)
+        {
+            int k = MatchIndexLowerBound(b, b->cursor.row, b->cursor.col);
+            Match *m = &idx->matches[min(k, idx->count - 1)];
+            if (m->row == b->cursor.row && m->col == b->cursor.col)
+                infoLen = sprintf(fInfo, "match %d of %d  ", k + 1, idx->count);
+            else
+                infoLen = sprintf(fInfo, "%d match%s  ", idx->count, idx->count == 1 ? "" : "es");
+            CbAppend(cb, fInfo, infoLen);
+        }
+
         infoLen = sprintf(fInfo, "lines %d  ", b->numLines);
         CbAppend(cb, fInfo, infoLen);
 
@@ -483,12 +659,17 @@ static void renderStatusLine(Buffer *b, CharBuf *cb, int maxWidth)
         CbAppend(cb, config.useCRLF ? "CRLF" : "LF  ", 4); // last
     }
 
-    CbAppend(cb, editor.padBuffer, maxWidth - cb->lineLength);
+    CbRepeat(cb, ' ', maxWidth - cb->lineLength);
 }
 
+// Buffer and scroll offset of last full render, used to detect vertical scrolling
+static Buffer *lastRendered = NULL;
+static int lastOffy = 0;
+static int lastTextH = 0;
+
 void BufferRenderFull(Buffer *b)
 {
-    CharBuf cb = CbNew(editor.renderBuffer);
+    CharBuf cb = CbNew(&editor.renderStore);
 
     int h = editor.height - 2;
     b->textH = h - b->padY;
@@ -496,9 +677,21 @@ void BufferRenderFull(Buffer *b)
     b->width = editor.width;
     b->height = editor.height - 2;
     b->offX = 0;
+    b->hlState = LEX_NORMAL;
+    LineCacheReserve(b, b->textH);
+
+    // Scroll the text already on screen so only the new rows are written
+    int dy = b->cursor.offy - lastOffy;
+    if (b == lastRendered && b->textH == lastTextH && dy != 0 && abs(dy) < b->textH && !editor.uiOpen)
+        ScreenScroll(b->padY, b->padY + b->textH - 1, dy);
+
+    lastRendered = editor.uiOpen ? NULL : b;
+    lastOffy = b->cursor.offy;
+    lastTextH = b->textH;
 
+    gutter g = gutterNew(b);
     for (int i = 0; i < b->textH; i++)
-        renderLine(b, &cb, i, editor.width);
+        renderLine(b, &cb, &g, i, editor.width);
 
     renderStatusLine(b, &cb, editor.width);
     CbRender(&cb, 0, 0);
@@ -506,14 +699,14 @@ void BufferRenderFull(Buffer *b)
 
 void BufferRenderSplit(Buffer *a, Buffer *b)
 {
-    CharBuf cb = CbNew(editor.renderBuffer);
+    CharBuf cb = CbNew(&editor.renderStore);
 
     int h = editor.height - 2;
     int textH = h - a->padY;
     a->textH = h - a->padY;
     b->textH = h - b->padY;
 
-    int gutterW = 3;
+    int dividerW = 3;
     int leftW = editor.width / 2 - 1;
     int rightW = editor.width / 2 - 2;
     if (editor.width % 2 != 0)
@@ -526,36 +719,48 @@ void BufferRenderSplit(Buffer *a, Buffer *b)
     b->width = rightW;
     a->height = b->height = h;
 
-    char gutter[] = {' ', (char)179, ' ', ' ', 0};
+    char divider[] = {' ', (char)179, ' ', ' ', 0};
+    a->hlState = b->hlState = LEX_NORMAL;
+    lastRendered = NULL; // Scroll regions span the whole width
+    LineCacheReserve(a, textH);
+    LineCacheReserve(b, textH);
+
+    gutter ga = gutterNew(a);
+    gutter gb = gutterNew(b);
 
     for (int i = 0; i < textH; i++)
     {
-        renderLine(a, &cb, i, leftW);
+        renderLine(a, &cb, &ga, i, leftW);
         CbColor(&cb, colors.bg0, colors.bg1);
-        CbAppend(&cb, gutter, gutterW);
-        renderLine(b, &cb, i, rightW);
+        CbAppend(&cb, divider, dividerW);
+        renderLine(b, &cb, &gb, i, rightW);
     }
 
     renderStatusLine(a, &cb, leftW);
     CbColor(&cb, colors.bg0, colors.bg1);
-    CbAppend(&cb, gutter, gutterW);
+    CbAppend(&cb, divider, dividerW);
     renderStatusLine(b, &cb, rightW);
 
     CbRender(&cb, 0, 0);
 }
 
+// Scratch memory for tab conversion when loading and saving files
+static CbStore tabStore = {0};
+
 static String expandTabs(String s)
 {
     int newLength = s.length;
-    strncpy(editor.renderBuffer, s.s, s.length);
+    CbStoreReserve(&tabStore, s.length * max(config.tabSize, 1) + 1);
+    char *text = tabStore.data;
+    memcpy(text, s.s, s.length);
 
     for (int i = 0; i < newLength; i++)
     {
-        char c = editor.renderBuffer[i];
+        char c = text[i];
         if (c == '\t')
         {
             int tab = config.tabSize;
-            char *pos = editor.renderBuffer + i;
+            char *pos = text + i;
 
             memmove(pos + tab - 1, pos, newLength - i);
             memset(pos, ' ', tab);
@@ -563,24 +768,26 @@ static String expandTabs(String s)
         }
     }
 
-    editor.renderBuffer[newLength] = 0;
-    return STRING(editor.renderBuffer, newLength);
+    text[newLength] = 0;
+    return STRING(text, newLength);
 }
 
 static String contractTabs(String s)
 {
     int newLength = s.length;
-    strncpy(editor.renderBuffer, s.s, s.length);
+    CbStoreReserve(&tabStore, s.length + 1);
+    char *text = tabStore.data;
+    memcpy(text, s.s, s.length);
 
     for (int i = 0; i < newLength; i++)
     {
         if (i + config.tabSize > newLength)
             continue;
 
-        char *pos = editor.renderBuffer + i;
+        char *pos = text + i;
         int tab = config.tabSize;
 
-        if (!strncmp(editor.padBuffer, pos, tab))
+        if (!strncmp(EditorPadding(tab), pos, tab))
         {
             memmove(pos, pos + tab - 1, newLength - i);
             *pos = '\t';
@@ -588,8 +795,8 @@ static String contractTabs(String s)
         }
     }
 
-    editor.renderBuffer[newLength] = 0;
-    return STRING(editor.renderBuffer, newLength);
+    text[newLength] = 0;
+    return STRING(text, newLength);
 }
 
 // Loads file contents into a new Buffer and returns it.
@@ -698,10 +905,11 @@ void BufferOrderHighlightPoints(Buffer *b, CursorPos *from, CursorPos *to)
     to->col++; // Hack to make marker always at least 1 char wide
 }
 
-// Returns the text hihglighted in visual mode
+// Returns the text hihglighted in visual mode. Valid until the next call.
 char *BufferGetMarkedText(Buffer *b)
 {
-    CharBuf cb = CbNew(editor.renderBuffer);
+    static CbStore markedStore = {0};
+    CharBuf cb = CbNew(&markedStore);
 
     CursorPos from, to;
     BufferOrderHighlightPoints(b, &from, &to);
@@ -732,20 +940,6 @@ char *BufferGetLinePath(Buffer *b, Line *line)
     return StrArrayGet(&b->exPaths, line->exPathId);
 }
 
-void BufferMarkLine(Buffer *b, int row, int col, int length)
-{
-    Line *line = &b->lines[row];
-    line->hlStart = col;
-    line->hlEnd = col + length;
-    line->isMarked = true;
-}
-
-void BufferUnmarkAll(Buffer *b)
-{
-    for (int i = 0; i < b->numLines; i++)
-        b->lines[i].isMarked = false;
-}
-
 void BufferSetSearchWord(Buffer *b, char *search, int length)
 {
     if (search == NULL)
@@ -766,16 +960,6 @@ void BufferSetFilename(Buffer *b, char *filepath)
 
 bool BufferSetFileType(Buffer *b, const char *extension)
 {
-#define is(ex) !strcmp(extension, ex)
-    FileType t = FT_UNKNOWN;
-
-    if (is("c") || is("h"))
-        t = FT_C;
-    else if (is("py"))
-        t = FT_PYTHON;
-    else if (is("json"))
-        t = FT_JSON;
-
-    b->fileType = t;
-    return t != FT_UNKNOWN;
+    b->lang = SyntaxFindLanguage(extension);
+    return b->lang != NULL;
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+// Cache of rendered lines. Most lines look the same from one frame to the next,
+// so their final colored bytes are kept and copied instead of highlighted again.
+
+#include "rum.h"
+
+static bool keyEqual(LineCacheKey *a, LineCacheKey *b)
+{
+    return a->version == b->version &&
+           a->offx == b->offx &&
+           a->length == b->length &&
+           a->state == b->state &&
+           a->theme == b->theme &&
+           a->lang == b->lang &&
+           a->isCurrentLine == b->isCurrentLine &&
+           a->isSelected == b->isSelected &&
+           a->selStart == b->selStart &&
+           a->selEnd == b->selEnd &&
+           a->isMarked == b->isMarked &&
+           a->markSearch == b->markSearch;
+}
+
+// Makes sure the cache can hold at least numRows rows without them sharing entries.
+void LineCacheReserve(Buffer *b, int numRows)
+{
+    LineCache *c = &b->cache;
+    if (c->cap >= numRows * 2)
+        return;
+
+    LineCacheFree(b);
+
+    int cap = 64;
+    while (cap < numRows * 2)
+        cap *= 2;
+
+    c->cap = cap;
+    c->entries = MemZeroAlloc(cap * sizeof(LineCacheEntry));
+    AssertNotNull(c->entries);
+}
+
+LineCacheEntry *LineCacheGet(Buffer *b, int row, LineCacheKey *key)
+{
+    if (b->cache.cap == 0)
+        return NULL;
+
+    LineCacheEntry *e = &b->cache.entries[row & (b->cache.cap - 1)];
+    if (e->valid && keyEqual(&e->key, key))
+        return e;
+
+    return NULL;
+}
+
+void LineCachePut(Buffer *b, int row, LineCacheKey *key, char *data, int length, int stateOut)
+{
+    if (b->cache.cap == 0)
+        return;
+
+    LineCacheEntry *e = &b->cache.entries[row & (b->cache.cap - 1)];
+    if (length > e->cap)
+    {
+        e->cap = max(length, LINE_DEFAULT_LENGTH * 4);
+        e->data = e->data == NULL ? MemAlloc(e->cap) : MemRealloc(e->data, e->cap);
+        AssertNotNull(e->data);
+    }
+
+    memcpy(e->data, data, length);
+    e->length = length;
+    e->stateOut = stateOut;
+    e->key = *key;
+    e->valid = true;
+}
+
+void LineCacheFree(Buffer *b)
+{
+    LineCache *c = &b->cache;
+    for (int i = 0; i < c->cap; i++)
+        if (c->entries[i].data != NULL)
+            MemFree(c->entries[i].data);
+
+    if (c->entries != NULL)
+        MemFree(c->entries);
+
+    c->entries = NULL;
+    c->cap = 0;
+}
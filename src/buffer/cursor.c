@@ -6,12 +6,12 @@ extern Editor editor;
 
 void CursorShow()
 {
-    TermSetCursorVisible(true);
+    ScreenSetCursorVisible(true);
 }
 
 void CursorHide()
 {
-    TermSetCursorVisible(false);
+    ScreenSetCursorVisible(false);
 }
 
 void CursorMove(Buffer *b, int x, int y)
@@ -72,12 +72,12 @@ void CursorSetPos(Buffer *b, int x, int y, bool keepX)
 // not updated so cursor returns to previous position when render is called.
 void CursorTempPos(int x, int y)
 {
-    TermSetCursorPos(x, y);
+    ScreenSetPos(x, y);
 }
 
 void CursorUpdatePos()
 {
     int x = curBuffer->cursor.col - curBuffer->cursor.offx + curBuffer->padX + curBuffer->offX;
     int y = curBuffer->cursor.row - curBuffer->cursor.offy + curBuffer->padY;
-    TermSetCursorPos(x, y);
+    ScreenSetPos(x, y);
 }
\ No newline at end of file
@@ -0,0 +1,472 @@
+// Index of all search matches in a buffer, sorted by position. Edits search
+// only the changed row again and move the rows below, so the index stays valid
+// without scanning the whole buffer.
+//
+// The whole buffer is searched by worker threads. Lines are split in chunks
+// that workers take in order from the start position, so matches near the
+// cursor are found first. Each chunk keeps its own matches, which are joined
+// in row order when all chunks are done.
+
+#include "rum.h"
+
+#define CHUNK_LINES 16384       // Lines a worker takes at a time
+#define CANCEL_CHECK_LINES 1024 // Workers check if the search was stopped this often
+
+// Matches found in a range of rows, in order.
+typedef struct matchList
+{
+    Match *matches;
+    int count;
+    int cap;
+} matchList;
+
+typedef struct searchChunk
+{
+    matchList list;
+    bool done; // Set by the worker when list is complete
+} searchChunk;
+
+struct SearchJob
+{
+    Buffer *b;
+    Searcher searcher;
+    CursorPos from;
+
+    searchChunk *chunks;
+    int numChunks;
+    int firstChunk; // Chunk containing from, searched first
+
+    // Changed by workers, accessed atomically
+    int nextChunk; // Next chunk to search, counted from firstChunk
+    int numDone;
+    bool cancelled;
+
+    Thread *threads[MAX_WORKERS];
+    int numThreads;
+};
+
+static int compareMatch(Match *m, int row, int col)
+{
+    if (m->row != row)
+        return m->row < row ? -1 : 1;
+    return m->col < col ? -1 : m->col > col;
+}
+
+// Returns index of first match at or after row/col, count if there is none.
+int MatchIndexLowerBound(Buffer *b, int row, int col)
+{
+    MatchIndex *idx = &b->matches;
+    int lo = 0, hi = idx->count;
+
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (compareMatch(&idx->matches[mid], row, col) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static void reserve(MatchIndex *idx, int count)
+{
+    if (count <= idx->cap && idx->matches != NULL)
+        return;
+
+    idx->cap = max(max(idx->cap * 2, count), 1024);
+    idx->matches = idx->matches == NULL
+                       ? MemAlloc(idx->cap * sizeof(Match))
+                       : MemRealloc(idx->matches, idx->cap * sizeof(Match));
+    AssertNotNull(idx->matches);
+}
+
+// Matches found in one line by MatchIndexUpdateRow
+static matchList lineMatches = {0};
+
+static void addMatch(matchList *list, int row, int col, int length)
+{
+    if (list->count == list->cap)
+    {
+        list->cap = max(list->cap * 2, 64);
+        list->matches = list->matches == NULL
+                            ? MemAlloc(list->cap * sizeof(Match))
+                            : MemRealloc(list->matches, list->cap * sizeof(Match));
+        AssertNotNull(list->matches);
+    }
+
+    list->matches[list->count++] = (Match){.row = row, .col = col, .length = length};
+}
+
+// Adds all matches in line to list. A plain word is found at every position,
+// including overlapping ones. Regex matches do not overlap and empty ones are
+// skipped. re is NULL if the regex is not valid.
+static void searchLine(MatchIndex *idx, Regex *re, Searcher *s, Line *line, int row, matchList *list)
+{
+    if (idx->isRegex)
+    {
+        if (re == NULL || !RegexTest(re, line->chars, line->length))
+            return;
+
+        int from = 0, start, end;
+        while (from <= line->length && RegexFind(re, line->chars, line->length, from, &start, &end))
+        {
+            if (end > start)
+                addMatch(list, row, start, end - start);
+            from = max(end, start + 1);
+        }
+
+        return;
+    }
+
+    char *p = line->chars;
+    char *end = line->chars + line->length;
+
+    while ((p = SearchFind(s, p, end - p)) != NULL)
+    {
+        addMatch(list, row, p - line->chars, idx->needleLength);
+        p++;
+    }
+}
+
+static bool isRegex(char *search, int length)
+{
+    return length >= 2 && search[0] == '\\' && search[1] == 'v';
+}
+
+static bool isCancelled(SearchJob *job)
+{
+    return __atomic_load_n(&job->cancelled, __ATOMIC_RELAXED);
+}
+
+static void searchWorker(void *arg)
+{
+    SearchJob *job = arg;
+    Buffer *b = job->b;
+    MatchIndex *idx = &b->matches;
+
+    // Searching changes the DFA cache of a regex, so each worker has its own
+    Regex *re = idx->isRegex ? RegexCompile(idx->needle + 2, idx->needleLength - 2, idx->ignoreCase) : NULL;
+
+    while (!isCancelled(job))
+    {
+        int k = __atomic_fetch_add(&job->nextChunk, 1, __ATOMIC_RELAXED);
+        if (k >= job->numChunks)
+            break;
+
+        int c = (job->firstChunk + k) % job->numChunks;
+        searchChunk *chunk = &job->chunks[c];
+        int end = min((c + 1) * CHUNK_LINES, b->numLines);
+
+        int row = c * CHUNK_LINES;
+        for (; row < end; row++)
+        {
+            if (row % CANCEL_CHECK_LINES == 0 && isCancelled(job))
+                break;
+            searchLine(idx, re, &job->searcher, &b->lines[row], row, &chunk->list);
+        }
+
+        if (row < end)
+            break;
+
+        __atomic_store_n(&chunk->done, true, __ATOMIC_RELEASE);
+        __atomic_fetch_add(&job->numDone, 1, __ATOMIC_RELEASE);
+    }
+
+    RegexFree(re);
+}
+
+// Waits for the workers and frees the job. Matches are added to the index if
+// the search was not cancelled.
+static void finishJob(MatchIndex *idx)
+{
+    SearchJob *job = idx->job;
+    if (job == NULL)
+        return;
+
+    for (int i = 0; i < job->numThreads; i++)
+        ThreadJoin(job->threads[i]);
+
+    if (!job->cancelled)
+    {
+        int total = 0;
+        for (int i = 0; i < job->numChunks; i++)
+            total += job->chunks[i].list.count;
+
+        reserve(idx, total);
+        for (int i = 0; i < job->numChunks; i++)
+        {
+            matchList *list = &job->chunks[i].list;
+            if (list->count == 0)
+                continue;
+
+            memcpy(idx->matches + idx->count, list->matches, list->count * sizeof(Match));
+            idx->count += list->count;
+        }
+
+    }
+
+    for (int i = 0; i < job->numChunks; i++)
+        if (job->chunks[i].list.matches != NULL)
+            MemFree(job->chunks[i].list.matches);
+
+    MemFree(job->chunks);
+    MemFree(job);
+    idx->job = NULL;
+}
+
+static void stopJob(MatchIndex *idx)
+{
+    if (idx->job == NULL)
+        return;
+
+    __atomic_store_n(&idx->job->cancelled, true, __ATOMIC_RELAXED);
+    finishJob(idx);
+}
+
+// Sets the search word and removes all matches. Returns false if there is
+// nothing to search for.
+static bool setSearch(MatchIndex *idx, char *search, int length)
+{
+    stopJob(idx);
+    idx->count = 0;
+    idx->length = min(length, MAX_SEARCH);
+    memcpy(idx->search, search, idx->length);
+    idx->version++;
+
+    RegexFree(idx->regex);
+    idx->regex = NULL;
+    idx->needleLength = SearchParseCase(idx->needle, idx->search, idx->length, &idx->ignoreCase);
+    idx->isRegex = isRegex(idx->needle, idx->needleLength);
+
+    if (idx->isRegex)
+        idx->regex = RegexCompile(idx->needle + 2, idx->needleLength - 2, idx->ignoreCase);
+    else if (idx->needleLength > 0)
+        SearchInit(&idx->searcher, idx->needle, idx->needleLength, idx->ignoreCase);
+
+    return idx->needleLength > 0;
+}
+
+void MatchIndexStart(Buffer *b, char *search, int length, CursorPos from)
+{
+    MatchIndex *idx = &b->matches;
+    if (!setSearch(idx, search, length) || (idx->isRegex && idx->regex == NULL) || b->numLines == 0)
+        return;
+
+    SearchJob *job = MemZeroAlloc(sizeof(SearchJob));
+    AssertNotNull(job);
+
+    job->b = b;
+    job->from = from;
+    job->numChunks = (b->numLines + CHUNK_LINES - 1) / CHUNK_LINES;
+    job->firstChunk = clamp(0, job->numChunks - 1, from.row / CHUNK_LINES);
+    job->chunks = MemZeroAlloc(job->numChunks * sizeof(searchChunk));
+    AssertNotNull(job->chunks);
+    job->searcher = idx->searcher;
+    idx->job = job;
+
+    // One chunk is searched faster than a thread is started. Otherwise there
+    // is always a worker, so the caller can stop the search.
+    int workers = min(WorkerCount(), job->numChunks);
+
+    for (int i = 0; i < workers && job->numChunks > 1; i++)
+    {
+        Thread *t = ThreadStart(searchWorker, job);
+        if (t != NULL)
+            job->threads[job->numThreads++] = t;
+    }
+
+    if (job->numThreads == 0)
+        searchWorker(job);
+}
+
+bool MatchIndexWait(Buffer *b, int ms)
+{
+    MatchIndex *idx = &b->matches;
+    SearchJob *job = idx->job;
+    if (job == NULL)
+        return true;
+
+    double end = TimeNow() + ms / 1000.0;
+    while (ms >= 0 && __atomic_load_n(&job->numDone, __ATOMIC_ACQUIRE) < job->numChunks)
+    {
+        if (TimeNow() >= end)
+            return false;
+        TimeSleep(1);
+    }
+
+    finishJob(idx);
+    return true;
+}
+
+bool MatchIndexFirst(Buffer *b, Match *m)
+{
+    SearchJob *job = b->matches.job;
+    if (job == NULL)
+        return false;
+
+    // The first chunk is checked again at the end for matches before from
+    for (int k = 0; k <= job->numChunks; k++)
+    {
+        searchChunk *chunk = &job->chunks[(job->firstChunk + k) % job->numChunks];
+        if (!__atomic_load_n(&chunk->done, __ATOMIC_ACQUIRE))
+            return false;
+
+        for (int i = 0; i < chunk->list.count; i++)
+        {
+            if (k > 0 || compareMatch(&chunk->list.matches[i], job->from.row, job->from.col) >= 0)
+            {
+                *m = chunk->list.matches[i];
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void MatchIndexBuild(Buffer *b, char *search, int length)
+{
+    MatchIndexStart(b, search, length, (CursorPos){0});
+    MatchIndexWait(b, -1);
+}
+
+void MatchIndexNarrow(Buffer *b, char *search, int length)
+{
+    MatchIndex *idx = &b->matches;
+    Assert(length >= idx->length && !memcmp(search, idx->search, idx->length));
+
+    char needle[MAX_SEARCH];
+    bool ignoreCase;
+    int needleLength = SearchParseCase(needle, search, length, &ignoreCase);
+
+    // A longer regex can match anywhere. Typing \c removes text from the
+    // needle, and a word that starts to ignore case matches more.
+    bool narrower = needleLength >= idx->needleLength && (idx->ignoreCase || !ignoreCase) &&
+                    !memcmp(needle, idx->needle, idx->needleLength);
+    if (idx->isRegex || isRegex(needle, needleLength) || idx->job != NULL || !narrower)
+    {
+        MatchIndexBuild(b, search, length);
+        return;
+    }
+
+    idx->length = min(length, MAX_SEARCH);
+    memcpy(idx->search, search, idx->length);
+    memcpy(idx->needle, needle, needleLength);
+    idx->needleLength = needleLength;
+    idx->ignoreCase = ignoreCase;
+    idx->version++;
+    SearchInit(&idx->searcher, needle, needleLength, ignoreCase);
+
+    // Each match of the longer word starts with the shorter one, so it is
+    // already in the index and only has to be checked
+    int n = 0;
+    for (int i = 0; i < idx->count; i++)
+    {
+        Match m = idx->matches[i];
+        Line *line = &b->lines[m.row];
+        char *text = line->chars + m.col;
+
+        m.length = needleLength;
+        if (m.col + m.length > line->length)
+            continue;
+
+        if (ignoreCase ? SearchEqualFold(text, needle, m.length) : !memcmp(text, needle, m.length))
+            idx->matches[n++] = m;
+    }
+
+    idx->count = n;
+}
+
+void MatchIndexClear(Buffer *b)
+{
+    setSearch(&b->matches, "", 0);
+}
+
+int MatchIndexPause(Buffer *b)
+{
+    // Clearing leaves the old word in the search array
+    int length = b->matches.length;
+    MatchIndexClear(b);
+    return length;
+}
+
+void MatchIndexResume(Buffer *b, int length)
+{
+    char search[MAX_SEARCH];
+    memcpy(search, b->matches.search, length);
+    MatchIndexBuild(b, search, length);
+}
+
+void MatchIndexUpdateRow(Buffer *b, int row)
+{
+    MatchIndex *idx = &b->matches;
+    Assert(idx->job == NULL);
+    if (idx->needleLength == 0)
+        return;
+
+    int start = MatchIndexLowerBound(b, row, 0);
+    int end = MatchIndexLowerBound(b, row + 1, 0);
+
+    lineMatches.count = 0;
+    searchLine(idx, idx->regex, &idx->searcher, &b->lines[row], row, &lineMatches);
+    int n = lineMatches.count;
+
+    // Make room for the new matches of row and move the rest
+    reserve(idx, idx->count - (end - start) + n);
+    memmove(idx->matches + start + n, idx->matches + end, (idx->count - end) * sizeof(Match));
+    memcpy(idx->matches + start, lineMatches.matches, n * sizeof(Match));
+    idx->count += n - (end - start);
+}
+
+void MatchIndexInsertRow(Buffer *b, int row)
+{
+    MatchIndex *idx = &b->matches;
+    Assert(idx->job == NULL);
+    if (idx->needleLength == 0)
+        return;
+
+    for (int i = MatchIndexLowerBound(b, row, 0); i < idx->count; i++)
+        idx->matches[i].row++;
+
+    MatchIndexUpdateRow(b, row);
+}
+
+void MatchIndexDeleteRow(Buffer *b, int row)
+{
+    MatchIndex *idx = &b->matches;
+    Assert(idx->job == NULL);
+    if (idx->count == 0)
+        return;
+
+    int start = MatchIndexLowerBound(b, row, 0);
+    int end = MatchIndexLowerBound(b, row + 1, 0);
+
+    memmove(idx->matches + start, idx->matches + end, (idx->count - end) * sizeof(Match));
+    idx->count -= end - start;
+
+    for (int i = start; i < idx->count; i++)
+        idx->matches[i].row--;
+}
+
+Match *MatchIndexSearchRow(Buffer *b, int row, int *count)
+{
+    MatchIndex *idx = &b->matches;
+    lineMatches.count = 0;
+    if (idx->needleLength > 0)
+        searchLine(idx, idx->regex, &idx->searcher, &b->lines[row], row, &lineMatches);
+
+    *count = lineMatches.count;
+    return lineMatches.matches;
+}
+
+void MatchIndexFree(Buffer *b)
+{
+    stopJob(&b->matches);
+    if (b->matches.matches != NULL)
+        MemFree(b->matches.matches);
+    RegexFree(b->matches.regex);
+
+    b->matches = (MatchIndex){0};
+}
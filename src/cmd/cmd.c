@@ -9,12 +9,17 @@ static void printHelp()
     printf("  -v --version  print version         \n");
     printf("  -h --help     display help menu     \n");
     printf("     --raw      enable visual raw mode\n");
+    printf("     --headless <script>                \n");
+    printf("                render to an in-memory  \n");
+    printf("                terminal, read keys from\n");
+    printf("                script and print a report\n");
+    printf("     --size WxH size of headless terminal\n");
 }
 
 CmdOptions ProcessArgs(int argc, char **argv)
 {
     CmdOptions err = {.shouldExit = true};
-    CmdOptions ops = {0};
+    CmdOptions ops = {.width = HEADLESS_WIDTH, .height = HEADLESS_HEIGHT};
 
     for (int i = 1; i < argc; i++)
     {
@@ -39,6 +44,23 @@ CmdOptions ProcessArgs(int argc, char **argv)
             continue;
         }
 
+        if (is("--headless") && i + 1 < argc)
+        {
+            ops.headless = true;
+            strncpy(ops.script, argv[++i], MAX_PATH - 1);
+            continue;
+        }
+
+        if (is("--size") && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%dx%d", &ops.width, &ops.height) != 2 || ops.width < 1 || ops.height < 3)
+            {
+                printf("Error: Invalid size '%s', expected WxH\n", argv[i]);
+                return err;
+            }
+            continue;
+        }
+
         if (arg[0] == '-')
         {
             printf("Error: Unkown option '%s' \n", arg);
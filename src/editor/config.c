@@ -1,20 +1,25 @@
 #include "rum.h"
 
+extern Config config;
+
 #define wordSize 32 // Size of token lexemes
 
+#define pathSize 512 // Size of config file paths
+
+// Writes path of file in the directory of the executable to dest.
+static void configPath(char *dest, const char *file)
+{
+    // Concat path to executable with filepath
+    IoExeDir(dest, pathSize);
+    strncat(dest, file, pathSize - strlen(dest) - 1);
+}
+
 // Looks for files in the directory of the executable, eg. config, runtime etc.
 // Returns pointer to file data, NULL on error. Writes to size. Remember to free!
 char *ReadConfigFile(const char *file, int *size)
 {
-    const int pathSize = 512;
-
-    // Concat path to executable with filepath
     char path[pathSize];
-    int len = GetModuleFileNameA(NULL, path, pathSize);
-    for (int i = len; i > 0 && path[i] != '\\'; i--)
-        path[i] = 0;
-
-    strcat(path, file);
+    configPath(path, file);
     return IoReadFile(path, size);
 }
 
@@ -65,16 +70,27 @@ bool next(reader *r, token *dest)
     memset(dest->word, 0, wordSize);
     char word[wordSize] = {0};
     int length = 0;
+    int escaped = 0; // Number of escape backslashes in string
     bool isNumber = false;
     bool isString = false;
 
     for (int i = r->pos; i < r->size; i++)
     {
-        if (length >= wordSize)
+        if (length >= wordSize - 1)
             goto write_token;
 
         char c = r->file[i];
 
+        // Escaped character in string, eg. \"
+        if (isString && c == '\\' && i + 1 < r->size)
+        {
+            c = r->file[++i];
+            strncat(word, &c, 1);
+            length++;
+            escaped++;
+            continue;
+        }
+
         if (c == '"')
         {
             if (isString)
@@ -122,7 +138,7 @@ write_token:
 
         dest->len = length;
         strncpy(dest->word, word, wordSize);
-        r->pos += length;
+        r->pos += length + escaped;
     }
     else
     {
@@ -189,6 +205,47 @@ void expect_string(reader *r, token *t, char *dest)
     strncpy(dest, t->word, wordSize);
 }
 
+// Same as expect_string but copies at most size-1 characters to dest.
+void expect_string_n(reader *r, token *t, char *dest, int size)
+{
+    char word[wordSize];
+    expect_string(r, t, word);
+    memset(dest, 0, size);
+    strncpy(dest, word, size - 1);
+}
+
+// Reads colon and opening bracket of array. Returns false if value is not an array.
+bool expect_array(reader *r, token *t)
+{
+    next(r, t); // Colon
+    next(r, t); // Left square
+
+    if (t->type != T_LSQUARE)
+    {
+        Error("Expected array");
+        return false;
+    }
+
+    return true;
+}
+
+// Reads next string in array. Returns false at the end of the array.
+bool next_array_string(reader *r, token *t)
+{
+    while (next(r, t))
+    {
+        if (t->type == T_COMMA)
+            continue;
+        if (t->type == T_STRING)
+            return true;
+        if (t->type != T_RSQUARE)
+            Error("Expected string in array");
+        return false;
+    }
+
+    return false;
+}
+
 // Loads config file and writes to given config. Sets default config
 // if file failed to open.
 Error LoadConfig(Config *config)
@@ -198,6 +255,10 @@ Error LoadConfig(Config *config)
     config->syntaxEnabled = true;
     config->matchParen = true;
     config->useCRLF = true;
+    config->syncOutput = false;
+    config->colorDepth = COLOR_DEPTH_TRUE;
+    config->relativeNumbers = false;
+    config->searchCase = SEARCH_CASE_EXACT;
     strcpy(config->theme, RUM_DEFAULT_THEME);
 
     reader r;
@@ -225,6 +286,32 @@ Error LoadConfig(Config *config)
                 expect_string(&r, &t, config->theme);
             else if (isword("syntaxEnabled"))
                 config->syntaxEnabled = expect_bool(&r, &t);
+            else if (isword("syncOutput"))
+                config->syncOutput = expect_bool(&r, &t);
+            else if (isword("relativeNumbers"))
+                config->relativeNumbers = expect_bool(&r, &t);
+            else if (isword("colorDepth"))
+            {
+                char depth[wordSize];
+                expect_string(&r, &t, depth);
+                if (!strcmp(depth, "256"))
+                    config->colorDepth = COLOR_DEPTH_256;
+                else if (!strcmp(depth, "16"))
+                    config->colorDepth = COLOR_DEPTH_16;
+                else
+                    config->colorDepth = COLOR_DEPTH_TRUE;
+            }
+            else if (isword("searchCase"))
+            {
+                char mode[wordSize];
+                expect_string(&r, &t, mode);
+                if (!strcmp(mode, "ignore"))
+                    config->searchCase = SEARCH_CASE_IGNORE;
+                else if (!strcmp(mode, "smart"))
+                    config->searchCase = SEARCH_CASE_SMART;
+                else
+                    config->searchCase = SEARCH_CASE_EXACT;
+            }
             else
                 Errorf("Unknown key %s", t.word);
             continue;
@@ -269,7 +356,7 @@ bool hex_to_rgb(char *src, char *dest, char *default_v)
     }
 
     // Cannot be bigger than 255 so long is fine
-    sprintf_s(dest, 16, "%03ld;%03ld;%03ld", nums[0], nums[1], nums[2]);
+    snprintf(dest, 16, "%03ld;%03ld;%03ld", nums[0], nums[1], nums[2]);
     return true;
 
 fail:
@@ -277,11 +364,23 @@ fail:
     return false;
 }
 
-// Loads theme data into colors.
+// Replaces "rrr;ggg;bbb" color with the nearest color in the configured palette,
+// so colors look the same in the editor as they do on the terminal.
+static void quantizeColor(char *color)
+{
+    int r, g, b;
+    if (config.colorDepth == COLOR_DEPTH_TRUE || sscanf(color, "%d;%d;%d", &r, &g, &b) != 3)
+        return;
+
+    unsigned rgb = ScreenQuantizeColor((r << 16) | (g << 8) | b, config.colorDepth);
+    sprintf(color, "%03d;%03d;%03d", (rgb >> 16) & 0xff, (rgb >> 8) & 0xff, rgb & 0xff);
+}
+
+// Loads theme data into colors. Colors are quantized to the color depth in config.
 Error LoadTheme(char *name, Colors *colors)
 {
     char path[128];
-    sprintf_s(path, 128, "./config/themes/%s.json", name);
+    snprintf(path, 128, "./config/themes/%s.json", name);
 
     reader r;
     token t;
@@ -290,6 +389,8 @@ Error LoadTheme(char *name, Colors *colors)
     if (err != NIL)
         return err;
 
+    colors->version++; // Invalidates cached renders
+
     next(&r, &t); // RBRACE
 
     while (next(&r, &t))
@@ -313,6 +414,7 @@ Error LoadTheme(char *name, Colors *colors)
         char colorRGB[32] = {0};
         if (!hex_to_rgb(colorHex, colorRGB, "0;0;0"))
             return ERR_CONFIG_PARSE_FAIL;
+        quantizeColor(colorRGB);
 
 #define set_color(n, dest)                   \
     if (!strncmp(n, name, wordSize))         \
@@ -347,3 +449,139 @@ Error LoadTheme(char *name, Colors *colors)
     Log("Theme loaded");
     return NIL;
 }
+
+// Loads a single language definition from config/syntax.
+static Error loadLanguage(const char *filepath)
+{
+    reader r;
+    token t;
+
+    Error err = readerFromFile((char *)filepath, &r);
+    if (err != NIL)
+        return err;
+
+    Language lang;
+    SyntaxInitLanguage(&lang);
+
+    char words[SYNTAX_MAX_KEYWORDS][SYNTAX_WORD_SIZE];
+    byte kinds[SYNTAX_MAX_KEYWORDS];
+    int numWords = 0;
+
+    char chars[wordSize];
+
+    next(&r, &t); // RBRACE
+
+    while (next(&r, &t))
+    {
+        if (t.type == T_COMMA)
+            continue;
+        if (t.type == T_RBRACE)
+            break;
+
+        if (t.type != T_STRING)
+        {
+            Error("expected string");
+            break;
+        }
+
+        if (isword("name"))
+            expect_string_n(&r, &t, lang.name, SYNTAX_NAME_LEN);
+        else if (isword("comment"))
+            expect_string_n(&r, &t, lang.comment, SYNTAX_COMMENT_SIZE);
+        else if (isword("blockCommentStart"))
+            expect_string_n(&r, &t, lang.blockCommentStart, SYNTAX_COMMENT_SIZE);
+        else if (isword("blockCommentEnd"))
+            expect_string_n(&r, &t, lang.blockCommentEnd, SYNTAX_COMMENT_SIZE);
+        else if (isword("macroPrefix"))
+            expect_string_n(&r, &t, lang.macroPrefix, SYNTAX_COMMENT_SIZE);
+        else if (isword("includeWord"))
+            expect_string_n(&r, &t, lang.includeWord, SYNTAX_COMMENT_SIZE);
+        else if (isword("functions"))
+            lang.functions = expect_bool(&r, &t);
+        else if (isword("userTypes"))
+            lang.userTypes = expect_bool(&r, &t);
+
+#define char_class(n, class)                              \
+    else if (isword(n))                                   \
+    {                                                     \
+        expect_string_n(&r, &t, chars, wordSize);         \
+        SyntaxSetCharClass(&lang, chars, class);          \
+    }
+
+        char_class("strings", CC_STRING)
+        char_class("brackets", CC_BRACKET)
+        char_class("symbols", CC_SYMBOL)
+        char_class("numberChars", CC_NUMBER)
+        char_class("wordChars", CC_WORD_START | CC_WORD)
+
+        else if (isword("extensions"))
+        {
+            if (!expect_array(&r, &t))
+                break;
+            while (next_array_string(&r, &t))
+                if (lang.numExtensions < SYNTAX_MAX_EXTENSIONS)
+                    strncpy(lang.extensions[lang.numExtensions++], t.word, FILE_EXTENSION_SIZE - 1);
+        }
+        else if (isword("objectPrefixes"))
+        {
+            if (!expect_array(&r, &t))
+                break;
+            while (next_array_string(&r, &t))
+                if (lang.numObjectPrefixes < SYNTAX_MAX_PREFIXES)
+                    strncpy(lang.objectPrefixes[lang.numObjectPrefixes++], t.word, SYNTAX_COMMENT_SIZE - 1);
+        }
+        else if (isword("keywords") || isword("types"))
+        {
+            byte kind = isword("keywords") ? WORD_KEYWORD : WORD_TYPE;
+            if (!expect_array(&r, &t))
+                break;
+            while (next_array_string(&r, &t))
+            {
+                if (numWords == SYNTAX_MAX_KEYWORDS)
+                    continue;
+                strncpy(words[numWords], t.word, SYNTAX_WORD_SIZE);
+                kinds[numWords++] = kind;
+            }
+        }
+        else
+            Errorf("Unknown key %s", t.word);
+    }
+
+    MemFree(r.file);
+
+    if (t.type != T_RBRACE || strlen(lang.name) == 0)
+        return ERR_CONFIG_PARSE_FAIL;
+
+    if (!SyntaxCompileKeywords(&lang, words, kinds, numWords) || !SyntaxAddLanguage(&lang))
+        return ERR_CONFIG_PARSE_FAIL;
+
+    return NIL;
+}
+
+// Loads all language definitions in config/syntax.
+Error LoadLanguages()
+{
+    char dir[pathSize];
+    configPath(dir, RUM_SYNTAX_DIR);
+
+    int count;
+    DirEntry *files = IoListDir(dir, &count);
+    if (files == NULL)
+        return ERR_FILE_NOT_FOUND;
+
+    for (int i = 0; i < count; i++)
+    {
+        int length = strlen(files[i].name);
+        if (files[i].isDir || length < 5 || strcmp(files[i].name + length - 5, ".json"))
+            continue;
+
+        char path[pathSize];
+        snprintf(path, pathSize, RUM_SYNTAX_DIR "/%s", files[i].name);
+        if (loadLanguage(path) != NIL)
+            Errorf("Failed to load language file %s", files[i].name);
+    }
+
+    MemFree(files);
+    Log("Languages loaded");
+    return NIL;
+}
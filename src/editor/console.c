@@ -0,0 +1,123 @@
+// Win32 console backend. Renders to a separate console screen buffer and reads
+// input records from stdin.
+
+#include "rum.h"
+
+#ifdef _WIN32
+
+static HANDLE hbuffer; // Created screen buffer
+static HANDLE hstdin;  // Console input
+
+static Error consoleInit()
+{
+    system("color"); // Turn on escape code output
+
+    hstdin = GetStdHandle(STD_INPUT_HANDLE);
+    if (hstdin == INVALID_HANDLE_VALUE)
+        return ERR_INPUT_READ_FAIL;
+
+    // Create new temp console buffer and set as active
+    hbuffer = CreateConsoleScreenBuffer(GENERIC_WRITE | GENERIC_READ, 0, NULL, 1, NULL);
+    if (hbuffer == INVALID_HANDLE_VALUE)
+        return ERR_INPUT_READ_FAIL;
+
+    SetConsoleActiveScreenBuffer(hbuffer);
+
+    // Flush input of possible junk and set raw input mode (0)
+    FlushConsoleInputBuffer(hstdin);
+    SetConsoleMode(hstdin, 0);
+
+    SetConsoleTitleA(TITLE);
+    TermWrite("\033[?12l", 6); // Turn off cursor blinking
+    return NIL;
+}
+
+static void consoleFree()
+{
+    CloseHandle(hbuffer);
+}
+
+static void consoleGetSize(int *width, int *height)
+{
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    GetConsoleScreenBufferInfo(hbuffer, &info);
+
+    short bufferW = info.dwSize.X;
+    short windowH = info.srWindow.Bottom - info.srWindow.Top + 1;
+
+    // Remove scrollbar by setting buffer height to window height
+    COORD newSize;
+    newSize.X = bufferW;
+    newSize.Y = windowH;
+    SetConsoleScreenBufferSize(hbuffer, newSize);
+
+    *width = (int)(newSize.X);
+    *height = (int)(newSize.Y);
+}
+
+static void consoleWrite(char *string, int length)
+{
+    DWORD written;
+    if (!WriteConsoleA(hbuffer, string, length, &written, NULL) || (int)written != length)
+        Panicf("Failed to write to screen buffer. Length %d, written %d", length, (int)written);
+}
+
+static int consoleReadInput(InputInfo *events, int max, bool block)
+{
+    DWORD available = 0;
+    if (!block && (!GetNumberOfConsoleInputEvents(hstdin, &available) || available == 0))
+        return 0;
+
+    INPUT_RECORD records[INPUT_QUEUE_SIZE];
+    DWORD read;
+    DWORD size = min(max, INPUT_QUEUE_SIZE);
+    if (size == 0)
+        return 0;
+
+    if (!ReadConsoleInputA(hstdin, records, size, &read) || read == 0)
+    {
+        Errorf("Failed to read from input handle. WinError: %d", (int)GetLastError());
+        return -1;
+    }
+
+    int n = 0;
+    for (int i = 0; i < (int)read && n < max; i++)
+    {
+        InputInfo info = {.eventType = INPUT_UNKNOWN};
+        INPUT_RECORD record = records[i];
+
+        if (record.EventType == KEY_EVENT && record.Event.KeyEvent.bKeyDown)
+        {
+            KEY_EVENT_RECORD event = record.Event.KeyEvent;
+            info.eventType = INPUT_KEYDOWN;
+            info.keyCode = event.wVirtualKeyCode;
+            info.asciiChar = event.uChar.AsciiChar;
+            info.ctrlDown = event.dwControlKeyState & LEFT_CTRL_PRESSED;
+
+            // Key repeat is reported as one record with a repeat count
+            for (int r = 0; r < max(event.wRepeatCount, 1) && n < max; r++)
+                events[n++] = info;
+        }
+        else if (record.EventType == WINDOW_BUFFER_SIZE_EVENT)
+        {
+            info.eventType = INPUT_WINDOW_RESIZE;
+            events[n++] = info;
+        }
+    }
+
+    return n;
+}
+
+TermBackend TermConsoleBackend()
+{
+    return (TermBackend){
+        .name = "console",
+        .init = consoleInit,
+        .free = consoleFree,
+        .getSize = consoleGetSize,
+        .write = consoleWrite,
+        .readInput = consoleReadInput,
+    };
+}
+
+#endif
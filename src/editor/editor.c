@@ -8,8 +8,6 @@ Editor editor = {0}; // Global editor instance used in core module
 Colors colors = {0}; // Global constant color palette loaded from theme.json
 Config config = {0}; // Global constant config loaded from config.json
 
-char _renderBuffer[RENDER_BUFFER_SIZE];
-
 // Populates editor global struct and creates empty file buffer. Exits on error.
 void EditorInit(CmdOptions options)
 {
@@ -17,33 +15,24 @@ void EditorInit(CmdOptions options)
 
     // IMPORTANT: Order matters
     // 1. Create buffer before loading file from options
-    // 2. Set CSB and renderbuffer before any rendering
-    //    Note: will blame heapFree if handles are invalid
-
-    system("color"); // Turn on escape code output
-
-    editor.hstdin = GetStdHandle(STD_INPUT_HANDLE);
-    Assert(!(editor.hstdin == INVALID_HANDLE_VALUE));
+    // 2. Set terminal and renderbuffer before any rendering
 
     // Buffers used for rendering
-    memset(editor.padBuffer, ' ', PAD_BUFFER_SIZE);
-    editor.renderBuffer = _renderBuffer;
-    AssertNotNull(editor.renderBuffer);
-
-    // Create new temp console buffer and set as active
-    editor.hbuffer = CreateConsoleScreenBuffer(GENERIC_WRITE | GENERIC_READ, 0, NULL, 1, NULL);
-    Assert(!(editor.hbuffer == INVALID_HANDLE_VALUE));
+    EditorPadding(PAD_BUFFER_SIZE);
+    CbStoreReserve(&editor.renderStore, CB_CHUNK_SIZE);
 
-    // Set as active buffer and get the size of it
-    SetConsoleActiveScreenBuffer(editor.hbuffer);
-    TermUpdateSize(editor);
+#ifdef _WIN32
+    TermBackend terminal = TermConsoleBackend();
+#else
+    TermBackend terminal = TermPosixBackend();
+#endif
 
-    // Flush input of possible junk and set raw input mode (0)
-    FlushConsoleInputBuffer(editor.hstdin);
-    SetConsoleMode(editor.hstdin, 0);
+    TermBackend backend = options.headless
+                              ? TermHeadlessBackend(options.script, options.width, options.height)
+                              : terminal;
 
-    SetConsoleTitleA(TITLE);
-    ScreenWrite("\033[?12l", 6); // Turn off cursor blinking
+    if (TermInit(backend) != NIL)
+        ErrorExit("Failed to initialize terminal");
 
     // Set up editor and handle config/options
     EditorNewBuffer();
@@ -56,6 +45,9 @@ void EditorInit(CmdOptions options)
     if (LoadTheme(config.theme, &colors) != NIL)
         ErrorExit("Failed to load default theme");
 
+    if (LoadLanguages() != NIL)
+        Error("Failed to load syntax files");
+
     if (options.hasFile && EditorOpenFile(options.filename) != NIL)
         ErrorExitf("File '%s' not found", options.filename);
 
@@ -97,38 +89,93 @@ void EditorFree()
         BufferFree(editor.buffers[i]);
     }
 
-    CloseHandle(editor.hbuffer);
+    CbStoreFree(&editor.renderStore);
+    MemFree(editor.padBuffer);
+    TermFree();
     Log("Editor free successful");
 }
 
-Error EditorReadInput(InputInfo *info)
+// Input events are read from the terminal in batches and queued, so all pending
+// events can be handled before the next render.
+static InputInfo inputQueue[INPUT_QUEUE_SIZE];
+static int queueHead = 0;
+static int queueLength = 0;
+static bool resizeQueued = false;
+
+bool EditorQueueInput(InputInfo info)
 {
-    INPUT_RECORD record;
-    DWORD read;
-    if (!ReadConsoleInputA(editor.hstdin, &record, 1, &read) || read == 0)
-    {
-        Errorf("Failed to read from input handle. WinError: %d", (int)GetLastError());
+    // Size is read when the event is handled, so one resize is enough
+    if (info.eventType == INPUT_WINDOW_RESIZE && resizeQueued)
+        return true;
+
+    if (queueLength == INPUT_QUEUE_SIZE)
+        return false;
+
+    inputQueue[(queueHead + queueLength) % INPUT_QUEUE_SIZE] = info;
+    queueLength++;
+    if (info.eventType == INPUT_WINDOW_RESIZE)
+        resizeQueued = true;
+    return true;
+}
+
+// Reads available terminal events into the queue. Blocks until there is at
+// least one event if block is true.
+static Error readTerminalInput(bool block)
+{
+    InputInfo events[INPUT_QUEUE_SIZE];
+    int n = TermReadInput(events, INPUT_QUEUE_SIZE - queueLength, block);
+    if (n < 0)
         return ERR_INPUT_READ_FAIL;
-    }
 
-    info->eventType = INPUT_UNKNOWN;
+    for (int i = 0; i < n; i++)
+        EditorQueueInput(events[i]);
+
+    return NIL;
+}
+
+bool EditorHasInput()
+{
+    if (queueLength == 0)
+        readTerminalInput(false);
+    return queueLength > 0;
+}
+
+bool EditorPeekInput(InputInfo *info)
+{
+    if (!EditorHasInput())
+        return false;
+
+    *info = inputQueue[queueHead];
+    return true;
+}
 
-    if (record.EventType == KEY_EVENT && record.Event.KeyEvent.bKeyDown)
+Error EditorReadInput(InputInfo *info)
+{
+    if (!EditorHasInput())
     {
-        KEY_EVENT_RECORD event = record.Event.KeyEvent;
-        info->eventType = INPUT_KEYDOWN;
-        info->keyCode = event.wVirtualKeyCode;
-        info->asciiChar = event.uChar.AsciiChar;
-        info->ctrlDown = event.dwControlKeyState & LEFT_CTRL_PRESSED;
+        // Everything drawn since last input is written to the terminal in one go
+        ScreenFlush();
+
+        while (queueLength == 0)
+        {
+            Error err = readTerminalInput(true);
+            if (err != NIL)
+                return err;
+        }
     }
-    else if (record.EventType == WINDOW_BUFFER_SIZE_EVENT)
-        info->eventType = INPUT_WINDOW_RESIZE;
+
+    *info = inputQueue[queueHead];
+    queueHead = (queueHead + 1) % INPUT_QUEUE_SIZE;
+    queueLength--;
+
+    if (info->eventType == INPUT_WINDOW_RESIZE)
+        resizeQueued = false;
 
     return NIL;
 }
 
-// Waits for input and takes action for insert mode.
-Error EditorHandleInput()
+// Reads a single input event and takes action for the current mode.
+static Error handleInputEvent()
 {
     InputInfo info;
 
@@ -198,6 +245,20 @@ Error EditorHandleInput()
     return NIL; // Unhandled event
 }
 
+// Waits for input and handles all pending events, so the editor only renders
+// once after a burst of events like key repeat, pasting or resizing.
+Error EditorHandleInput()
+{
+    do
+    {
+        Error err = handleInputEvent();
+        if (err != NIL)
+            return err;
+    } while (EditorHasInput());
+
+    return NIL;
+}
+
 // Loads file into current buffer. Filepath must either be an absolute path
 // or name of a file in the same directory as working directory.
 Error EditorOpenFile(char *filepath)
@@ -245,6 +306,10 @@ void EditorPromptCommand()
     if (status != UI_OK || cmdLen == 0)
         return;
 
+    // The pattern of a substitute may contain spaces
+    if (ReplaceCommand(cmdBuf))
+        return;
+
     // Split command string by spaces
     char *args[MAX_ARGS];
     int argc = 0;
@@ -294,7 +359,7 @@ void EditorPromptCommand()
 
     IS_COMMAND("q", {
         EditorFree();
-        ExitProcess(0);
+        exit(0);
     })
 
     IS_COMMAND("w", {
@@ -305,8 +370,22 @@ void EditorPromptCommand()
         EditorShowHelp();
     })
 
+    IS_COMMAND("grep", {
+        if (argc < 2 || argc > 3)
+            SetError("usage: grep [pattern] [directory?]");
+        else
+            EditorGrep(args[1], argc == 3 ? args[2] : ".");
+    })
+
+    IS_COMMAND("index", {
+        if (argc > 2)
+            SetError("usage: index [directory?]");
+        else if (!IndexBuild(argc == 2 ? args[1] : ".", NULL))
+            SetError("failed to write index");
+    })
+
     IS_COMMAND("noh", {
-        BufferUnmarkAll(curBuffer);
+        MatchIndexClear(curBuffer);
     })
 
     IS_COMMAND("theme", {
@@ -384,6 +463,19 @@ void EditorShowHelp()
     UiTextbox(HELP_TEXT);
 }
 
+char *EditorPadding(int length)
+{
+    if (length <= editor.padSize)
+        return editor.padBuffer;
+
+    int size = max(length, PAD_BUFFER_SIZE);
+    editor.padBuffer = editor.padBuffer == NULL ? MemAlloc(size) : MemRealloc(editor.padBuffer, size);
+    AssertNotNull(editor.padBuffer);
+    memset(editor.padBuffer, ' ', size);
+    editor.padSize = size;
+    return editor.padBuffer;
+}
+
 int EditorNewBuffer()
 {
     if (editor.numBuffers == EDITOR_BUFFER_CAP)
@@ -420,7 +512,7 @@ void EditorUnsplitBuffers()
 void EditorSetActiveBuffer(int idx)
 {
     EditorSetMode(MODE_EDIT); // This is also a hack to reset visual mode when switching buffers
-    if (editor.buffers[idx]->isDir)
+    if (editor.buffers[idx]->isDir || editor.buffers[idx]->isResults)
         EditorSetMode(MODE_EXPLORE);
     editor.activeBuffer = idx;
 }
@@ -473,66 +565,97 @@ void EditorPromptTabSwap()
         EditorSwapActiveBuffer(res.choice);
 }
 
-void EditorOpenFileExplorer()
-{
-    EditorOpenFileExplorerEx(".");
-}
+#define GREP_POLL_MS 10 // How often results are shown while searching
 
-void EditorOpenFileExplorerEx(char *directory)
+void EditorGrep(char *pattern, char *dir)
 {
-    SetCurrentDirectoryA(directory);
+    Grep *g = GrepStart(pattern, strlen(pattern), dir);
+    if (g == NULL)
+    {
+        SetError("invalid pattern");
+        return;
+    }
 
-    char *helpText = "<space> go into   <b> go back";
+    char header[MAX_SEARCH + MAX_PATH + 16];
+    char fullPath[PATH_MAX];
+    if (!IoGetCwd(fullPath, PATH_MAX))
+        strcpy(fullPath, ".");
+    int headerLen = snprintf(header, sizeof(header), "grep %s in %s", pattern, dir);
 
-    Buffer *exBuf = BufferNew();
-    exBuf->exPaths = StrArrayNew(KB(0.5));
+    Buffer *b = BufferNew();
+    b->exPaths = StrArrayNew(KB(4));
+    BufferInsertLineEx(b, 0, header, headerLen);
+    BufferInsertLineEx(b, 1, "searching...", 12);
 
-    char fullPath[PATH_MAX + 2];
-    GetCurrentDirectoryA(PATH_MAX, fullPath);
-    strcat(fullPath, "/*");
+    snprintf(b->filepath, MAX_PATH, "%s", StrGetShortPath(fullPath));
+    b->isResults = true;
+    b->readOnly = true;
 
-    // Itrerate over files in directory and write to buffer
-    WIN32_FIND_DATAA file;
-    HANDLE hFind = FindFirstFileA(fullPath, &file);
-    char lineFormatString[1024];
-    int numDirs = 0; // Keeping track of dir count for sorting
+    replaceCurrentBuffer(b);
+    EditorSetMode(MODE_EXPLORE);
 
-    do
+    // Results are shown as they come. Escape stops the search, other keys
+    // are handled when it is done.
+    double start = TimeNow();
+    bool stopped = false;
+    while (!GrepRead(g, b))
     {
-        bool isDir = file.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY;
+        InputInfo info;
+        if (EditorPeekInput(&info) && info.eventType == INPUT_KEYDOWN && info.keyCode == K_ESCAPE)
+        {
+            EditorReadInput(&info);
+            stopped = true;
+            break;
+        }
 
-        UINT64 fileSize = (UINT64)file.nFileSizeLow | ((UINT64)file.nFileSizeHigh << 32);
-        char fileSizeS[64];
-        StrNumberToReadable(fileSize, fileSizeS);
+        Render();
+        ScreenFlush();
+        TimeSleep(GREP_POLL_MS);
+    }
 
-        // Get modification date as dd.mm.yyyy
-        char date[64];
-        SYSTEMTIME sysTime;
-        FileTimeToSystemTime(&file.ftLastWriteTime, &sysTime);
-        GetDateFormatA(LOCALE_CUSTOM_DEFAULT, 0, &sysTime, NULL, date, 64);
+    GrepStats stats = GrepGetStats(g);
+    GrepFree(g);
 
-        char *filename = file.cFileName;
-        int filenameLen = strlen(file.cFileName);
-        int lineLen = sprintf(lineFormatString, "%s %s %s", fileSizeS, date, filename);
-        int row = isDir ? (++numDirs) : -1; // Sorting by directories first
+    char skipped[64] = "";
+    if (stats.skipped > 0)
+        snprintf(skipped, sizeof(skipped), ", %d ruled out by index", stats.skipped);
 
-        Line *line = BufferInsertLineEx(exBuf, row, lineFormatString, lineLen);
-        line->exPathId = StrArraySet(&exBuf->exPaths, filename, filenameLen);
-        line->isPath = true;
-        line->isDir = isDir;
+    int summaryLen = snprintf(header, sizeof(header), "%d matches in %d files, %d binary skipped%s, %.0f ms%s",
+                              stats.matches, stats.files, stats.binary, skipped, (TimeNow() - start) * 1e3,
+                              stats.truncated ? ", stopped at limit" : stopped ? ", stopped" : "");
+    BufferDeleteLine(b, 1);
+    BufferInsertLineEx(b, 1, header, summaryLen);
 
-    } while (FindNextFileA(hFind, &file));
-    FindClose(hFind);
+    // First result
+    CursorSetPos(b, 0, min(3, b->numLines - 1), false);
+    BufferScroll(b);
+}
 
+void EditorOpenFileExplorer()
+{
+    EditorOpenFileExplorerEx(".");
+}
+
+#define LIST_POLL_MS 10 // How often entries are shown while listing a directory
+
+void EditorOpenFileExplorerEx(char *directory)
+{
+    IoSetCwd(directory);
+
+    char *helpText = "<space> go into   <b> go back";
+
+    Buffer *exBuf = BufferNew();
+    exBuf->exPaths = StrArrayNew(KB(0.5));
+
+    char fullPath[PATH_MAX];
+    IoGetCwd(fullPath, PATH_MAX);
+
+    // Entries go after the path, help text and an empty line
     BufferInsertLineEx(exBuf, 0, helpText, strlen(helpText));
     BufferInsertLine(exBuf, 0);
+    BufferInsertLineEx(exBuf, 0, fullPath, strlen(fullPath));
 
-    // Add path to buffer
-    {
-        int fullPathLen = strlen(fullPath);
-        fullPath[fullPathLen - 2] = 0; // Remove \* used for search
-        BufferInsertLineEx(exBuf, 0, fullPath, fullPathLen - 2);
-    }
+    DirList *list = DirListStart(fullPath);
 
     // Configure buffer
     strcpy(exBuf->filepath, StrGetShortPath(fullPath)); // Do not use fullPath after this
@@ -542,6 +665,33 @@ void EditorOpenFileExplorerEx(char *directory)
     replaceCurrentBuffer(exBuf);
     EditorSetMode(MODE_EXPLORE);
 
+    // Entries are shown as they are listed. Escape stops listing, other keys
+    // are handled when it is done. Small directories are done before the
+    // first render.
+    double lastRender = TimeNow();
+    while (!DirListRead(list, exBuf))
+    {
+        InputInfo info;
+        if (EditorPeekInput(&info) && info.eventType == INPUT_KEYDOWN && info.keyCode == K_ESCAPE)
+        {
+            EditorReadInput(&info);
+            DirListStop(list);
+            DirListRead(list, exBuf);
+            break;
+        }
+
+        if (TimeNow() - lastRender >= LIST_POLL_MS / 1e3)
+        {
+            Render();
+            ScreenFlush();
+            lastRender = TimeNow();
+        }
+
+        TimeSleep(1);
+    }
+
+    DirListFree(list);
+
     // Set cursor at first dir for convenience
     CursorSetPos(exBuf, 999, 4, false);
     BufferScroll(exBuf);
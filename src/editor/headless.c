@@ -0,0 +1,409 @@
+// Headless terminal backend. Output is interpreted by a small in-memory VT
+// terminal, covering the escapes written by the screen, and input is read from
+// a key script. Used to measure and test rendering without a real terminal.
+//
+// Script format: every byte is a key, except newlines which are ignored and
+// named keys in angle brackets: <enter> <esc> <tab> <bs> <del> <space> <up>
+// <down> <left> <right> <pgup> <pgdn> <lt>, <c-x> for ctrl+x and <resize:WxH>.
+
+#include "rum.h"
+
+typedef struct scriptEvent
+{
+    InputInfo info;
+    int width, height; // New size for resize events
+} scriptEvent;
+
+typedef struct headless
+{
+    int width, height;
+    char *cells;
+    int x, y;
+    int top, bottom; // Scroll region
+    bool pendingWrap;
+    bool cursorVisible;
+
+    scriptEvent *events;
+    int numEvents;
+    int nextEvent;
+
+    int frames;
+    long long bytes;
+    int maxBytes;
+    double frameTime;
+    double maxFrameTime;
+    double lastInput; // Time last input was read, frame time is measured from here
+} headless;
+
+static headless term = {0};
+static char *scriptPath = NULL;
+
+static void resize(int width, int height)
+{
+    if (term.cells != NULL)
+        MemFree(term.cells);
+
+    term.width = width;
+    term.height = height;
+    term.cells = MemAlloc(width * height);
+    AssertNotNull(term.cells);
+    memset(term.cells, ' ', width * height);
+
+    term.x = term.y = 0;
+    term.top = 0;
+    term.bottom = height - 1;
+    term.pendingWrap = false;
+}
+
+static struct
+{
+    char *name;
+    KeyCode keyCode;
+    char asciiChar;
+} keyNames[] = {
+    {"enter", K_ENTER, '\r'},
+    {"esc", K_ESCAPE, 27},
+    {"tab", K_TAB, '\t'},
+    {"bs", K_BACKSPACE, 8},
+    {"del", K_DELETE, 0},
+    {"space", K_SPACE, ' '},
+    {"up", K_ARROW_UP, 0},
+    {"down", K_ARROW_DOWN, 0},
+    {"left", K_ARROW_LEFT, 0},
+    {"right", K_ARROW_RIGHT, 0},
+    {"pgup", K_PAGEUP, 0},
+    {"pgdn", K_PAGEDOWN, 0},
+    {"lt", 0, '<'},
+};
+
+// Parses named key at s, after the '<'. Returns false if it is not a valid name.
+static bool parseNamedKey(char *s, int length, scriptEvent *e)
+{
+    if (length == 3 && s[0] == 'c' && s[1] == '-' && isalpha(s[2]))
+    {
+        e->info = (InputInfo){
+            .eventType = INPUT_KEYDOWN,
+            .keyCode = toupper(s[2]),
+            .asciiChar = tolower(s[2]) - 96,
+            .ctrlDown = true,
+        };
+        return true;
+    }
+
+    if (length > 7 && !strncmp(s, "resize:", 7))
+    {
+        e->info = (InputInfo){.eventType = INPUT_WINDOW_RESIZE};
+        return sscanf(s + 7, "%dx%d", &e->width, &e->height) == 2 && e->width > 0 && e->height > 2;
+    }
+
+    for (int i = 0; i < (int)(sizeof(keyNames) / sizeof(keyNames[0])); i++)
+    {
+        if ((int)strlen(keyNames[i].name) == length && !strncmp(s, keyNames[i].name, length))
+        {
+            e->info = (InputInfo){
+                .eventType = INPUT_KEYDOWN,
+                .keyCode = keyNames[i].keyCode,
+                .asciiChar = keyNames[i].asciiChar,
+            };
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static Error loadScript(char *path)
+{
+    int size;
+    char *script = IoReadFile(path, &size);
+    if (script == NULL)
+        return ERR_FILE_NOT_FOUND;
+
+    term.events = MemAlloc(max(size, 1) * sizeof(scriptEvent));
+    AssertNotNull(term.events);
+
+    for (int i = 0; i < size; i++)
+    {
+        char c = script[i];
+        if (c == '\n' || c == '\r')
+            continue;
+
+        scriptEvent e = {.info = TermCharEvent(c)};
+
+        char *end = c == '<' ? memchr(script + i, '>', size - i) : NULL;
+        if (end != NULL && parseNamedKey(script + i + 1, end - script - i - 1, &e))
+            i = end - script;
+
+        term.events[term.numEvents++] = e;
+    }
+
+    MemFree(script);
+    return NIL;
+}
+
+static Error headlessInit()
+{
+    if (term.width <= 0 || term.height <= 0)
+        return ERR_INPUT_READ_FAIL;
+
+    resize(term.width, term.height);
+    term.cursorVisible = true;
+    term.lastInput = TimeNow();
+
+    if (scriptPath != NULL)
+        return loadScript(scriptPath);
+    return NIL;
+}
+
+static void headlessFree()
+{
+    if (term.cells != NULL)
+        MemFree(term.cells);
+    if (term.events != NULL)
+        MemFree(term.events);
+    term = (headless){0};
+}
+
+static void headlessGetSize(int *width, int *height)
+{
+    *width = term.width;
+    *height = term.height;
+}
+
+// Scrolls rows top to bottom up by n, or down if n is negative.
+static void scrollRegion(int n)
+{
+    int w = term.width;
+    int rows = term.bottom - term.top + 1;
+    n = clamp(-rows, rows, n);
+
+    char *region = term.cells + term.top * w;
+    int moved = rows - abs(n);
+
+    if (n > 0)
+        memmove(region, region + n * w, moved * w);
+    else
+        memmove(region - n * w, region, moved * w);
+
+    memset(n > 0 ? region + moved * w : region, ' ', abs(n) * w);
+}
+
+static void lineFeed()
+{
+    if (term.y == term.bottom)
+        scrollRegion(1);
+    else if (term.y < term.height - 1)
+        term.y++;
+}
+
+static void put(char c)
+{
+    if (term.pendingWrap)
+    {
+        term.x = 0;
+        lineFeed();
+        term.pendingWrap = false;
+    }
+
+    term.cells[term.y * term.width + term.x] = c;
+
+    // Cursor stays on the last column until the next character, like a VT100
+    if (term.x == term.width - 1)
+        term.pendingWrap = true;
+    else
+        term.x++;
+}
+
+// Handles control sequence starting after ESC [. Returns number of bytes read.
+static int controlSequence(char *s, int length)
+{
+    int params[8] = {0};
+    int numParams = 0;
+    bool isPrivate = false;
+    bool hasParam = false;
+
+    for (int i = 0; i < length; i++)
+    {
+        char c = s[i];
+
+        if (c == '?')
+            isPrivate = true;
+        else if (c >= '0' && c <= '9')
+        {
+            params[numParams] = params[numParams] * 10 + (c - '0');
+            hasParam = true;
+        }
+        else if (c == ';')
+        {
+            numParams = min(numParams + 1, 7);
+            hasParam = true;
+        }
+        else if (c >= 0x40 && c <= 0x7e)
+        {
+            numParams += hasParam;
+            int p1 = numParams > 0 && params[0] > 0 ? params[0] : 1;
+            int p2 = numParams > 1 && params[1] > 0 ? params[1] : 1;
+
+            switch (c)
+            {
+            case 'H':
+                term.y = clamp(0, term.height - 1, p1 - 1);
+                term.x = clamp(0, term.width - 1, p2 - 1);
+                term.pendingWrap = false;
+                break;
+
+            case 'C':
+                term.x = clamp(0, term.width - 1, term.x + p1);
+                term.pendingWrap = false;
+                break;
+
+            case 'r':
+                term.top = clamp(0, term.height - 1, p1 - 1);
+                term.bottom = numParams > 1 ? clamp(term.top, term.height - 1, params[1] - 1) : term.height - 1;
+                term.x = term.y = 0;
+                term.pendingWrap = false;
+                break;
+
+            case 'S':
+                scrollRegion(p1);
+                break;
+
+            case 'T':
+                scrollRegion(-p1);
+                break;
+
+            case 'J':
+                if (params[0] == 2)
+                    memset(term.cells, ' ', term.width * term.height);
+                break;
+
+            case 'K':
+                memset(term.cells + term.y * term.width + term.x, ' ', term.width - term.x);
+                break;
+
+            case 'h':
+            case 'l':
+                if (isPrivate && params[0] == 25)
+                    term.cursorVisible = c == 'h';
+                break;
+
+            default: // Colors and unknown sequences do not change the text
+                break;
+            }
+
+            return i + 1;
+        }
+    }
+
+    return length;
+}
+
+static void headlessWrite(char *string, int length)
+{
+    double elapsed = TimeNow() - term.lastInput;
+
+    for (int i = 0; i < length; i++)
+    {
+        char c = string[i];
+
+        if (c == '\x1b')
+        {
+            if (i + 1 < length && string[i + 1] == '[')
+                i += 1 + controlSequence(string + i + 2, length - i - 2);
+            else
+                i++; // Two byte escape
+            continue;
+        }
+
+        if (c == '\r')
+        {
+            term.x = 0;
+            term.pendingWrap = false;
+        }
+        else if (c == '\n')
+            lineFeed();
+        else
+            put(c);
+    }
+
+    term.frames++;
+    term.bytes += length;
+    term.maxBytes = max(term.maxBytes, length);
+    term.frameTime += elapsed;
+    term.maxFrameTime = max(term.maxFrameTime, elapsed);
+}
+
+static int headlessReadInput(InputInfo *events, int max, bool block)
+{
+    if (term.nextEvent == term.numEvents)
+    {
+        if (!block)
+            return 0;
+
+        // Nothing left to do, the last frame has been written
+        HeadlessReport();
+        TermFree();
+        exit(EXIT_SUCCESS);
+    }
+
+    int n = 0;
+    while (n < max && term.nextEvent < term.numEvents)
+    {
+        scriptEvent e = term.events[term.nextEvent++];
+        events[n++] = e.info;
+
+        // Terminal has the new size when the event is read
+        if (e.info.eventType == INPUT_WINDOW_RESIZE)
+        {
+            resize(e.width, e.height);
+            break;
+        }
+    }
+
+    term.lastInput = TimeNow();
+    return n;
+}
+
+TermBackend TermHeadlessBackend(char *script, int width, int height)
+{
+    scriptPath = script;
+    term.width = width;
+    term.height = height;
+
+    return (TermBackend){
+        .name = "headless",
+        .init = headlessInit,
+        .free = headlessFree,
+        .getSize = headlessGetSize,
+        .write = headlessWrite,
+        .readInput = headlessReadInput,
+    };
+}
+
+char *HeadlessRow(int y)
+{
+    Assert(y >= 0 && y < term.height);
+    return term.cells + y * term.width;
+}
+
+void HeadlessReport()
+{
+    int frames = max(term.frames, 1);
+
+    printf("frames      %d\n", term.frames);
+    printf("events      %d\n", term.nextEvent);
+    printf("bytes       %lld total, %lld avg, %d max per frame\n", term.bytes, term.bytes / frames, term.maxBytes);
+    printf("frame time  %.3f ms avg, %.3f ms max\n", term.frameTime * 1e3 / frames, term.maxFrameTime * 1e3);
+    printf("cursor      %d,%d %s\n", term.x, term.y, term.cursorVisible ? "visible" : "hidden");
+    printf("screen      %dx%d\n", term.width, term.height);
+
+    for (int y = 0; y < term.height; y++)
+    {
+        // Trailing spaces are trimmed
+        char *row = HeadlessRow(y);
+        int length = term.width;
+        while (length > 0 && row[length - 1] == ' ')
+            length--;
+        printf("%.*s\n", length, row);
+    }
+}
@@ -6,6 +6,7 @@ char HELP_TEXT[] = "GLOBAL KEYBINDS\n" SEPARATOR
                    "    ctrl-s    Save\n"
                    "    ctrl-c    Enter edit mode\n"
                    "    ctrl-o    Open file explorer\n"
+                   "    ctrl-p    Find file by typing parts of its path, f in the explorer\n"
                    "    ctrl-n    New file\n"
                    "    ctrl-z    Undo\n"
                    "    ctrl-x    Delete line\n"
@@ -29,6 +30,18 @@ char HELP_TEXT[] = "GLOBAL KEYBINDS\n" SEPARATOR
                    "    spaces              Use spaces for indentation\n"
                    "    tabs                Use tabs for indentation\n"
                    "    hl [extension]      Set a file type to use for highlighting\n"
+                   "    grep [text] [dir]   Search files under dir, enter on a result opens it\n"
+                   "    index [dir]         Write or update a trigram index that makes grep faster\n"
+                   "    s/old/new/[g]       Replace on the cursor line, g replaces all on a line\n"
+                   "    %s/old/new/[g]      Replace in all lines, or 10,20s/old/new/ for a range\n"
+                   "\n\n"
+                   "SEARCH (ctrl-f or / in edit mode)\n" SEPARATOR
+                   "\n"
+                   "    Text is matched literally. Start with \\v to search with a regex:\n"
+                   "    . [abc] [^a-z] \\d \\w \\s * + ? {n,m} | ( ) ^ $\n"
+                   "    \\c anywhere ignores case and \\C matches case. searchCase in the\n"
+                   "    config sets the default: exact, ignore or smart (ignore unless the\n"
+                   "    search has an uppercase letter).\n"
                    "\n\n"
                    "EDIT MODE (ctrl-c)\n" SEPARATOR
                    "\n"
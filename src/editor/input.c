@@ -11,7 +11,7 @@ bool HandleCtrlInputs(InputInfo *info)
     {
     case 'q':
         EditorFree();
-        ExitProcess(0);
+        exit(0);
         break;
 
     case 'y':
@@ -64,6 +64,10 @@ bool HandleCtrlInputs(InputInfo *info)
         EditorOpenFileExplorer();
         break;
 
+    case 'p':
+        FinderPrompt();
+        break;
+
     case 'h':
         EditorSetActiveBuffer(editor.leftBuffer);
         break;
@@ -561,6 +565,12 @@ static void selectDirectory()
     if (!curLine.isPath)
         return;
 
+    if (curBuffer->isResults)
+    {
+        GrepJump();
+        return;
+    }
+
     char *path = BufferGetLinePath(curBuffer, &curLine);
     if (curLine.isDir)
         EditorOpenFileExplorerEx(path);
@@ -589,6 +599,10 @@ Error HandleExploreMode(InputInfo *info)
         EditorOpenFileExplorerEx("..");
         break;
 
+    case 'f':
+        FinderPrompt();
+        break;
+
     default:
         break;
     }
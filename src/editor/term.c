@@ -1,40 +1,55 @@
+// Terminal functions used by the editor. Output and input go through the
+// backend selected at startup, see console.c, termios.c and headless.c.
+
 #include "rum.h"
 
 extern Editor editor;
 
-void TermUpdateSize()
-{
-    CONSOLE_SCREEN_BUFFER_INFO info;
-    GetConsoleScreenBufferInfo(editor.hbuffer, &info);
+static TermBackend backend = {0};
 
-    short bufferW = info.dwSize.X;
-    short windowH = info.srWindow.Bottom - info.srWindow.Top + 1;
+Error TermInit(TermBackend b)
+{
+    backend = b;
+    Error err = backend.init();
+    if (err != NIL)
+        return err;
+
+    Logf("Using %s terminal", backend.name);
+    TermUpdateSize();
+    return NIL;
+}
 
-    // Remove scrollbar by setting buffer height to window height
-    COORD newSize;
-    newSize.X = bufferW;
-    newSize.Y = windowH;
-    SetConsoleScreenBufferSize(editor.hbuffer, newSize);
+void TermFree()
+{
+    if (backend.free != NULL)
+        backend.free();
+    backend = (TermBackend){0};
+}
 
-    editor.width = (int)(newSize.X);
-    editor.height = (int)(newSize.Y);
+void TermUpdateSize()
+{
+    backend.getSize(&editor.width, &editor.height);
 }
 
-void TermSetCursorPos(int x, int y)
+void TermWrite(char *string, int length)
 {
-    COORD pos = {x, y};
-    SetConsoleCursorPosition(editor.hbuffer, pos);
+    backend.write(string, length);
 }
 
-void TermSetCursorVisible(bool visible)
+int TermReadInput(InputInfo *events, int max, bool block)
 {
-    CONSOLE_CURSOR_INFO info = {100, visible};
-    SetConsoleCursorInfo(editor.hbuffer, &info);
+    return backend.readInput(events, max, block);
 }
 
-void TermWrite(char *string, int length)
+InputInfo TermCharEvent(char c)
 {
-    DWORD written;
-    if (!WriteConsoleA(editor.hbuffer, string, length, &written, NULL) || (int)written != length)
-        Panicf("Failed to write to screen buffer. Length %d, written %d", length, (int)written);
-}
\ No newline at end of file
+    KeyCode code = 0;
+    if (isalnum(c))
+        code = toupper(c);
+    else if (c == ' ')
+        code = K_SPACE;
+    else if (c == ':')
+        code = K_COLON;
+
+    return (InputInfo){.eventType = INPUT_KEYDOWN, .keyCode = code, .asciiChar = c};
+}
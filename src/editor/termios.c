@@ -0,0 +1,267 @@
+// POSIX terminal backend. Puts the terminal in raw mode, renders to the
+// alternate screen and parses key escape sequences from stdin. Resizes are
+// reported by SIGWINCH.
+
+#include "rum.h"
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define ALT_SCREEN_ENTER "\x1b[?1049h"
+#define ALT_SCREEN_LEAVE "\x1b[?1049l"
+#define CURSOR_SHOW "\x1b[?25h"
+
+static struct termios original; // Restored on exit
+static bool rawMode = false;
+static volatile sig_atomic_t resized = 0;
+
+// Writes all of string to stdout, retrying on partial writes.
+static void writeAll(char *string, int length)
+{
+    while (length > 0)
+    {
+        ssize_t n = write(STDOUT_FILENO, string, length);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            Panicf("Failed to write to terminal. Length %d, errno %d", length, errno);
+        }
+
+        string += n;
+        length -= n;
+    }
+}
+
+static void restoreTerminal()
+{
+    if (!rawMode)
+        return;
+
+    char *s = COL_RESET CURSOR_SHOW ALT_SCREEN_LEAVE;
+    writeAll(s, strlen(s));
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &original);
+    rawMode = false;
+}
+
+static void onResize(int sig)
+{
+    (void)sig;
+    resized = 1;
+}
+
+static Error posixInit()
+{
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO))
+        return ERR_INPUT_READ_FAIL;
+
+    if (tcgetattr(STDIN_FILENO, &original) == -1)
+        return ERR_INPUT_READ_FAIL;
+
+    // Raw input, no echo, no signals from ctrl keys and no output processing
+    struct termios raw = original;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_oflag &= ~(OPOST);
+    raw.c_cflag |= CS8;
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+
+    if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == -1)
+        return ERR_INPUT_READ_FAIL;
+
+    rawMode = true;
+    atexit(restoreTerminal); // Editor exits without calling TermFree
+
+    // No SA_RESTART, so a blocking poll returns when the window is resized
+    struct sigaction sa = {0};
+    sa.sa_handler = onResize;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGWINCH, &sa, NULL);
+
+    char *s = ALT_SCREEN_ENTER "\x1b]0;" TITLE "\x07"
+                               "\x1b[?12l"; // Turn off cursor blinking
+    writeAll(s, strlen(s));
+    return NIL;
+}
+
+static void posixFree()
+{
+    signal(SIGWINCH, SIG_DFL);
+    restoreTerminal();
+}
+
+static void posixGetSize(int *width, int *height)
+{
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == -1 || ws.ws_col == 0)
+    {
+        *width = 80;
+        *height = 24;
+        return;
+    }
+
+    *width = ws.ws_col;
+    *height = ws.ws_row;
+}
+
+static void posixWrite(char *string, int length)
+{
+    writeAll(string, length);
+}
+
+static InputInfo keyEvent(KeyCode code, char c)
+{
+    return (InputInfo){.eventType = INPUT_KEYDOWN, .keyCode = code, .asciiChar = c};
+}
+
+// Parses one key at s. Writes event to info and returns number of bytes used.
+static int parseKey(byte *s, int length, InputInfo *info)
+{
+    byte c = s[0];
+
+    if (c == 27)
+    {
+        // A lone escape, or escape followed by another key, is the escape key.
+        // Sequences are written by the terminal at once so they are never split.
+        if (length < 3 || (s[1] != '[' && s[1] != 'O'))
+        {
+            *info = keyEvent(K_ESCAPE, 27);
+            return 1;
+        }
+
+        // Control sequence: parameters followed by a final byte
+        int end = 2;
+        while (end < length && (s[end] < 0x40 || s[end] > 0x7e))
+            end++;
+        if (end == length)
+        {
+            *info = keyEvent(K_ESCAPE, 27);
+            return 1;
+        }
+
+        *info = (InputInfo){.eventType = INPUT_UNKNOWN};
+        switch (s[end])
+        {
+        case 'A':
+            *info = keyEvent(K_ARROW_UP, 0);
+            break;
+        case 'B':
+            *info = keyEvent(K_ARROW_DOWN, 0);
+            break;
+        case 'C':
+            *info = keyEvent(K_ARROW_RIGHT, 0);
+            break;
+        case 'D':
+            *info = keyEvent(K_ARROW_LEFT, 0);
+            break;
+        case '~':
+            if (s[2] == '3')
+                *info = keyEvent(K_DELETE, 0);
+            else if (s[2] == '5')
+                *info = keyEvent(K_PAGEUP, 0);
+            else if (s[2] == '6')
+                *info = keyEvent(K_PAGEDOWN, 0);
+            break;
+        }
+
+        return end + 1;
+    }
+
+    if (c == '\r' || c == '\n')
+        *info = keyEvent(K_ENTER, '\r');
+    else if (c == '\t')
+        *info = keyEvent(K_TAB, '\t');
+    else if (c == 127 || c == 8)
+        *info = keyEvent(K_BACKSPACE, 8);
+    else if (c >= 1 && c <= 26)
+    {
+        // Ctrl+letter, reported like the console does
+        *info = keyEvent('A' + c - 1, c);
+        info->ctrlDown = true;
+    }
+    else
+        *info = TermCharEvent(c);
+
+    return 1;
+}
+
+static int posixReadInput(InputInfo *events, int max, bool block)
+{
+    // Bytes read but not yet parsed because events was full
+    static byte pending[INPUT_QUEUE_SIZE];
+    static int numPending = 0;
+
+    if (max == 0)
+        return 0;
+
+    if (resized)
+    {
+        resized = 0;
+        events[0] = (InputInfo){.eventType = INPUT_WINDOW_RESIZE};
+        return 1;
+    }
+
+    if (numPending == 0)
+    {
+        struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+        int ready = poll(&pfd, 1, block ? -1 : 0);
+        if (ready == -1 && errno == EINTR)
+            return posixReadInput(events, max, block); // Interrupted by resize
+        if (ready == -1)
+        {
+            Errorf("Failed to poll input. errno %d", errno);
+            return -1;
+        }
+        if (ready == 0)
+            return 0;
+
+        ssize_t length = read(STDIN_FILENO, pending, INPUT_QUEUE_SIZE);
+        if (length == -1 && errno == EINTR)
+            return posixReadInput(events, max, block);
+        if (length <= 0)
+        {
+            Errorf("Failed to read input. errno %d", errno);
+            return -1;
+        }
+
+        numPending = length;
+    }
+
+    int n = 0;
+    int i = 0;
+    while (i < numPending && n < max)
+    {
+        InputInfo info;
+        i += parseKey(pending + i, numPending - i, &info);
+        if (info.eventType != INPUT_UNKNOWN)
+            events[n++] = info;
+    }
+
+    numPending -= i;
+    memmove(pending, pending + i, numPending);
+
+    if (n == 0 && block) // Only unknown sequences
+        return posixReadInput(events, max, block);
+    return n;
+}
+
+TermBackend TermPosixBackend()
+{
+    return (TermBackend){
+        .name = "posix",
+        .init = posixInit,
+        .free = posixFree,
+        .getSize = posixGetSize,
+        .write = posixWrite,
+        .readInput = posixReadInput,
+    };
+}
+
+#endif
@@ -108,6 +108,61 @@ void UndoJoin(int n)
     undoListAppend(&curBuffer->undos, a);
 }
 
+void UndoAddLine(UndoLines *lines, int row, char *text, int length)
+{
+    int size = 2 * sizeof(int) + length;
+    if (lines->length + size > lines->cap)
+    {
+        lines->cap = max(lines->cap * 2, lines->length + size);
+        lines->data = lines->data == NULL ? MemAlloc(lines->cap) : MemRealloc(lines->data, lines->cap);
+        AssertNotNull(lines->data);
+    }
+
+    char *p = lines->data + lines->length;
+    memcpy(p, &row, sizeof(int));
+    memcpy(p + sizeof(int), &length, sizeof(int));
+    memcpy(p + 2 * sizeof(int), text, length);
+    lines->length += size;
+}
+
+void UndoSaveLines(UndoLines *lines, int row, int col)
+{
+    EditorAction action = {
+        .type = A_LINES,
+        .row = row,
+        .col = col,
+        .textLen = lines->length,
+        .isLongText = true,
+        .longText = lines->data,
+    };
+
+    undoListAppend(&curBuffer->undos, action);
+}
+
+// Puts back the old text of each line saved with UndoAddLine.
+static void undoLines(char *data, int length)
+{
+    int searchLen = MatchIndexPause(curBuffer);
+
+    char *p = data;
+    while (p < data + length)
+    {
+        int row, textLen;
+        memcpy(&row, p, sizeof(int));
+        memcpy(&textLen, p + sizeof(int), sizeof(int));
+        p += 2 * sizeof(int);
+
+        int cap = (textLen / LINE_DEFAULT_LENGTH + 1) * LINE_DEFAULT_LENGTH;
+        char *chars = MemZeroAlloc(cap);
+        AssertNotNull(chars);
+        memcpy(chars, p, textLen);
+        MemFree(BufferSwapLine(curBuffer, row, chars, textLen, cap));
+        p += textLen;
+    }
+
+    MatchIndexResume(curBuffer, searchLen);
+}
+
 void Undo()
 {
     if (curBuffer->undos.length == 0)
@@ -155,7 +210,7 @@ void Undo()
 
     case A_BACKSPACE:
     {
-        BufferWriteEx(curBuffer, a.row, a.col, strrev(undoText), a.textLen);
+        BufferWriteEx(curBuffer, a.row, a.col, StrReverse(undoText), a.textLen);
         CursorSetPos(curBuffer, a.col + a.textLen, a.row, false);
         break;
     }
@@ -184,6 +239,13 @@ void Undo()
         break;
     }
 
+    case A_LINES:
+    {
+        undoLines(undoText, a.textLen);
+        CursorSetPos(curBuffer, a.col, a.row, false);
+        break;
+    }
+
     default:
         Errorf("Undo not implemented for action: %d", a.type);
     }
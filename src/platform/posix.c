@@ -0,0 +1,356 @@
+// POSIX implementation of the platform layer: memory, time, files, directories,
+// threads and the clipboard.
+
+#include "rum.h"
+
+#ifndef _WIN32
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+double TimeNow()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+void *MemAlloc(int size)
+{
+    return malloc(size);
+}
+
+void *MemZeroAlloc(int size)
+{
+    return calloc(1, size);
+}
+
+void *MemRealloc(void *ptr, int newSize)
+{
+    // Zero the grown part to match HeapReAlloc with HEAP_ZERO_MEMORY
+    size_t oldSize = ptr != NULL ? malloc_usable_size(ptr) : 0;
+    char *p = realloc(ptr, newSize);
+    if (p != NULL && (size_t)newSize > oldSize)
+        memset(p + oldSize, 0, newSize - oldSize);
+    return p;
+}
+
+void MemFree(void *ptr)
+{
+    free(ptr);
+}
+
+bool IoFileExists(char *filepath)
+{
+    return access(filepath, F_OK) == 0;
+}
+
+char *IoReadFile(const char *filepath, int *size)
+{
+    int fd = open(filepath, O_RDONLY);
+    if (fd == -1)
+    {
+        Errorf("Failed to open file '%s'", filepath);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || S_ISDIR(st.st_mode))
+    {
+        Errorf("Failed to open file '%s'", filepath);
+        close(fd);
+        return NULL;
+    }
+
+    // Read file contents into string buffer
+    int bufSize = st.st_size + 1;
+    char *buffer = MemAlloc(bufSize);
+    int total = 0;
+
+    while (total < bufSize - 1)
+    {
+        ssize_t n = read(fd, buffer + total, bufSize - 1 - total);
+        if (n == 0)
+            break;
+        if (n == -1)
+        {
+            Errorf("Failed to read file '%s'", filepath);
+            MemFree(buffer);
+            close(fd);
+            return NULL;
+        }
+        total += n;
+    }
+
+    close(fd);
+    *size = total;
+    buffer[total] = 0;
+    return buffer;
+}
+
+char *IoMapFile(const char *filepath, int *size)
+{
+    int fd = open(filepath, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size == 0 || st.st_size > INT_MAX)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // The mapping stays valid after the file is closed
+    char *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return NULL;
+
+    *size = st.st_size;
+    return data;
+}
+
+void IoUnmapFile(char *data, int size)
+{
+    munmap(data, size);
+}
+
+bool IoWriteFile(const char *filepath, char *data, int size)
+{
+    // Open file - truncate existing and write
+    int fd = open(filepath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        Error("failed to open file");
+        return false;
+    }
+
+    int total = 0;
+    while (total < size)
+    {
+        ssize_t n = write(fd, data + total, size - total);
+        if (n == -1)
+        {
+            Error("failed to write to file");
+            close(fd);
+            return false;
+        }
+        total += n;
+    }
+
+    close(fd);
+    return true;
+}
+
+static int compareEntries(const void *a, const void *b)
+{
+    return strcmp(((DirEntry *)a)->name, ((DirEntry *)b)->name);
+}
+
+DirEntry *IoListDir(const char *dir, int *count)
+{
+    DirReader *d = IoOpenDir(dir);
+    if (d == NULL)
+        return NULL;
+
+    int cap = 64;
+    int n = 0;
+    DirEntry *entries = MemAlloc(cap * sizeof(DirEntry));
+    AssertNotNull(entries);
+
+    while (true)
+    {
+        if (n == cap)
+        {
+            cap *= 2;
+            entries = MemRealloc(entries, cap * sizeof(DirEntry));
+            AssertNotNull(entries);
+        }
+
+        if (!IoReadDir(d, &entries[n]))
+            break;
+        n++;
+    }
+
+    IoCloseDir(d);
+
+    // Sorted by name, like FindFirstFile on NTFS
+    qsort(entries, n, sizeof(DirEntry), compareEntries);
+    *count = n;
+    return entries;
+}
+
+struct DirReader
+{
+    DIR *dir;
+    char path[PATH_MAX];
+};
+
+DirReader *IoOpenDir(const char *dir)
+{
+    DIR *handle = opendir(dir);
+    if (handle == NULL)
+        return NULL;
+
+    DirReader *d = MemAlloc(sizeof(DirReader));
+    AssertNotNull(d);
+    d->dir = handle;
+    snprintf(d->path, PATH_MAX, "%s", dir);
+    return d;
+}
+
+bool IoReadDir(DirReader *d, DirEntry *e)
+{
+    struct dirent *file = readdir(d->dir);
+    if (file == NULL)
+        return false;
+
+    strncpy(e->name, file->d_name, MAX_PATH - 1);
+    e->name[MAX_PATH - 1] = 0;
+    e->isDir = false;
+    e->isLink = file->d_type == DT_LNK;
+    e->size = 0;
+    e->modified = 0;
+
+    char path[PATH_MAX + MAX_PATH];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s", d->path, file->d_name);
+    if (file->d_type == DT_UNKNOWN && lstat(path, &st) == 0)
+        e->isLink = S_ISLNK(st.st_mode);
+
+    // Follow symlinks so linked directories can be opened
+    if (stat(path, &st) == 0)
+    {
+        e->isDir = S_ISDIR(st.st_mode);
+        e->size = st.st_size;
+        e->modified = st.st_mtime;
+    }
+
+    return true;
+}
+
+void IoCloseDir(DirReader *d)
+{
+    closedir(d->dir);
+    MemFree(d);
+}
+
+long long IoModifiedTime(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 ? st.st_mtime : -1;
+}
+
+bool IoSetCwd(const char *dir)
+{
+    return chdir(dir) == 0;
+}
+
+bool IoGetCwd(char *dest, int size)
+{
+    return getcwd(dest, size) != NULL;
+}
+
+void IoExeDir(char *dest, int size)
+{
+    int len = readlink("/proc/self/exe", dest, size - 1);
+    if (len <= 0)
+    {
+        snprintf(dest, size, "./");
+        return;
+    }
+
+    dest[len] = 0;
+    for (int i = len; i > 0 && dest[i] != '/'; i--)
+        dest[i] = 0;
+}
+
+struct Thread
+{
+    pthread_t handle;
+    ThreadFunc func;
+    void *arg;
+};
+
+static void *threadMain(void *arg)
+{
+    Thread *t = arg;
+    t->func(t->arg);
+    return NULL;
+}
+
+Thread *ThreadStart(ThreadFunc func, void *arg)
+{
+    Thread *t = MemAlloc(sizeof(Thread));
+    if (t == NULL)
+        return NULL;
+
+    t->func = func;
+    t->arg = arg;
+    if (pthread_create(&t->handle, NULL, threadMain, t) != 0)
+    {
+        MemFree(t);
+        return NULL;
+    }
+
+    return t;
+}
+
+void ThreadJoin(Thread *thread)
+{
+    pthread_join(thread->handle, NULL);
+    MemFree(thread);
+}
+
+int CpuCount()
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? n : 1;
+}
+
+void TimeSleep(int ms)
+{
+    struct timespec t = {.tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L};
+    nanosleep(&t, NULL);
+}
+
+// There is no system clipboard without a display server, so copied text is
+// kept in the editor and only shared between buffers.
+static char *clipboard = NULL;
+
+String GetClipboardText()
+{
+    if (clipboard == NULL)
+        return NULL_STRING;
+
+    int length = strlen(clipboard);
+    char *string = MemAlloc(length + 1);
+    memcpy(string, clipboard, length + 1);
+
+    return (String){
+        .s = string,
+        .length = length,
+        .null = false,
+    };
+}
+
+void SetClipboardText(const char *text)
+{
+    int length = strlen(text);
+    char *copy = MemAlloc(length + 1);
+    if (copy == NULL)
+        return;
+
+    memcpy(copy, text, length + 1);
+    MemFree(clipboard);
+    clipboard = copy;
+}
+
+#endif
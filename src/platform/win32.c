@@ -0,0 +1,383 @@
+// Win32 implementation of the platform layer: memory, time, files, directories,
+// threads and the clipboard.
+
+#include "rum.h"
+
+#ifdef _WIN32
+
+double TimeNow()
+{
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+}
+
+void *MemAlloc(int size)
+{
+    return HeapAlloc(GetProcessHeap(), 0, size);
+}
+
+void *MemZeroAlloc(int size)
+{
+    return HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, size);
+}
+
+void *MemRealloc(void *ptr, int newSize)
+{
+    return HeapReAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, ptr, newSize);
+}
+
+void MemFree(void *ptr)
+{
+    HeapFree(GetProcessHeap(), 0, ptr);
+}
+
+bool IoFileExists(char *filepath)
+{
+    return GetFileAttributesA(filepath) != 0xFFFFFFFF;
+}
+
+char *IoReadFile(const char *filepath, int *size)
+{
+    // Open file. EditorOpenFile does not create files and fails on file-not-found
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        Errorf("Failed to open file '%s'", filepath);
+        return NULL;
+    }
+
+    // Get file size and read file contents into string buffer
+    DWORD bufSize = GetFileSize(file, NULL) + 1;
+    DWORD read;
+    char *buffer = MemAlloc(bufSize);
+    if (!ReadFile(file, buffer, bufSize, &read, NULL))
+    {
+        Errorf("Failed to read file '%s'", filepath);
+        CloseHandle(file);
+        return NULL;
+    }
+
+    CloseHandle(file);
+    *size = bufSize - 1;
+    buffer[bufSize - 1] = 0;
+    return buffer;
+}
+
+char *IoMapFile(const char *filepath, int *size)
+{
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0 || fileSize.QuadPart > INT_MAX)
+    {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    // The view keeps the mapping and file open until it is unmapped
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+        return NULL;
+
+    char *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (data == NULL)
+        return NULL;
+
+    *size = (int)fileSize.QuadPart;
+    return data;
+}
+
+void IoUnmapFile(char *data, int size)
+{
+    (void)size;
+    UnmapViewOfFile(data);
+}
+
+bool IoWriteFile(const char *filepath, char *data, int size)
+{
+    // Open file - truncate existing and write
+    HANDLE file = CreateFileA(filepath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        Error("failed to open file");
+        return false;
+    }
+
+    DWORD written;
+    if (!WriteFile(file, data, size, &written, NULL))
+    {
+        Error("failed to write to file");
+        CloseHandle(file);
+        return false;
+    }
+
+    CloseHandle(file);
+    return true;
+}
+
+DirEntry *IoListDir(const char *dir, int *count)
+{
+    DirReader *d = IoOpenDir(dir);
+    if (d == NULL)
+        return NULL;
+
+    int cap = 64;
+    int n = 0;
+    DirEntry *entries = MemAlloc(cap * sizeof(DirEntry));
+    AssertNotNull(entries);
+
+    while (true)
+    {
+        if (n == cap)
+        {
+            cap *= 2;
+            entries = MemRealloc(entries, cap * sizeof(DirEntry));
+            AssertNotNull(entries);
+        }
+
+        if (!IoReadDir(d, &entries[n]))
+            break;
+        n++;
+    }
+
+    IoCloseDir(d);
+    *count = n;
+    return entries;
+}
+
+struct DirReader
+{
+    HANDLE handle;
+    WIN32_FIND_DATAA file;
+    bool first; // FindFirstFile already read the first entry
+};
+
+// FILETIME counts 100ns intervals since 1601
+static long long toUnixTime(FILETIME *ft)
+{
+    UINT64 time = (UINT64)ft->dwLowDateTime | ((UINT64)ft->dwHighDateTime << 32);
+    return (long long)((time - 116444736000000000ULL) / 10000000ULL);
+}
+
+DirReader *IoOpenDir(const char *dir)
+{
+    char pattern[MAX_PATH + 2];
+    snprintf(pattern, sizeof(pattern), "%s\\*", dir);
+
+    DirReader *d = MemAlloc(sizeof(DirReader));
+    AssertNotNull(d);
+
+    d->handle = FindFirstFileA(pattern, &d->file);
+    if (d->handle == INVALID_HANDLE_VALUE)
+    {
+        MemFree(d);
+        return NULL;
+    }
+
+    d->first = true;
+    return d;
+}
+
+bool IoReadDir(DirReader *d, DirEntry *e)
+{
+    if (!d->first && !FindNextFileA(d->handle, &d->file))
+        return false;
+
+    d->first = false;
+    WIN32_FIND_DATAA *file = &d->file;
+    strncpy(e->name, file->cFileName, MAX_PATH - 1);
+    e->name[MAX_PATH - 1] = 0;
+    e->isDir = file->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY;
+    e->isLink = file->dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT;
+    e->size = (UINT64)file->nFileSizeLow | ((UINT64)file->nFileSizeHigh << 32);
+    e->modified = toUnixTime(&file->ftLastWriteTime);
+    return true;
+}
+
+void IoCloseDir(DirReader *d)
+{
+    FindClose(d->handle);
+    MemFree(d);
+}
+
+long long IoModifiedTime(const char *path)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data))
+        return -1;
+
+    return toUnixTime(&data.ftLastWriteTime);
+}
+
+bool IoSetCwd(const char *dir)
+{
+    return SetCurrentDirectoryA(dir);
+}
+
+bool IoGetCwd(char *dest, int size)
+{
+    DWORD length = GetCurrentDirectoryA(size, dest);
+    return length > 0 && (int)length < size;
+}
+
+void IoExeDir(char *dest, int size)
+{
+    int len = GetModuleFileNameA(NULL, dest, size);
+    for (int i = len; i > 0 && dest[i] != '\\'; i--)
+        dest[i] = 0;
+}
+
+struct Thread
+{
+    HANDLE handle;
+    ThreadFunc func;
+    void *arg;
+};
+
+static DWORD WINAPI threadMain(LPVOID arg)
+{
+    Thread *t = arg;
+    t->func(t->arg);
+    return 0;
+}
+
+Thread *ThreadStart(ThreadFunc func, void *arg)
+{
+    Thread *t = MemAlloc(sizeof(Thread));
+    if (t == NULL)
+        return NULL;
+
+    t->func = func;
+    t->arg = arg;
+    t->handle = CreateThread(NULL, 0, threadMain, t, 0, NULL);
+    if (t->handle == NULL)
+    {
+        MemFree(t);
+        return NULL;
+    }
+
+    return t;
+}
+
+void ThreadJoin(Thread *thread)
+{
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    MemFree(thread);
+}
+
+int CpuCount()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return max((int)info.dwNumberOfProcessors, 1);
+}
+
+void TimeSleep(int ms)
+{
+    Sleep(ms);
+}
+
+String GetClipboardText()
+{
+    // Try to open the clipboard
+    if (!OpenClipboard(NULL))
+        return NULL_STRING;
+
+    // Check if clipboard contains text
+    if (!IsClipboardFormatAvailable(CF_TEXT))
+    {
+        CloseClipboard();
+        return NULL_STRING;
+    }
+
+    // Get the clipboard data
+    HANDLE hData = GetClipboardData(CF_TEXT);
+    if (hData == NULL)
+    {
+        CloseClipboard();
+        return NULL_STRING;
+    }
+
+    // Lock the handle to get the actual text pointer
+    char *pszText = (char *)GlobalLock(hData);
+    if (pszText == NULL)
+    {
+        CloseClipboard();
+        return NULL_STRING;
+    }
+
+    // Unlock the clipboard data
+    GlobalUnlock(hData);
+
+    // Close the clipboard
+    CloseClipboard();
+
+    int length = strlen(pszText);
+    char *string = MemAlloc(length + 1);
+    memcpy(string, pszText, length);
+    string[length] = 0;
+
+    return (String){
+        .s = string,
+        .length = length,
+        .null = false,
+    };
+}
+
+void SetClipboardText(const char *text)
+{
+    // Open the clipboard
+    if (!OpenClipboard(NULL))
+        return;
+
+    // Empty the clipboard to remove any existing content
+    if (!EmptyClipboard())
+    {
+        CloseClipboard();
+        return;
+    }
+
+    // Calculate the size of the string
+    size_t len = strlen(text);
+
+    // Allocate global memory for the text (CF_TEXT requires global memory)
+    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, len + 1);
+    if (hMem == NULL)
+    {
+        CloseClipboard();
+        return;
+    }
+
+    // Lock the memory and copy the string to it
+    char *pMem = GlobalLock(hMem);
+    if (pMem != NULL)
+    {
+        memcpy(pMem, text, len);
+        ((char *)pMem)[len] = 0;
+        GlobalUnlock(hMem);
+    }
+    else
+    {
+        GlobalFree(hMem);
+        CloseClipboard();
+        return;
+    }
+
+    // Set the clipboard data with CF_TEXT format
+    if (SetClipboardData(CF_TEXT, hMem) == NULL)
+        GlobalFree(hMem);
+
+    // Close the clipboard
+    CloseClipboard();
+
+    // The clipboard now owns the memory, so we do not need to free it.
+}
+
+#endif
@@ -0,0 +1,326 @@
+// Directory listings for the file explorer. A reader thread lists the
+// directory while the explorer shows the entries found so far, and they are
+// sorted once at the end, directories first. Complete listings are kept in a
+// small cache keyed by the path and modified time of the directory, so going
+// back to a directory does not list it again. Editing a file does not change
+// the modified time of its directory, so the size and date of a cached entry
+// may be out of date until a file in the directory is added, removed or renamed.
+
+#include "rum.h"
+#include <time.h>
+
+#define LIST_BLOCK 4096      // Entries per block read by the reader thread
+#define LIST_MAX_BLOCKS 1024 // Entries after LIST_MAX_BLOCKS * LIST_BLOCK are ignored
+#define LIST_CACHE_SIZE 8    // Listings kept for going back
+#define DATE_CACHE_SIZE 64   // Formatted dates kept, by window
+#define DATE_WINDOW 900      // Time zones and daylight saving change dates on quarter hours only
+
+typedef struct listRow
+{
+    int text;   // Offset of "size date name" in the listing text
+    int length;
+    int name;   // Offset of the name, which ends the text
+    int pathId; // Of the name in the buffer the row was added to
+    bool isDir;
+} listRow;
+
+// Entries of a directory formatted as explorer rows.
+typedef struct listing
+{
+    char path[PATH_MAX];
+    long long modified; // Of the directory before it was listed
+    char *text;         // Row texts, each null terminated
+    int textLen;
+    int textCap;
+    listRow *rows;
+    int numRows;
+    int rowCap;
+} listing;
+
+struct DirList
+{
+    listing *list;
+    bool cached;        // list is owned by the cache and already sorted
+    long long started;  // Unix time the listing started
+    int firstRow;       // Buffer row of the first entry
+    int numShown;       // Rows added to the buffer
+    int numFormatted;   // Entries added to rows
+    bool sorted;
+
+    // Written by the reader, read once numEntries covers them
+    DirEntry *blocks[LIST_MAX_BLOCKS];
+
+    // Accessed atomically
+    int numEntries;
+    bool done;
+    bool cancelled;
+
+    Thread *reader;
+};
+
+typedef struct cachedDate
+{
+    long long window; // Plus one, so zero is an empty slot
+    char text[16];
+} cachedDate;
+
+static listing *cache[LIST_CACHE_SIZE];
+static int nextCache = 0;
+static cachedDate dates[DATE_CACHE_SIZE];
+static char *sortText; // Text of the listing being sorted
+
+static void freeListing(listing *list)
+{
+    if (list == NULL)
+        return;
+
+    if (list->text != NULL)
+        MemFree(list->text);
+    if (list->rows != NULL)
+        MemFree(list->rows);
+    MemFree(list);
+}
+
+static listing *findCached(char *path, long long modified)
+{
+    for (int i = 0; i < LIST_CACHE_SIZE; i++)
+    {
+        listing *list = cache[i];
+        if (list != NULL && list->modified == modified && !strcmp(list->path, path))
+            return list;
+    }
+
+    return NULL;
+}
+
+// Keeps list in the cache, replacing an older listing of the same directory
+// or the oldest one.
+static void addCached(listing *list)
+{
+    int slot = -1;
+    for (int i = 0; i < LIST_CACHE_SIZE; i++)
+    {
+        if (cache[i] != NULL && !strcmp(cache[i]->path, list->path))
+            slot = i;
+    }
+
+    if (slot == -1)
+    {
+        slot = nextCache;
+        nextCache = (nextCache + 1) % LIST_CACHE_SIZE;
+    }
+
+    freeListing(cache[slot]);
+    cache[slot] = list;
+}
+
+// Returns modified as dd.mm.yyyy. Files in a directory tend to be modified on
+// the same few days, so localtime is rarely needed. Times before 1970 are
+// shown as 01.01.1970.
+static char *formatDate(long long modified)
+{
+    long long window = max(modified, 0) / DATE_WINDOW + 1;
+    cachedDate *d = &dates[window % DATE_CACHE_SIZE];
+    if (d->window == window)
+        return d->text;
+
+    time_t t = (time_t)max(modified, 0);
+    struct tm *tm = localtime(&t);
+    if (tm == NULL || !strftime(d->text, sizeof(d->text), "%d.%m.%Y", tm))
+        strcpy(d->text, "??.??.????");
+
+    d->window = window;
+    return d->text;
+}
+
+static void addRow(listing *list, DirEntry *e)
+{
+    char size[64];
+    StrNumberToReadable(e->size, size);
+    char *date = formatDate(e->modified);
+    int nameLen = strlen(e->name);
+
+    int need = list->textLen + strlen(size) + strlen(date) + nameLen + 3;
+    if (need > list->textCap)
+    {
+        list->textCap = max(list->textCap * 2, need);
+        list->text = list->text == NULL ? MemAlloc(list->textCap) : MemRealloc(list->text, list->textCap);
+        AssertNotNull(list->text);
+    }
+
+    if (list->numRows == list->rowCap)
+    {
+        list->rowCap = max(list->rowCap * 2, 64);
+        list->rows = list->rows == NULL ? MemAlloc(list->rowCap * sizeof(listRow))
+                                        : MemRealloc(list->rows, list->rowCap * sizeof(listRow));
+        AssertNotNull(list->rows);
+    }
+
+    listRow *row = &list->rows[list->numRows++];
+    row->text = list->textLen;
+    row->length = sprintf(list->text + row->text, "%s %s %s", size, date, e->name);
+    row->name = row->text + row->length - nameLen;
+    row->pathId = -1;
+    row->isDir = e->isDir;
+    list->textLen += row->length + 1;
+}
+
+// Directories first, then by name
+static int compareRows(const void *a, const void *b)
+{
+    const listRow *ra = a;
+    const listRow *rb = b;
+    if (ra->isDir != rb->isDir)
+        return rb->isDir - ra->isDir;
+
+    return strcmp(sortText + ra->name, sortText + rb->name);
+}
+
+static bool isCancelled(DirList *l)
+{
+    return __atomic_load_n(&l->cancelled, __ATOMIC_RELAXED);
+}
+
+static void readEntries(void *arg)
+{
+    DirList *l = arg;
+    DirReader *d = IoOpenDir(l->list->path);
+
+    while (d != NULL && !isCancelled(l))
+    {
+        int k = l->numEntries;
+        if (k == LIST_MAX_BLOCKS * LIST_BLOCK)
+            break;
+
+        if (k % LIST_BLOCK == 0)
+        {
+            l->blocks[k / LIST_BLOCK] = MemAlloc(LIST_BLOCK * sizeof(DirEntry));
+            AssertNotNull(l->blocks[k / LIST_BLOCK]);
+        }
+
+        if (!IoReadDir(d, &l->blocks[k / LIST_BLOCK][k % LIST_BLOCK]))
+            break;
+
+        __atomic_store_n(&l->numEntries, k + 1, __ATOMIC_RELEASE);
+    }
+
+    if (d != NULL)
+        IoCloseDir(d);
+
+    __atomic_store_n(&l->done, true, __ATOMIC_RELEASE);
+}
+
+DirList *DirListStart(char *dir)
+{
+    DirList *l = MemZeroAlloc(sizeof(DirList));
+    AssertNotNull(l);
+    l->firstRow = -1;
+
+    long long modified = IoModifiedTime(dir);
+    l->list = findCached(dir, modified);
+    if (l->list != NULL)
+    {
+        l->cached = true;
+        l->done = true;
+        return l;
+    }
+
+    l->list = MemZeroAlloc(sizeof(listing));
+    AssertNotNull(l->list);
+    snprintf(l->list->path, PATH_MAX, "%s", dir);
+    l->list->modified = modified;
+    l->started = time(NULL);
+
+    l->reader = ThreadStart(readEntries, l);
+    if (l->reader == NULL)
+        readEntries(l);
+
+    return l;
+}
+
+// Appends rows from numShown to the end of b. Rows keep the path id they got
+// the first time they were added to b.
+static void showRows(DirList *l, Buffer *b)
+{
+    listing *list = l->list;
+    for (; l->numShown < list->numRows; l->numShown++)
+    {
+        listRow *row = &list->rows[l->numShown];
+        if (l->cached || row->pathId == -1)
+            row->pathId = StrArraySet(&b->exPaths, list->text + row->name, row->length - (row->name - row->text));
+
+        Line *line = BufferInsertLineEx(b, -1, list->text + row->text, row->length);
+        line->exPathId = row->pathId;
+        line->isPath = true;
+        line->isDir = row->isDir;
+    }
+}
+
+bool DirListRead(DirList *l, Buffer *b)
+{
+    if (l->sorted)
+        return true;
+
+    if (l->firstRow == -1)
+        l->firstRow = b->numLines;
+
+    // numEntries is final if the reader was done before it was read
+    bool done = __atomic_load_n(&l->done, __ATOMIC_ACQUIRE);
+    int numEntries = __atomic_load_n(&l->numEntries, __ATOMIC_ACQUIRE);
+
+    for (; l->numFormatted < numEntries; l->numFormatted++)
+    {
+        int k = l->numFormatted;
+        addRow(l->list, &l->blocks[k / LIST_BLOCK][k % LIST_BLOCK]);
+    }
+
+    if (!done)
+    {
+        showRows(l, b);
+        return false;
+    }
+
+    if (!l->cached && l->list->numRows > 0)
+    {
+        sortText = l->list->text;
+        qsort(l->list->rows, l->list->numRows, sizeof(listRow), compareRows);
+
+        // Rows shown while listing are replaced in sorted order
+        while (b->numLines > l->firstRow && l->numShown > 0)
+        {
+            BufferDeleteLine(b, -1);
+            l->numShown--;
+        }
+    }
+
+    showRows(l, b);
+    l->sorted = true;
+    return true;
+}
+
+void DirListStop(DirList *l)
+{
+    __atomic_store_n(&l->cancelled, true, __ATOMIC_RELAXED);
+    if (l->reader != NULL)
+        ThreadJoin(l->reader);
+    l->reader = NULL;
+}
+
+void DirListFree(DirList *l)
+{
+    bool complete = !isCancelled(l);
+    DirListStop(l);
+
+    for (int i = 0; i < LIST_MAX_BLOCKS && l->blocks[i] != NULL; i++)
+        MemFree(l->blocks[i]);
+
+    // A directory changed in the same second it was listed may change again
+    // without a new modified time
+    listing *list = l->list;
+    if (!l->cached && complete && l->sorted && list->modified != -1 && list->modified < l->started)
+        addCached(list);
+    else if (!l->cached)
+        freeListing(list);
+
+    MemFree(l);
+}
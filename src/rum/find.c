@@ -3,6 +3,8 @@
 extern Config config;
 extern Editor editor;
 
+#define SEARCH_POLL_MS 2 // How often input is checked while searching
+
 static inline bool isSeperator(char c)
 {
     return !((c >= 'a' && c <= 'z') ||
@@ -143,103 +145,141 @@ int FindPrevBlankLine()
     return 0;
 }
 
-// Returns true if the search was found. Puts position to pos.
-// Dir is 1 for downwards- and -1 for upwards search.
-static bool find(char *search, int length, int dir, int startRow, CursorPos *pos)
+// Makes sure the match index of the current buffer is for search.
+static void useSearch(char *search, int length)
+{
+    MatchIndex *idx = &curBuffer->matches;
+    if (idx->length != length || memcmp(idx->search, search, length))
+        MatchIndexBuild(curBuffer, search, length);
+}
+
+static CursorPos matchPos(int k)
 {
-    char firstc = search[0];
+    Match m = curBuffer->matches.matches[k];
+    return (CursorPos){.row = m.row, .col = m.col};
+}
+
+// Returns first match at or after pos, wrapping around. pos if there is none.
+static CursorPos firstMatch(CursorPos pos)
+{
+    int count = curBuffer->matches.count;
+    if (count == 0)
+        return pos;
 
-    for (int row = startRow;
-         dir == 1 ? (row < curBuffer->numLines) : (row > 0);
-         dir == 1 ? row++ : row--)
+    int k = MatchIndexLowerBound(curBuffer, pos.row, pos.col);
+    return matchPos(k < count ? k : 0);
+}
+
+static void showMatch(CursorPos pos)
+{
+    CursorSetPos(curBuffer, pos.col, pos.row, false);
+    BufferCenterView(curBuffer);
+    Render();
+}
+
+// Searches the whole buffer in the background and shows the first match from
+// pos as soon as it is found. Returns false if a key was pressed before the
+// search finished, the search is then stopped and the index left empty.
+static bool searchAll(char *search, int length, CursorPos pos)
+{
+    MatchIndexStart(curBuffer, search, length, pos);
+
+    bool shown = false;
+    while (!MatchIndexWait(curBuffer, 0))
     {
-        Line line = curBuffer->lines[row];
-        for (int col = 0; col < line.length; col++)
+        if (EditorHasInput())
+        {
+            MatchIndexClear(curBuffer);
+            return false;
+        }
+
+        Match m;
+        if (!shown && MatchIndexFirst(curBuffer, &m))
         {
-            char c = line.chars[col];
-            if (c != firstc || col > line.length - length)
-                continue;
-
-            bool found = true;
-            for (int i = 0; i < length; i++)
-            {
-                if (line.chars[col + i] != search[i])
-                    found = false;
-            }
-
-            if (found)
-            {
-                pos->row = row;
-                pos->col = col;
-                return true;
-            }
+            showMatch((CursorPos){.row = m.row, .col = m.col});
+            UiDrawInputBox("Find", search);
+            ScreenFlush();
+            shown = true;
         }
+
+        TimeSleep(SEARCH_POLL_MS);
     }
 
-    return false;
+    return true;
 }
 
 CursorPos FindNext(char *search, int length)
 {
-    CursorPos pos = curPos;
-    if (!find(search, length, 1, curRow + 1, &pos))
-        find(search, length, 1, 0, &pos);
-    return pos;
+    useSearch(search, length);
+    int count = curBuffer->matches.count;
+    if (count == 0)
+        return curPos;
+
+    // First match after the cursor, wraps to the top
+    int k = MatchIndexLowerBound(curBuffer, curRow, curCol + 1);
+    return matchPos(k < count ? k : 0);
 }
 
 CursorPos FindPrev(char *search, int length)
 {
-    CursorPos pos = curPos;
-    if (!find(search, length, -1, curRow - 1, &pos))
-        find(search, length, -1, curBuffer->numLines - 1, &pos);
-    return pos;
+    useSearch(search, length);
+    int count = curBuffer->matches.count;
+    if (count == 0)
+        return curPos;
+
+    // Last match before the cursor, wraps to the bottom
+    int k = MatchIndexLowerBound(curBuffer, curRow, curCol) - 1;
+    return matchPos(k >= 0 ? k : count - 1);
 }
 
 void FindPrompt()
 {
     CursorPos prevPos = curPos;
 
-    int maxLen = curBuffer->width - 3;
+    int maxLen = min(curBuffer->width - 3, MAX_SEARCH);
     char search[maxLen];
     int searchLen = 0;
 
     curBuffer->showMarkedLines = true;
     curBuffer->showCurrentLineMark = false;
 
+    MatchIndex *idx = &curBuffer->matches;
+    MatchIndexClear(curBuffer);
+
     UiStatus status;
     while ((status = UiInputBox("Find", search, &searchLen, maxLen)) == UI_CONTINUE)
     {
-        BufferUnmarkAll(curBuffer);
-        CursorSetPos(curBuffer, prevPos.col, prevPos.row, false);
-        CursorPos pos = curPos;
-
-        bool found = false;
-        if ((found = find(search, searchLen, 1, curRow, &pos)) == false)
-            found = find(search, searchLen, 1, 0, &pos);
+        if (searchLen == idx->length && !memcmp(search, idx->search, searchLen))
+            continue;
 
-        if (found)
-        {
-            CursorPos p = {0, 0};
-            while (find(search, searchLen, 1, p.row, &p))
-            {
-                BufferMarkLine(curBuffer, p.row, p.col, searchLen);
-                p.row++;
-            }
-        }
+        // A longer word can only match where the previous one did. Keys typed
+        // during a search stop it, the next word is then searched from scratch.
+        bool extended = idx->length > 0 && searchLen > idx->length && !memcmp(search, idx->search, idx->length);
+        if (extended)
+            MatchIndexNarrow(curBuffer, search, searchLen);
+        else if (!searchAll(search, searchLen, prevPos))
+            continue;
 
-        CursorSetPos(curBuffer, pos.col, pos.row, false);
-        BufferCenterView(curBuffer);
-        Render();
+        showMatch(firstMatch(prevPos));
     }
 
     if (status == UI_CANCEL)
     {
-        BufferUnmarkAll(curBuffer);
+        MatchIndexClear(curBuffer);
         CursorSetPos(curBuffer, prevPos.col, prevPos.row, false);
         BufferSetSearchWord(curBuffer, NULL, 0);
     }
     else
+    {
+        // Enter was pressed before the last search finished
+        if (idx->length != searchLen || memcmp(idx->search, search, searchLen))
+        {
+            MatchIndexBuild(curBuffer, search, searchLen);
+            showMatch(firstMatch(prevPos));
+        }
+
         BufferSetSearchWord(curBuffer, search, searchLen);
+    }
 
     curBuffer->showCurrentLineMark = true;
 }
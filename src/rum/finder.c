@@ -0,0 +1,663 @@
+// Fuzzy file finder. A walker thread lists every file under a directory while
+// queries rank the files listed so far. Paths are scored like fzf: matched
+// characters get points, with bonuses at word boundaries and for runs, and
+// gaps cost points. Files are scored on worker threads, each keeping its best
+// files in a bounded heap. The files matching each query typed are kept, so a
+// query that extends the previous one only scores the files that matched it,
+// and backspace goes back to a query that was already ranked.
+
+#include "rum.h"
+
+extern Editor editor;
+
+#define FINDER_BLOCK 4096      // Files per block of the file list
+#define FINDER_MAX_BLOCKS 1024 // Files after FINDER_MAX_BLOCKS * FINDER_BLOCK are ignored
+#define FINDER_CHUNK KB(256)   // Paths are stored in chunks of this size
+#define MIN_WORK 16384         // Files scored by each worker at least
+#define FINDER_POLL_MS 10      // How often results are updated while listing
+
+// Scores, as in fzf
+#define SCORE_MATCH 16
+#define SCORE_GAP_START -3
+#define SCORE_GAP_EXTENSION -1
+#define BONUS_BOUNDARY 8           // Word after a non-word character
+#define BONUS_BOUNDARY_WHITE 10    // Word after a space
+#define BONUS_BOUNDARY_DELIMITER 9 // Word after a path separator
+#define BONUS_NON_WORD 8
+#define BONUS_CAMEL 7        // Uppercase after lowercase, digit after non-digit
+#define BONUS_CONSECUTIVE 4  // Run of matches continues
+#define BONUS_FIRST_FACTOR 2 // The bonus of the first character counts double
+#define NO_MATCH -1000000
+
+typedef enum charClass
+{
+    CLASS_WHITE,
+    CLASS_NON_WORD,
+    CLASS_DELIMITER,
+    CLASS_LOWER,
+    CLASS_UPPER,
+    CLASS_NUMBER,
+    NUM_CLASSES,
+} charClass;
+
+typedef struct finderFile
+{
+    char *path; // Relative to the directory of the finder
+    int length;
+} finderFile;
+
+typedef struct rankedFile
+{
+    int score;
+    int length;
+    int id;
+} rankedFile;
+
+typedef struct fuzzyPattern
+{
+    char text[MAX_SEARCH]; // Lowercase if ignoreCase is set
+    int length;
+    bool ignoreCase; // Unless the query has an uppercase letter
+} fuzzyPattern;
+
+// Files matching a query, in the order they were listed.
+typedef struct level
+{
+    fuzzyPattern pattern;
+    int *ids;
+    int count;
+    int cap;
+    int covered; // Files checked, the rest were listed after
+    rankedFile heap[FINDER_MAX_RESULTS]; // Best files, worst at the top
+    int heapSize;
+} level;
+
+// Files from..to of ids, or of the file list if ids is NULL, scored by one
+// worker. Matching ids are written to out.
+typedef struct scoreJob
+{
+    Finder *finder;
+    fuzzyPattern *pattern;
+    int *ids;
+    int from;
+    int to;
+    int *out;
+    int numOut;
+    rankedFile heap[FINDER_MAX_RESULTS];
+    int heapSize;
+} scoreJob;
+
+struct Finder
+{
+    char dir[MAX_PATH];
+
+    // Written by the walker, read once numFiles covers them
+    finderFile *blocks[FINDER_MAX_BLOCKS];
+
+    // Owned by the walker until it is done
+    char **chunks;
+    int numChunks;
+    int chunkUsed;
+
+    // Accessed atomically
+    int numFiles;
+    bool walkDone;
+    bool cancelled;
+
+    Thread *walker;
+
+    // Each query since the prompt opened that is a prefix of the last one
+    level *levels[MAX_SEARCH + 1];
+    int numLevels;
+
+    scoreJob jobs[MAX_WORKERS];
+};
+
+static unsigned char classes[256];
+static unsigned char lower[256];
+static unsigned char identity[256];
+static int bonuses[NUM_CLASSES][NUM_CLASSES];
+
+// Bonus for a match on class after prevClass, as in fzf
+static int bonusFor(charClass prevClass, charClass class)
+{
+    if (class > CLASS_NON_WORD)
+    {
+        if (prevClass == CLASS_WHITE)
+            return BONUS_BOUNDARY_WHITE;
+        if (prevClass == CLASS_DELIMITER)
+            return BONUS_BOUNDARY_DELIMITER;
+        if (prevClass == CLASS_NON_WORD)
+            return BONUS_BOUNDARY;
+    }
+
+    if ((prevClass == CLASS_LOWER && class == CLASS_UPPER) || (prevClass != CLASS_NUMBER && class == CLASS_NUMBER))
+        return BONUS_CAMEL;
+    if (class == CLASS_NON_WORD || class == CLASS_DELIMITER)
+        return BONUS_NON_WORD;
+    if (class == CLASS_WHITE)
+        return BONUS_BOUNDARY_WHITE;
+
+    return 0;
+}
+
+static void initTables()
+{
+    for (int c = 0; c < 256; c++)
+    {
+        lower[c] = tolower(c);
+        identity[c] = c;
+
+        if (islower(c))
+            classes[c] = CLASS_LOWER;
+        else if (isupper(c))
+            classes[c] = CLASS_UPPER;
+        else if (isdigit(c))
+            classes[c] = CLASS_NUMBER;
+        else if (c == ' ' || c == '\t')
+            classes[c] = CLASS_WHITE;
+        else if (c == '/' || c == '\\' || c == ',' || c == ':' || c == ';' || c == '|')
+            classes[c] = CLASS_DELIMITER;
+        else
+            classes[c] = CLASS_NON_WORD;
+    }
+
+    for (int a = 0; a < NUM_CLASSES; a++)
+        for (int b = 0; b < NUM_CLASSES; b++)
+            bonuses[a][b] = bonusFor(a, b);
+}
+
+// Scores the characters from start to end, which hold a match of p.
+static int scoreMatch(fuzzyPattern *p, const unsigned char *text, int start, int end)
+{
+    const unsigned char *fold = p->ignoreCase ? lower : identity;
+    int prevClass = start > 0 ? classes[text[start - 1]] : CLASS_DELIMITER;
+    int score = 0, k = 0, consecutive = 0, firstBonus = 0;
+    bool inGap = false;
+
+    for (int i = start; i < end; i++)
+    {
+        int class = classes[text[i]];
+
+        if (k < p->length && fold[text[i]] == (unsigned char)p->text[k])
+        {
+            int bonus = bonuses[prevClass][class];
+            if (consecutive == 0)
+                firstBonus = bonus;
+            else
+            {
+                // A boundary starts a new run
+                if (bonus >= BONUS_BOUNDARY && bonus > firstBonus)
+                    firstBonus = bonus;
+                bonus = max(max(bonus, firstBonus), BONUS_CONSECUTIVE);
+            }
+
+            score += SCORE_MATCH + (k == 0 ? bonus * BONUS_FIRST_FACTOR : bonus);
+            inGap = false;
+            consecutive++;
+            k++;
+        }
+        else
+        {
+            score += inGap ? SCORE_GAP_EXTENSION : SCORE_GAP_START;
+            inGap = true;
+            consecutive = 0;
+            firstBonus = 0;
+        }
+
+        prevClass = class;
+    }
+
+    return score;
+}
+
+// Returns the score of p in text, NO_MATCH if text does not have all of its
+// characters in order. Like fzf v1, the first match is found going forward
+// and then shortened going backward from its end.
+static int scorePath(fuzzyPattern *p, const char *path, int length)
+{
+    if (p->length == 0)
+        return 0;
+
+    const unsigned char *text = (const unsigned char *)path;
+    const unsigned char *fold = p->ignoreCase ? lower : identity;
+    const unsigned char *pat = (const unsigned char *)p->text;
+
+    int k = 0, end = -1;
+    for (int i = 0; i < length; i++)
+    {
+        if (fold[text[i]] == pat[k] && ++k == p->length)
+        {
+            end = i + 1;
+            break;
+        }
+    }
+
+    if (end == -1)
+        return NO_MATCH;
+
+    int start = 0;
+    k = p->length - 1;
+    for (int i = end - 1; i >= 0; i--)
+    {
+        if (fold[text[i]] == pat[k] && --k < 0)
+        {
+            start = i;
+            break;
+        }
+    }
+
+    return scoreMatch(p, text, start, end);
+}
+
+// Higher score first, then shorter paths, then the first listed
+static bool isBetter(rankedFile *a, rankedFile *b)
+{
+    if (a->score != b->score)
+        return a->score > b->score;
+    if (a->length != b->length)
+        return a->length < b->length;
+    return a->id < b->id;
+}
+
+static int compareRanked(const void *a, const void *b)
+{
+    return isBetter((rankedFile *)a, (rankedFile *)b) ? -1 : 1;
+}
+
+// Adds r to a heap of at most FINDER_MAX_RESULTS files if it is better than
+// the worst one.
+static void heapPush(rankedFile *heap, int *size, rankedFile r)
+{
+    int i;
+    if (*size < FINDER_MAX_RESULTS)
+    {
+        // Sift up from the end
+        i = (*size)++;
+        while (i > 0 && isBetter(&heap[(i - 1) / 2], &r))
+        {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+
+        heap[i] = r;
+        return;
+    }
+
+    if (!isBetter(&r, &heap[0]))
+        return;
+
+    // Sift down from the top
+    i = 0;
+    while (true)
+    {
+        int child = i * 2 + 1;
+        if (child >= *size)
+            break;
+        if (child + 1 < *size && isBetter(&heap[child], &heap[child + 1]))
+            child++;
+        if (!isBetter(&r, &heap[child]))
+            break;
+
+        heap[i] = heap[child];
+        i = child;
+    }
+
+    heap[i] = r;
+}
+
+static bool isCancelled(Finder *f)
+{
+    return __atomic_load_n(&f->cancelled, __ATOMIC_RELAXED);
+}
+
+static finderFile *fileAt(Finder *f, int id)
+{
+    return &f->blocks[id / FINDER_BLOCK][id % FINDER_BLOCK];
+}
+
+// Returns a copy of path in the path chunks of f.
+static char *storePath(Finder *f, const char *path, int length)
+{
+    if (f->numChunks == 0 || f->chunkUsed + length + 1 > FINDER_CHUNK)
+    {
+        f->chunks = f->chunks == NULL ? MemAlloc(sizeof(char *)) : MemRealloc(f->chunks, (f->numChunks + 1) * sizeof(char *));
+        AssertNotNull(f->chunks);
+        f->chunks[f->numChunks] = MemAlloc(max(FINDER_CHUNK, length + 1));
+        AssertNotNull(f->chunks[f->numChunks]);
+        f->numChunks++;
+        f->chunkUsed = 0;
+    }
+
+    char *copy = f->chunks[f->numChunks - 1] + f->chunkUsed;
+    memcpy(copy, path, length + 1);
+    f->chunkUsed += length + 1;
+    return copy;
+}
+
+// Adds a file found by IoWalkDir. Returns false when the walk should stop.
+static bool addFile(const char *path, DirEntry *e, void *arg)
+{
+    (void)e;
+    Finder *f = arg;
+    int id = f->numFiles;
+    if (id == FINDER_MAX_BLOCKS * FINDER_BLOCK)
+        return false;
+
+    if (id % FINDER_BLOCK == 0)
+    {
+        f->blocks[id / FINDER_BLOCK] = MemAlloc(FINDER_BLOCK * sizeof(finderFile));
+        AssertNotNull(f->blocks[id / FINDER_BLOCK]);
+    }
+
+    int length = strlen(path);
+    *fileAt(f, id) = (finderFile){.path = storePath(f, path, length), .length = length};
+    __atomic_store_n(&f->numFiles, id + 1, __ATOMIC_RELEASE);
+    return !isCancelled(f);
+}
+
+static void walk(void *arg)
+{
+    Finder *f = arg;
+    IoWalkDir(f->dir, addFile, f);
+    __atomic_store_n(&f->walkDone, true, __ATOMIC_RELEASE);
+}
+
+Finder *FinderStart(char *dir)
+{
+    initTables();
+
+    Finder *f = MemZeroAlloc(sizeof(Finder));
+    AssertNotNull(f);
+    snprintf(f->dir, MAX_PATH, "%s", dir);
+
+    f->walker = ThreadStart(walk, f);
+    if (f->walker == NULL)
+        walk(f);
+
+    return f;
+}
+
+bool FinderDone(Finder *f, int *numFiles)
+{
+    // numFiles is final if the walk was done before it was read
+    bool done = __atomic_load_n(&f->walkDone, __ATOMIC_ACQUIRE);
+    *numFiles = __atomic_load_n(&f->numFiles, __ATOMIC_ACQUIRE);
+    return done;
+}
+
+static void scoreFiles(void *arg)
+{
+    scoreJob *job = arg;
+    Finder *f = job->finder;
+    job->numOut = 0;
+    job->heapSize = 0;
+
+    for (int i = job->from; i < job->to; i++)
+    {
+        int id = job->ids != NULL ? job->ids[i] : i;
+        finderFile *file = fileAt(f, id);
+
+        int score = scorePath(job->pattern, file->path, file->length);
+        if (score == NO_MATCH)
+            continue;
+
+        job->out[job->numOut++] = id;
+        heapPush(job->heap, &job->heapSize, (rankedFile){.score = score, .length = file->length, .id = id});
+    }
+}
+
+// Scores files from..to of ids, or of the file list if ids is NULL, against
+// the pattern of lv and adds the matching ones to it.
+static void addMatches(Finder *f, level *lv, int *ids, int from, int to)
+{
+    int count = to - from;
+    if (count <= 0)
+        return;
+
+    if (lv->count + count > lv->cap)
+    {
+        lv->cap = max(lv->cap * 2, lv->count + count);
+        lv->ids = lv->ids == NULL ? MemAlloc(lv->cap * sizeof(int)) : MemRealloc(lv->ids, lv->cap * sizeof(int));
+        AssertNotNull(lv->ids);
+    }
+
+    // Each worker writes its matches where its files would go
+    int numJobs = clamp(1, WorkerCount(), count / MIN_WORK);
+    int *out = lv->ids + lv->count;
+
+    for (int i = 0; i < numJobs; i++)
+    {
+        scoreJob *job = &f->jobs[i];
+        job->finder = f;
+        job->pattern = &lv->pattern;
+        job->ids = ids;
+        job->from = from + (long long)count * i / numJobs;
+        job->to = from + (long long)count * (i + 1) / numJobs;
+        job->out = out + (job->from - from);
+    }
+
+    Thread *threads[MAX_WORKERS] = {0};
+    for (int i = 1; i < numJobs; i++)
+        threads[i] = ThreadStart(scoreFiles, &f->jobs[i]);
+
+    scoreFiles(&f->jobs[0]);
+    for (int i = 1; i < numJobs; i++)
+    {
+        if (threads[i] != NULL)
+            ThreadJoin(threads[i]);
+        else
+            scoreFiles(&f->jobs[i]);
+    }
+
+    // Matches are kept in the order the files were listed
+    for (int i = 0; i < numJobs; i++)
+    {
+        scoreJob *job = &f->jobs[i];
+        memmove(lv->ids + lv->count, job->out, job->numOut * sizeof(int));
+        lv->count += job->numOut;
+
+        for (int k = 0; k < job->heapSize; k++)
+            heapPush(lv->heap, &lv->heapSize, job->heap[k]);
+    }
+}
+
+static level *newLevel(char *query, int length)
+{
+    level *lv = MemZeroAlloc(sizeof(level));
+    AssertNotNull(lv);
+
+    // Smart case, like fzf
+    bool hasUpper = false;
+    for (int i = 0; i < length; i++)
+        hasUpper |= isupper((unsigned char)query[i]) != 0;
+
+    fuzzyPattern *p = &lv->pattern;
+    p->length = length;
+    p->ignoreCase = !hasUpper;
+    for (int i = 0; i < length; i++)
+        p->text[i] = p->ignoreCase ? lower[(unsigned char)query[i]] : query[i];
+
+    return lv;
+}
+
+static void freeLevel(level *lv)
+{
+    if (lv->ids != NULL)
+        MemFree(lv->ids);
+    MemFree(lv);
+}
+
+// Returns true if p is a prefix of query. A prefix with case ignored matches
+// more files than the query, so it works with smart case too.
+static bool isPrefix(fuzzyPattern *p, char *query, int length)
+{
+    if (p->length > length)
+        return false;
+
+    const unsigned char *fold = p->ignoreCase ? lower : identity;
+    for (int i = 0; i < p->length; i++)
+    {
+        if (fold[(unsigned char)query[i]] != (unsigned char)p->text[i])
+            return false;
+    }
+
+    return true;
+}
+
+int FinderQuery(Finder *f, char *query, int length, char **results, int *numResults)
+{
+    length = min(length, MAX_SEARCH);
+
+    // Only files matching a prefix of the query can match it
+    while (f->numLevels > 0 && !isPrefix(&f->levels[f->numLevels - 1]->pattern, query, length))
+        freeLevel(f->levels[--f->numLevels]);
+
+    level *top = f->numLevels > 0 ? f->levels[f->numLevels - 1] : NULL;
+    if (top == NULL || top->pattern.length != length)
+    {
+        level *lv = newLevel(query, length);
+        if (top != NULL)
+        {
+            addMatches(f, lv, top->ids, 0, top->count);
+            lv->covered = top->covered;
+        }
+
+        f->levels[f->numLevels++] = lv;
+        top = lv;
+    }
+
+    // Files listed since the level was made
+    int numFiles = __atomic_load_n(&f->numFiles, __ATOMIC_ACQUIRE);
+    addMatches(f, top, NULL, top->covered, numFiles);
+    top->covered = numFiles;
+
+    rankedFile best[FINDER_MAX_RESULTS];
+    memcpy(best, top->heap, top->heapSize * sizeof(rankedFile));
+    qsort(best, top->heapSize, sizeof(rankedFile), compareRanked);
+
+    for (int i = 0; i < top->heapSize; i++)
+        results[i] = fileAt(f, best[i].id)->path;
+
+    *numResults = top->heapSize;
+    return top->count;
+}
+
+void FinderFree(Finder *f)
+{
+    __atomic_store_n(&f->cancelled, true, __ATOMIC_RELAXED);
+    if (f->walker != NULL)
+        ThreadJoin(f->walker);
+
+    while (f->numLevels > 0)
+        freeLevel(f->levels[--f->numLevels]);
+
+    for (int i = 0; i < FINDER_MAX_BLOCKS && f->blocks[i] != NULL; i++)
+        MemFree(f->blocks[i]);
+    for (int i = 0; i < f->numChunks; i++)
+        MemFree(f->chunks[i]);
+    if (f->chunks != NULL)
+        MemFree(f->chunks);
+
+    MemFree(f);
+}
+
+// Returns the number of results that fit on screen, the rest are not shown
+// and can not be selected.
+static int numShown(int numResults)
+{
+    return clamp(0, numResults, editor.height - 6);
+}
+
+static void drawFinder(char *query, char **results, int numResults, int selected, int numMatches, int numFiles, bool done)
+{
+    // Hides the buffer text behind the list
+    Render();
+
+    char title[64];
+    snprintf(title, sizeof(title), "%d/%d files%s", numMatches, numFiles, done ? "" : ", listing");
+
+    int x = curBuffer->offX;
+    UiDrawList(results, numShown(numResults), title, selected, x + 1, 4, curBuffer->width - 2);
+    UiDrawInputBox("Open file", query);
+}
+
+void FinderPrompt()
+{
+    Finder *f = FinderStart(".");
+
+    // Sets buffer size, which the prompt is sized by
+    editor.uiOpen = true;
+    Render();
+
+    int maxLen = min(curBuffer->width - 3, MAX_SEARCH);
+    char query[MAX_SEARCH] = {0};
+    int queryLen = 0;
+
+    char *results[FINDER_MAX_RESULTS];
+    int numResults = 0, numMatches = 0, selected = 0;
+    int numQueried = -1; // Files listed when the query was last run
+    bool update = true;
+    bool accept = false; // Enter was pressed, waits for a match while listing
+
+    while (true)
+    {
+        int numFiles;
+        bool done = FinderDone(f, &numFiles);
+        if (update || numFiles != numQueried)
+        {
+            numMatches = FinderQuery(f, query, queryLen, results, &numResults);
+            numQueried = numFiles;
+            update = false;
+        }
+
+        // Also after a resize
+        selected = min(selected, max(numShown(numResults) - 1, 0));
+
+        if (accept && (numResults > 0 || done))
+            break;
+
+        drawFinder(query, results, numResults, selected, numMatches, numFiles, done);
+
+        // Results are updated as files are listed until a key is pressed
+        if (!done && !EditorHasInput())
+        {
+            ScreenFlush();
+            TimeSleep(FINDER_POLL_MS);
+            continue;
+        }
+
+        InputInfo info;
+        if (EditorPeekInput(&info) && info.eventType == INPUT_KEYDOWN &&
+            (info.keyCode == K_ARROW_UP || info.keyCode == K_ARROW_DOWN))
+        {
+            EditorReadInput(&info);
+            int step = info.keyCode == K_ARROW_DOWN ? 1 : -1;
+            selected = clamp(0, max(numShown(numResults) - 1, 0), selected + step);
+            continue;
+        }
+
+        UiStatus status = UiInputBox("Open file", query, &queryLen, maxLen);
+        if (status == UI_CANCEL)
+            break;
+
+        accept = status == UI_OK;
+        if (!accept)
+        {
+            selected = 0;
+            update = true;
+        }
+    }
+
+    editor.uiOpen = false;
+
+    // Path is freed with the finder
+    char path[PATH_MAX];
+    bool chosen = accept && numResults > 0;
+    if (chosen)
+        snprintf(path, PATH_MAX, "%s", results[selected]);
+    FinderFree(f);
+
+    if (chosen && EditorOpenFile(path) != NIL)
+        SetError("file not found");
+}
@@ -0,0 +1,437 @@
+// Searches all files under a directory for a word or a \v regex. A walker
+// thread lists directories while worker threads search the files found so
+// far, each mapped into memory. Results are kept per file and read in the
+// order the files were found, so they do not depend on which worker was first.
+// If the directory has a trigram index, see src/rum/index.c, files it shows
+// can not match are not read.
+
+#include "rum.h"
+
+extern Config config;
+extern Editor editor;
+
+#define BLOCK_FILES 4096  // Files per block of the file list
+#define MAX_BLOCKS 1024   // Files after MAX_BLOCKS * BLOCK_FILES are ignored
+#define MAX_LINE_TEXT 200 // Longer lines are cut in results
+
+typedef struct grepFile
+{
+    char *path;
+    char *results; // Result lines, each ending with a newline
+    int length;
+    int cap;
+    int numMatches;
+    bool binary;
+    bool done; // Set by the worker when results are complete
+} grepFile;
+
+struct Grep
+{
+    char pattern[MAX_SEARCH]; // Without \c and \C
+    int length;
+    bool isRegex;
+    bool ignoreCase;
+    Searcher searcher;
+    char dir[MAX_PATH];
+
+    // Index of dir if it has one and the pattern has a literal to look up
+    TrigramIndex *index;
+    bool *candidates;
+
+    // Written by the walker, read by workers once numFiles covers them
+    grepFile *blocks[MAX_BLOCKS];
+
+    // Accessed atomically
+    int numFiles;
+    int nextFile;
+    int numSkipped;
+    bool walkDone;
+    bool cancelled;
+
+    int numRead; // Files added to results by GrepRead
+    GrepStats stats;
+
+    Thread *walker;
+    Thread *workers[MAX_WORKERS];
+    int numWorkers;
+};
+
+static bool isCancelled(Grep *g)
+{
+    return __atomic_load_n(&g->cancelled, __ATOMIC_RELAXED);
+}
+
+static grepFile *fileAt(Grep *g, int k)
+{
+    return &g->blocks[k / BLOCK_FILES][k % BLOCK_FILES];
+}
+
+// Returns true if the index has the file unchanged and it can not match.
+static bool skipFile(Grep *g, const char *path, DirEntry *e)
+{
+    if (g->candidates == NULL)
+        return false;
+
+    int k = IndexFindFile(g->index, path, e->size, e->modified);
+    return k != -1 && !g->candidates[k];
+}
+
+// Adds a file found by IoWalkDir. Returns false when the walk should stop.
+static bool addFile(const char *path, DirEntry *e, void *arg)
+{
+    Grep *g = arg;
+    if (skipFile(g, path, e))
+    {
+        __atomic_store_n(&g->numSkipped, g->numSkipped + 1, __ATOMIC_RELAXED);
+        return !isCancelled(g);
+    }
+
+    // Results show the path the file was opened with
+    char joined[PATH_MAX];
+    if (!IoJoinPath(joined, PATH_MAX, g->dir, path))
+        return !isCancelled(g);
+
+    int k = g->numFiles;
+    if (k == MAX_BLOCKS * BLOCK_FILES)
+        return false;
+
+    if (k % BLOCK_FILES == 0)
+    {
+        g->blocks[k / BLOCK_FILES] = MemZeroAlloc(BLOCK_FILES * sizeof(grepFile));
+        AssertNotNull(g->blocks[k / BLOCK_FILES]);
+    }
+
+    grepFile *f = fileAt(g, k);
+    f->path = MemAlloc(strlen(joined) + 1);
+    AssertNotNull(f->path);
+    strcpy(f->path, joined);
+
+    __atomic_store_n(&g->numFiles, k + 1, __ATOMIC_RELEASE);
+    return !isCancelled(g);
+}
+
+static void walk(void *arg)
+{
+    Grep *g = arg;
+    IoWalkDir(g->dir, addFile, g);
+    __atomic_store_n(&g->walkDone, true, __ATOMIC_RELEASE);
+}
+
+// Returns the next file to search, waiting for the walker if it has not found
+// one yet. NULL when all are taken.
+static grepFile *takeFile(Grep *g)
+{
+    while (!isCancelled(g))
+    {
+        // numFiles is final if the walk was done before it was read
+        bool walkDone = __atomic_load_n(&g->walkDone, __ATOMIC_ACQUIRE);
+        int numFiles = __atomic_load_n(&g->numFiles, __ATOMIC_ACQUIRE);
+        int k = __atomic_load_n(&g->nextFile, __ATOMIC_RELAXED);
+
+        if (k < numFiles)
+        {
+            if (__atomic_compare_exchange_n(&g->nextFile, &k, k + 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                return fileAt(g, k);
+            continue;
+        }
+
+        if (walkDone)
+            break;
+        TimeSleep(1);
+    }
+
+    return NULL;
+}
+
+static void addResult(grepFile *f, int row, int col, const char *line, int length)
+{
+    if (length > 0 && line[length - 1] == '\r')
+        length--;
+
+    // Tabs are expanded when the file is opened
+    int tabs = 0;
+    for (int i = 0; i < col; i++)
+        tabs += line[i] == '\t';
+    col += tabs * (config.tabSize - 1);
+
+    length = min(length, MAX_LINE_TEXT);
+    int need = f->length + strlen(f->path) + length + 32;
+    if (need > f->cap)
+    {
+        f->cap = max(f->cap * 2, need);
+        f->results = f->results == NULL ? MemAlloc(f->cap) : MemRealloc(f->results, f->cap);
+        AssertNotNull(f->results);
+    }
+
+    // Rows and columns start from 1, like other grep tools
+    char *p = f->results + f->length;
+    p += sprintf(p, "%s:%d:%d: ", f->path, row + 1, col + 1);
+    for (int i = 0; i < length; i++)
+        *p++ = line[i] == '\t' ? ' ' : line[i];
+    *p++ = '\n';
+
+    f->length = p - f->results;
+    f->numMatches++;
+}
+
+// Adds the first match on each line. The whole file is searched at once and
+// lines are only counted up to each match.
+static void searchWord(Grep *g, grepFile *f, const char *data, int size)
+{
+    const char *end = data + size;
+    const char *lineStart = data;
+    const char *p = data;
+    int row = 0;
+
+    const char *m;
+    while ((m = SearchFind(&g->searcher, p, end - p)) != NULL)
+    {
+        const char *nl;
+        while ((nl = memchr(lineStart, '\n', m - lineStart)) != NULL)
+        {
+            lineStart = nl + 1;
+            row++;
+        }
+
+        const char *lineEnd = memchr(m, '\n', end - m);
+        if (lineEnd == NULL)
+            lineEnd = end;
+
+        addResult(f, row, m - lineStart, lineStart, lineEnd - lineStart);
+        if (lineEnd == end)
+            break;
+
+        p = lineStart = lineEnd + 1;
+        row++;
+    }
+}
+
+static void searchRegex(Regex *re, grepFile *f, const char *data, int size)
+{
+    const char *end = data + size;
+    const char *line = data;
+
+    for (int row = 0; line < end; row++)
+    {
+        const char *lineEnd = memchr(line, '\n', end - line);
+        if (lineEnd == NULL)
+            lineEnd = end;
+
+        int length = lineEnd - line;
+        int start, matchEnd;
+        if (length > 0 && line[length - 1] == '\r')
+            length--;
+
+        if (RegexTest(re, line, length) && RegexFind(re, line, length, 0, &start, &matchEnd))
+            addResult(f, row, start, line, length);
+
+        line = lineEnd + 1;
+    }
+}
+
+static void searchFiles(void *arg)
+{
+    Grep *g = arg;
+
+    // Searching changes the DFA cache of a regex, so each worker has its own
+    Regex *re = g->isRegex ? RegexCompile(g->pattern + 2, g->length - 2, g->ignoreCase) : NULL;
+
+    grepFile *f;
+    while ((f = takeFile(g)) != NULL)
+    {
+        int size;
+        char *data = IoMapFile(f->path, &size);
+
+        if (data != NULL)
+        {
+            f->binary = memchr(data, 0, min(size, BINARY_CHECK)) != NULL;
+            if (!f->binary && re != NULL)
+                searchRegex(re, f, data, size);
+            else if (!f->binary)
+                searchWord(g, f, data, size);
+
+            IoUnmapFile(data, size);
+        }
+
+        __atomic_store_n(&f->done, true, __ATOMIC_RELEASE);
+    }
+
+    RegexFree(re);
+}
+
+Grep *GrepStart(char *pattern, int length, char *dir)
+{
+    if (length == 0 || length > MAX_SEARCH)
+        return NULL;
+
+    Grep *g = MemZeroAlloc(sizeof(Grep));
+    AssertNotNull(g);
+
+    g->length = SearchParseCase(g->pattern, pattern, length, &g->ignoreCase);
+    g->isRegex = g->length >= 2 && g->pattern[0] == '\\' && g->pattern[1] == 'v';
+    snprintf(g->dir, MAX_PATH, "%s", dir);
+
+    if (g->length == 0)
+    {
+        MemFree(g);
+        return NULL;
+    }
+
+    // Every match of a regex contains its prefix, which the index can look up
+    const char *literal = g->pattern;
+    int literalLen = g->length;
+    Regex *re = NULL;
+
+    if (g->isRegex)
+    {
+        re = RegexCompile(g->pattern + 2, g->length - 2, g->ignoreCase);
+        if (re == NULL)
+        {
+            MemFree(g);
+            return NULL;
+        }
+        literal = RegexPrefix(re, &literalLen);
+    }
+    else
+        SearchInit(&g->searcher, g->pattern, g->length, g->ignoreCase);
+
+    g->index = IndexLoad(dir);
+    if (g->index != NULL)
+        g->candidates = IndexQuery(g->index, literal, literalLen);
+    RegexFree(re);
+
+    g->walker = ThreadStart(walk, g);
+    if (g->walker == NULL)
+        walk(g);
+
+    for (int i = 0; i < WorkerCount(); i++)
+    {
+        Thread *t = ThreadStart(searchFiles, g);
+        if (t != NULL)
+            g->workers[g->numWorkers++] = t;
+    }
+
+    if (g->numWorkers == 0)
+        searchFiles(g);
+
+    return g;
+}
+
+static void stop(Grep *g)
+{
+    __atomic_store_n(&g->cancelled, true, __ATOMIC_RELAXED);
+}
+
+bool GrepRead(Grep *g, Buffer *b)
+{
+    if (isCancelled(g))
+        return true;
+
+    int numFiles = __atomic_load_n(&g->numFiles, __ATOMIC_ACQUIRE);
+    while (g->numRead < numFiles)
+    {
+        grepFile *f = fileAt(g, g->numRead);
+        if (!__atomic_load_n(&f->done, __ATOMIC_ACQUIRE))
+            return false;
+
+        if (g->stats.matches + f->numMatches > GREP_MAX_RESULTS)
+        {
+            g->stats.truncated = true;
+            stop(g);
+            return true;
+        }
+
+        if (f->numMatches > 0)
+        {
+            int pathId = StrArraySet(&b->exPaths, f->path, strlen(f->path));
+            char *p = f->results;
+            char *end = f->results + f->length;
+
+            while (p < end)
+            {
+                char *nl = memchr(p, '\n', end - p);
+                Line *line = BufferInsertLineEx(b, -1, p, nl - p);
+                line->isPath = true;
+                line->exPathId = pathId;
+                p = nl + 1;
+            }
+
+            MemFree(f->results);
+            f->results = NULL;
+        }
+
+        g->stats.files++;
+        g->stats.binary += f->binary;
+        g->stats.matches += f->numMatches;
+        g->numRead++;
+    }
+
+    // Every file found before the walk was done has been read
+    return __atomic_load_n(&g->walkDone, __ATOMIC_ACQUIRE) && g->numRead == __atomic_load_n(&g->numFiles, __ATOMIC_ACQUIRE);
+}
+
+GrepStats GrepGetStats(Grep *g)
+{
+    GrepStats stats = g->stats;
+    stats.skipped = __atomic_load_n(&g->numSkipped, __ATOMIC_RELAXED);
+    return stats;
+}
+
+void GrepFree(Grep *g)
+{
+    stop(g);
+    if (g->walker != NULL)
+        ThreadJoin(g->walker);
+    for (int i = 0; i < g->numWorkers; i++)
+        ThreadJoin(g->workers[i]);
+
+    for (int k = 0; k < g->numFiles; k++)
+    {
+        grepFile *f = fileAt(g, k);
+        MemFree(f->path);
+        if (f->results != NULL)
+            MemFree(f->results);
+    }
+
+    for (int i = 0; i < MAX_BLOCKS && g->blocks[i] != NULL; i++)
+        MemFree(g->blocks[i]);
+
+    if (g->candidates != NULL)
+        MemFree(g->candidates);
+    IndexFree(g->index);
+    MemFree(g);
+}
+
+bool GrepJump()
+{
+    if (!curLine.isPath)
+        return false;
+
+    char *path = BufferGetLinePath(curBuffer, &curLine);
+    int pathLen = strlen(path);
+
+    // Line text is not null terminated
+    char pos[32] = {0};
+    memcpy(pos, curLine.chars + min(pathLen, curLine.length), clamp(0, 31, curLine.length - pathLen));
+
+    int row, col;
+    if (sscanf(pos, ":%d:%d:", &row, &col) != 2)
+        return false;
+
+    // Path is freed with the results buffer
+    char filepath[MAX_PATH];
+    snprintf(filepath, MAX_PATH, "%s", path);
+
+    // The new buffer gets its size when rendered, centering needs it now
+    int textH = curBuffer->textH;
+    if (EditorOpenFile(filepath) != NIL)
+    {
+        SetError("file not found");
+        return true;
+    }
+
+    curBuffer->textH = textH;
+    CursorSetPos(curBuffer, col - 1, row - 1, false);
+    BufferCenterView(curBuffer);
+    return true;
+}
@@ -0,0 +1,638 @@
+// Trigram index of the files under a directory, written by :index to
+// INDEX_FILENAME in that directory. It lists the files containing each
+// trigram, so :grep only reads files that have every trigram of the word.
+// Letters are folded to lowercase and other bytes are put in a few classes,
+// so a trigram fits in 18 bits. Files that share a trigram by folding are
+// extra candidates, which the exact search rules out.
+//
+// Files are matched to the index by path, size and modification time. Files
+// changed since the index was written are searched as if there was no index.
+// Updating reads only changed and new files, the trigrams of the others are
+// taken from the old index.
+//
+// File layout, in native byte order:
+//   indexHeader
+//   indexFile[numFiles]
+//   paths, relative to the directory and null terminated
+//   int offsets[NUM_KEYS + 1] into the postings
+//   postings, ascending file numbers as varint deltas
+
+#include "rum.h"
+
+#include <time.h>
+
+#define KEY_BITS 6 // Bits per byte class in a trigram
+#define NUM_KEYS (1 << (KEY_BITS * 3))
+#define INDEX_MAGIC "RUMIDX1"
+
+typedef struct indexHeader
+{
+    char magic[8];
+    int numFiles;
+    int pathBytes;
+    int postingBytes;
+    int unused;
+    long long built; // Time written, in seconds since the unix epoch
+} indexHeader;
+
+typedef struct indexFile
+{
+    long long modified;
+    long long size;
+    int path; // Offset in paths
+    int unused;
+} indexFile;
+
+struct TrigramIndex
+{
+    char *data; // Whole index file
+    int size;
+    indexHeader *header;
+    indexFile *files;
+    char *paths;
+    int *offsets;
+    unsigned char *postings;
+
+    int *table; // Open addressing by path hash, file number + 1, 0 is empty
+    int tableMask;
+};
+
+// File found when building
+typedef struct buildFile
+{
+    char *path; // Relative to the directory
+    long long modified;
+    long long size;
+    int oldNum; // Number in the old index, -1 if it has to be read
+    int *keys;  // Unique trigrams
+    int numKeys;
+} buildFile;
+
+typedef struct builder
+{
+    char dir[MAX_PATH];
+    buildFile *files;
+    int numFiles;
+    int cap;
+    int nextFile; // Next file to read, taken atomically by workers
+} builder;
+
+static unsigned char classes[256]; // Class of each byte, set by initClasses
+
+static int byteClass(int c)
+{
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 1;
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A' + 1;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 27;
+    if (c == '_')
+        return 37;
+    if (c == ' ' || c == '\t')
+        return 38;
+    if (c > ' ' && c < 127)
+        return 39 + c % 24;
+    return 63;
+}
+
+static void initClasses()
+{
+    for (int c = 0; c < 256; c++)
+        classes[c] = byteClass(c);
+}
+
+static int trigramKey(const char *p)
+{
+    const unsigned char *u = (const unsigned char *)p;
+    return classes[u[0]] << (KEY_BITS * 2) | classes[u[1]] << KEY_BITS | classes[u[2]];
+}
+
+static unsigned hashPath(const char *path)
+{
+    unsigned h = 2166136261u;
+    for (; *path != 0; path++)
+        h = (h ^ (unsigned char)*path) * 16777619u;
+    return h;
+}
+
+TrigramIndex *IndexLoad(char *dir)
+{
+    char path[MAX_PATH];
+    IoJoinPath(path, MAX_PATH, dir, INDEX_FILENAME);
+
+    // Read into memory so the file can be written again while it is used
+    int size;
+    char *data = IoFileExists(path) ? IoReadFile(path, &size) : NULL;
+    if (data == NULL)
+        return NULL;
+
+    TrigramIndex *idx = MemZeroAlloc(sizeof(TrigramIndex));
+    AssertNotNull(idx);
+    idx->data = data;
+    idx->size = size;
+    idx->header = (indexHeader *)data;
+
+    // Sizes are checked one at a time so a broken file can not overflow them
+    indexHeader *h = idx->header;
+    long long need = sizeof(indexHeader);
+    if (size < need || memcmp(h->magic, INDEX_MAGIC, 8) || h->numFiles < 0 || h->pathBytes < 0 || h->postingBytes < 0 ||
+        (need += (long long)h->numFiles * sizeof(indexFile) + h->pathBytes + (NUM_KEYS + 1) * sizeof(int) + h->postingBytes) != size)
+    {
+        IndexFree(idx);
+        return NULL;
+    }
+
+    idx->files = (indexFile *)(data + sizeof(indexHeader));
+    idx->paths = (char *)(idx->files + h->numFiles);
+    idx->offsets = (int *)(idx->paths + h->pathBytes);
+    idx->postings = (unsigned char *)(idx->offsets + NUM_KEYS + 1);
+
+    bool valid = idx->offsets[0] == 0 && idx->offsets[NUM_KEYS] == h->postingBytes && (h->pathBytes == 0 || idx->paths[h->pathBytes - 1] == 0);
+    for (int key = 0; key < NUM_KEYS && valid; key++)
+        valid = idx->offsets[key] <= idx->offsets[key + 1];
+    for (int i = 0; i < h->numFiles && valid; i++)
+        valid = idx->files[i].path >= 0 && idx->files[i].path < h->pathBytes;
+
+    if (!valid)
+    {
+        IndexFree(idx);
+        return NULL;
+    }
+
+    int cap = 64;
+    while (cap < h->numFiles * 2)
+        cap *= 2;
+    idx->tableMask = cap - 1;
+    idx->table = MemZeroAlloc(cap * sizeof(int));
+    AssertNotNull(idx->table);
+
+    for (int i = 0; i < h->numFiles; i++)
+    {
+        unsigned slot = hashPath(idx->paths + idx->files[i].path) & idx->tableMask;
+        while (idx->table[slot] != 0)
+            slot = (slot + 1) & idx->tableMask;
+        idx->table[slot] = i + 1;
+    }
+
+    return idx;
+}
+
+void IndexFree(TrigramIndex *idx)
+{
+    if (idx == NULL)
+        return;
+
+    if (idx->table != NULL)
+        MemFree(idx->table);
+    MemFree(idx->data);
+    MemFree(idx);
+}
+
+int IndexNumFiles(TrigramIndex *idx)
+{
+    return idx->header->numFiles;
+}
+
+int IndexFindFile(TrigramIndex *idx, const char *path, long long size, long long modified)
+{
+    unsigned slot = hashPath(path) & idx->tableMask;
+    for (int k; (k = idx->table[slot]) != 0; slot = (slot + 1) & idx->tableMask)
+    {
+        indexFile *f = &idx->files[k - 1];
+        if (strcmp(idx->paths + f->path, path))
+            continue;
+
+        // A file written in the second the index was built may have changed
+        // after it was read without a newer time
+        if (f->size != size || f->modified != modified || modified >= idx->header->built)
+            return -1;
+
+        return k - 1;
+    }
+
+    return -1;
+}
+
+// Decodes the files containing key to dest. Returns their count.
+static int decodeKey(TrigramIndex *idx, int key, int *dest)
+{
+    unsigned char *p = idx->postings + idx->offsets[key];
+    unsigned char *end = idx->postings + idx->offsets[key + 1];
+    int count = 0, num = -1;
+    int numFiles = idx->header->numFiles;
+
+    while (p < end && count < numFiles)
+    {
+        unsigned delta = 0;
+        for (int shift = 0; p < end && shift < 32; shift += 7)
+        {
+            delta |= (unsigned)(*p & 0x7f) << shift;
+            if (!(*p++ & 0x80))
+                break;
+        }
+
+        if (delta > (unsigned)(numFiles - 1 - num))
+            break;
+
+        num += delta;
+        dest[count++] = num;
+    }
+
+    return count;
+}
+
+static int compareInt(const void *a, const void *b)
+{
+    return *(int *)a - *(int *)b;
+}
+
+bool *IndexQuery(TrigramIndex *idx, const char *text, int length)
+{
+    if (length < 3)
+        return NULL;
+
+    initClasses();
+
+    // Unique keys of the text, rarest first so the candidates shrink fast
+    int keys[MAX_SEARCH];
+    int numKeys = 0;
+    for (int i = 0; i + 3 <= length && numKeys < MAX_SEARCH; i++)
+        keys[numKeys++] = trigramKey(text + i);
+
+    qsort(keys, numKeys, sizeof(int), compareInt);
+    int n = 0;
+    for (int i = 0; i < numKeys; i++)
+        if (n == 0 || keys[i] != keys[n - 1])
+            keys[n++] = keys[i];
+    numKeys = n;
+
+    for (int i = 1; i < numKeys; i++)
+    {
+        int key = keys[i], j = i;
+        int bytes = idx->offsets[key + 1] - idx->offsets[key];
+        for (; j > 0 && idx->offsets[keys[j - 1] + 1] - idx->offsets[keys[j - 1]] > bytes; j--)
+            keys[j] = keys[j - 1];
+        keys[j] = key;
+    }
+
+    int numFiles = idx->header->numFiles;
+    int *found = MemAlloc((numFiles + 1) * sizeof(int));
+    int *next = MemAlloc((numFiles + 1) * sizeof(int));
+    AssertNotNull(found);
+    AssertNotNull(next);
+
+    // Both lists are ascending, so the intersection is a merge
+    int count = decodeKey(idx, keys[0], found);
+    for (int k = 1; k < numKeys && count > 0; k++)
+    {
+        int numNext = decodeKey(idx, keys[k], next);
+        int a = 0, b = 0;
+        n = 0;
+
+        while (a < count && b < numNext)
+        {
+            if (found[a] < next[b])
+                a++;
+            else if (found[a] > next[b])
+                b++;
+            else
+            {
+                found[n++] = found[a++];
+                b++;
+            }
+        }
+
+        count = n;
+    }
+
+    bool *candidates = MemZeroAlloc(numFiles + 1);
+    AssertNotNull(candidates);
+    for (int i = 0; i < count; i++)
+        candidates[found[i]] = true;
+
+    MemFree(found);
+    MemFree(next);
+    return candidates;
+}
+
+// Adds a file found by IoWalkDir, which skips the same files as grep.
+static bool addBuildFile(const char *path, DirEntry *e, void *arg)
+{
+    builder *bd = arg;
+    if (bd->numFiles == bd->cap)
+    {
+        bd->cap = max(bd->cap * 2, 1024);
+        bd->files = bd->files == NULL ? MemAlloc(bd->cap * sizeof(buildFile))
+                                      : MemRealloc(bd->files, bd->cap * sizeof(buildFile));
+        AssertNotNull(bd->files);
+    }
+
+    bd->files[bd->numFiles++] = (buildFile){
+        .path = MemAlloc(strlen(path) + 1),
+        .modified = e->modified,
+        .size = e->size,
+        .oldNum = -1,
+    };
+
+    AssertNotNull(bd->files[bd->numFiles - 1].path);
+    strcpy(bd->files[bd->numFiles - 1].path, path);
+    return true;
+}
+
+// Reads the unique trigrams of each file that is not in the old index. seen
+// has a byte per key and is cleared again after each file.
+static void readFiles(void *arg)
+{
+    builder *bd = arg;
+    unsigned char *seen = MemZeroAlloc(NUM_KEYS);
+    int cap = KB(4);
+    int *keys = MemAlloc(cap * sizeof(int));
+    AssertNotNull(seen);
+    AssertNotNull(keys);
+
+    int k;
+    while ((k = __atomic_fetch_add(&bd->nextFile, 1, __ATOMIC_RELAXED)) < bd->numFiles)
+    {
+        buildFile *f = &bd->files[k];
+        if (f->oldNum != -1)
+            continue;
+
+        char path[PATH_MAX];
+        int size;
+        char *data = IoJoinPath(path, PATH_MAX, bd->dir, f->path) ? IoMapFile(path, &size) : NULL;
+        if (data == NULL)
+            continue;
+
+        int n = 0;
+        if (memchr(data, 0, min(size, BINARY_CHECK)) == NULL)
+        {
+            if (cap < min(size, NUM_KEYS) + 1)
+            {
+                cap = min(size, NUM_KEYS) + 1;
+                keys = MemRealloc(keys, cap * sizeof(int));
+                AssertNotNull(keys);
+            }
+
+            // Every key is written and only kept if it is new, which is
+            // faster than a branch that is taken at random
+            for (int i = 0; i + 3 <= size; i++)
+            {
+                int key = trigramKey(data + i);
+                keys[n] = key;
+                n += !seen[key];
+                seen[key] = 1;
+            }
+        }
+
+        IoUnmapFile(data, size);
+
+        for (int i = 0; i < n; i++)
+            seen[keys[i]] = 0;
+
+        if (n > 0)
+        {
+            f->keys = MemAlloc(n * sizeof(int));
+            AssertNotNull(f->keys);
+            memcpy(f->keys, keys, n * sizeof(int));
+            f->numKeys = n;
+        }
+    }
+
+    MemFree(keys);
+    MemFree(seen);
+}
+
+// Encoded posting lists of all keys
+typedef struct postingBuf
+{
+    unsigned char *data;
+    int length;
+    int cap;
+} postingBuf;
+
+static void encodeList(postingBuf *pb, int *ids, int count)
+{
+    // Varint deltas take at most 5 bytes each
+    if (pb->length + count * 5 > pb->cap)
+    {
+        pb->cap = max(pb->cap * 2, pb->length + count * 5);
+        pb->data = pb->data == NULL ? MemAlloc(pb->cap) : MemRealloc(pb->data, pb->cap);
+        AssertNotNull(pb->data);
+    }
+
+    unsigned char *p = pb->data + pb->length;
+    for (int i = 0, prev = -1; i < count; prev = ids[i++])
+    {
+        unsigned delta = ids[i] - prev;
+        while (delta >= 0x80)
+        {
+            *p++ = delta | 0x80;
+            delta >>= 7;
+        }
+        *p++ = delta;
+    }
+
+    pb->length = p - pb->data;
+}
+
+// Encodes the posting list of each key. Files that did not change keep their
+// lists from the old index, renumbered, and are merged with the files read.
+// Writes the start of each key to offsets.
+static void encodePostings(builder *bd, TrigramIndex *old, postingBuf *pb, int *offsets)
+{
+    // Files read for each key, in file order. starts holds the end of each
+    // key after the files are added.
+    int *starts = MemZeroAlloc((NUM_KEYS + 1) * sizeof(int));
+    AssertNotNull(starts);
+
+    int total = 0;
+    for (int i = 0; i < bd->numFiles; i++)
+    {
+        buildFile *f = &bd->files[i];
+        for (int k = 0; k < f->numKeys; k++)
+            starts[f->keys[k] + 1]++;
+        total += f->numKeys;
+    }
+
+    for (int key = 0; key < NUM_KEYS; key++)
+        starts[key + 1] += starts[key];
+
+    int *ids = MemAlloc((total + 1) * sizeof(int));
+    AssertNotNull(ids);
+    for (int i = 0; i < bd->numFiles; i++)
+        for (int k = 0; k < bd->files[i].numKeys; k++)
+            ids[starts[bd->files[i].keys[k]]++] = i;
+
+    // Old file numbers to new ones, -1 for files that changed or are gone
+    int numOld = old != NULL ? old->header->numFiles : 0;
+    int *newNum = MemAlloc((numOld + 1) * sizeof(int));
+    int *oldIds = MemAlloc((numOld + 1) * sizeof(int));
+    int *merged = MemAlloc((numOld + bd->numFiles + 1) * sizeof(int));
+    AssertNotNull(newNum);
+    AssertNotNull(oldIds);
+    AssertNotNull(merged);
+
+    for (int i = 0; i < numOld; i++)
+        newNum[i] = -1;
+    for (int i = 0; i < bd->numFiles; i++)
+        if (bd->files[i].oldNum != -1)
+            newNum[bd->files[i].oldNum] = i;
+
+    for (int key = 0, begin = 0; key < NUM_KEYS; begin = starts[key++])
+    {
+        offsets[key] = pb->length;
+
+        int numOldIds = 0;
+        bool sorted = true;
+        int count = old != NULL ? decodeKey(old, key, oldIds) : 0;
+        for (int i = 0; i < count; i++)
+        {
+            int num = newNum[oldIds[i]];
+            if (num == -1)
+                continue;
+
+            sorted = sorted && (numOldIds == 0 || num > oldIds[numOldIds - 1]);
+            oldIds[numOldIds++] = num;
+        }
+
+        // Directories are listed in name order, so the order only changes
+        // if the platform lists them differently
+        if (!sorted)
+            qsort(oldIds, numOldIds, sizeof(int), compareInt);
+
+        int a = 0, b = begin, n = 0;
+        while (a < numOldIds || b < starts[key])
+        {
+            if (b == starts[key] || (a < numOldIds && oldIds[a] < ids[b]))
+                merged[n++] = oldIds[a++];
+            else
+                merged[n++] = ids[b++];
+        }
+
+        encodeList(pb, merged, n);
+    }
+    offsets[NUM_KEYS] = pb->length;
+
+    MemFree(merged);
+    MemFree(oldIds);
+    MemFree(newNum);
+    MemFree(ids);
+    MemFree(starts);
+}
+
+// Writes the index of the files in bd. Returns its size, 0 on failure.
+static int writeIndex(builder *bd, TrigramIndex *old)
+{
+    int *offsets = MemAlloc((NUM_KEYS + 1) * sizeof(int));
+    AssertNotNull(offsets);
+    postingBuf pb = {0};
+    encodePostings(bd, old, &pb, offsets);
+
+    int pathBytes = 0;
+    for (int i = 0; i < bd->numFiles; i++)
+        pathBytes += strlen(bd->files[i].path) + 1;
+
+    // Offsets after the paths are aligned
+    pathBytes = (pathBytes + 7) & ~7;
+
+    long long size = sizeof(indexHeader) + (long long)bd->numFiles * sizeof(indexFile) + pathBytes +
+                     (NUM_KEYS + 1) * sizeof(int) + pb.length;
+    char *data = size <= INT_MAX ? MemZeroAlloc(size) : NULL;
+    if (data == NULL)
+    {
+        if (pb.data != NULL)
+            MemFree(pb.data);
+        MemFree(offsets);
+        return 0;
+    }
+
+    indexHeader *h = (indexHeader *)data;
+    memcpy(h->magic, INDEX_MAGIC, 8);
+    h->numFiles = bd->numFiles;
+    h->pathBytes = pathBytes;
+    h->postingBytes = pb.length;
+    h->built = time(NULL);
+
+    indexFile *files = (indexFile *)(data + sizeof(indexHeader));
+    char *paths = (char *)(files + bd->numFiles);
+    int pathPos = 0;
+    for (int i = 0; i < bd->numFiles; i++)
+    {
+        buildFile *f = &bd->files[i];
+        files[i] = (indexFile){.modified = f->modified, .size = f->size, .path = pathPos};
+        int length = strlen(f->path) + 1;
+        memcpy(paths + pathPos, f->path, length);
+        pathPos += length;
+    }
+
+    memcpy(paths + pathBytes, offsets, (NUM_KEYS + 1) * sizeof(int));
+    if (pb.length > 0)
+        memcpy(paths + pathBytes + (NUM_KEYS + 1) * sizeof(int), pb.data, pb.length);
+
+    char path[MAX_PATH];
+    IoJoinPath(path, MAX_PATH, bd->dir, INDEX_FILENAME);
+    if (!IoWriteFile(path, data, size))
+        size = 0;
+
+    if (pb.data != NULL)
+        MemFree(pb.data);
+    MemFree(data);
+    MemFree(offsets);
+    return size;
+}
+
+bool IndexBuild(char *dir, IndexStats *stats)
+{
+    builder bd = {0};
+    snprintf(bd.dir, MAX_PATH, "%s", dir);
+    IoWalkDir(dir, addBuildFile, &bd);
+    initClasses();
+
+    TrigramIndex *old = IndexLoad(dir);
+    int numRead = bd.numFiles;
+    for (int i = 0; old != NULL && i < bd.numFiles; i++)
+    {
+        buildFile *f = &bd.files[i];
+        f->oldNum = IndexFindFile(old, f->path, f->size, f->modified);
+        numRead -= f->oldNum != -1;
+    }
+
+    // Same files as before and none of them changed
+    int size = 0;
+    if (old != NULL && numRead == 0 && bd.numFiles == old->header->numFiles)
+        size = old->size;
+    else
+    {
+        Thread *threads[MAX_WORKERS];
+        int numThreads = 0;
+        for (int i = 0; i < WorkerCount() && numRead > 1; i++)
+        {
+            Thread *t = ThreadStart(readFiles, &bd);
+            if (t != NULL)
+                threads[numThreads++] = t;
+        }
+
+        if (numThreads == 0)
+            readFiles(&bd);
+        for (int i = 0; i < numThreads; i++)
+            ThreadJoin(threads[i]);
+
+        size = writeIndex(&bd, old);
+    }
+
+    if (stats != NULL)
+        *stats = (IndexStats){.files = bd.numFiles, .read = numRead, .bytes = size};
+
+    for (int i = 0; i < bd.numFiles; i++)
+    {
+        MemFree(bd.files[i].path);
+        if (bd.files[i].keys != NULL)
+            MemFree(bd.files[i].keys);
+    }
+
+    if (bd.files != NULL)
+        MemFree(bd.files);
+    IndexFree(old);
+    return size > 0;
+}
@@ -0,0 +1,279 @@
+// Substitute command, eg. %s/old/new/g. Each changed line is built once into a
+// new allocation and the old lines are saved as a single undo.
+
+#include "rum.h"
+
+extern Editor editor;
+
+// Replacement being applied to the lines of the current buffer.
+typedef struct replacer
+{
+    bool isRegex;
+    Regex *regex;
+    Searcher searcher;
+    int searchLen;
+    char *replace;
+    int replaceLen;
+    bool all; // Replace every match on a line, not only the first
+} replacer;
+
+// Scratch memory the new line is built in
+static CbStore lineStore = {0};
+
+// Finds the first match at or after from. Writes the match to start and end.
+// Regex matches may be empty.
+static bool findMatch(replacer *r, Line *line, int from, int *start, int *end)
+{
+    if (r->isRegex)
+        return from <= line->length && RegexFind(r->regex, line->chars, line->length, from, start, end);
+
+    char *p = SearchFind(&r->searcher, line->chars + from, line->length - from);
+    if (p == NULL)
+        return false;
+
+    *start = p - line->chars;
+    *end = *start + r->searchLen;
+    return true;
+}
+
+// Returns true if line has any match. Faster than findMatch for lines without one.
+static bool hasMatch(replacer *r, Line *line)
+{
+    if (r->isRegex)
+        return RegexTest(r->regex, line->chars, line->length);
+
+    return SearchFind(&r->searcher, line->chars, line->length) != NULL;
+}
+
+// Replaces the matches in row. Returns number of replacements.
+static int replaceLine(replacer *r, int row, UndoLines *undo)
+{
+    Line *line = &curBuffer->lines[row];
+    if (!hasMatch(r, line))
+        return 0;
+
+    CharBuf cb = CbNew(&lineStore);
+    int count = 0;
+    int pos = 0, start, end;
+    int prevEnd = -1; // End of the last non-empty match
+
+    while (findMatch(r, line, pos, &start, &end))
+    {
+        // An empty match right after a match is not replaced, like in vim
+        if (end == start && start == prevEnd)
+        {
+            if (end == line->length)
+                break;
+
+            CbAppend(&cb, line->chars + pos, start - pos + 1);
+            pos = start + 1;
+            continue;
+        }
+
+        if (end > start)
+            prevEnd = end;
+
+        CbAppend(&cb, line->chars + pos, start - pos);
+        CbAppend(&cb, r->replace, r->replaceLen);
+        count++;
+        pos = end;
+
+        // Step over the next character so an empty match is not found again
+        if (end == start)
+        {
+            if (end == line->length)
+                break;
+
+            CbAppend(&cb, line->chars + end, 1);
+            pos++;
+        }
+
+        if (!r->all)
+            break;
+    }
+
+    if (count == 0)
+        return 0;
+
+    CbAppend(&cb, line->chars + pos, line->length - pos);
+
+    int length = CbLength(&cb);
+    int cap = (length / LINE_DEFAULT_LENGTH + 1) * LINE_DEFAULT_LENGTH;
+    char *chars = MemZeroAlloc(cap);
+    AssertNotNull(chars);
+    memcpy(chars, cb.buffer, length);
+
+    UndoAddLine(undo, row, line->chars, line->length);
+    MemFree(BufferSwapLine(curBuffer, row, chars, length, cap));
+    return count;
+}
+
+int ReplaceText(char *search, int searchLen, char *replace, int replaceLen, int from, int to, bool all)
+{
+    char needle[MAX_SEARCH];
+    bool ignoreCase;
+    int needleLen = SearchParseCase(needle, search, searchLen, &ignoreCase);
+    if (needleLen == 0)
+        return 0;
+
+    replacer r = {
+        .isRegex = needleLen >= 2 && needle[0] == '\\' && needle[1] == 'v',
+        .searchLen = needleLen,
+        .replace = replace,
+        .replaceLen = replaceLen,
+        .all = all,
+    };
+
+    if (r.isRegex)
+    {
+        r.regex = RegexCompile(needle + 2, needleLen - 2, ignoreCase);
+        if (r.regex == NULL)
+            return -1;
+    }
+    else
+        SearchInit(&r.searcher, needle, needleLen, ignoreCase);
+
+    int searchIndexLen = MatchIndexPause(curBuffer);
+    UndoLines undo = {0};
+    int count = 0;
+    int lastRow = -1;
+
+    for (int row = max(from, 0); row <= min(to, curBuffer->numLines - 1); row++)
+    {
+        int n = replaceLine(&r, row, &undo);
+        if (n > 0)
+            lastRow = row;
+        count += n;
+    }
+
+    if (count > 0)
+    {
+        UndoSaveLines(&undo, curRow, curCol);
+        CursorSetPos(curBuffer, 0, lastRow, false);
+    }
+
+    MatchIndexResume(curBuffer, searchIndexLen);
+    RegexFree(r.regex);
+    return count;
+}
+
+// Returns the row of line address at s and moves s past it, -1 if there is none.
+// Addresses are a 1-based line number, . for the cursor row or $ for the last row.
+static int parseAddress(char **s)
+{
+    if (**s == '.')
+    {
+        (*s)++;
+        return curRow;
+    }
+
+    if (**s == '$')
+    {
+        (*s)++;
+        return curBuffer->numLines - 1;
+    }
+
+    if (!isdigit(**s))
+        return -1;
+
+    int n = strtol(*s, s, 10);
+    return max(n - 1, 0);
+}
+
+// Copies text up to an unescaped delimiter to dest and moves s past the
+// delimiter. Escaped delimiters are unescaped. With unescape \\ is also
+// turned into \, other escapes are kept for the regex. Returns the length.
+static int parsePart(char **s, char delim, char *dest, bool unescape)
+{
+    int length = 0;
+    char *p = *s;
+
+    while (*p != 0 && *p != delim)
+    {
+        if (p[0] == '\\' && (p[1] == delim || (unescape && p[1] == '\\')))
+            p++;
+
+        dest[length++] = *p++;
+    }
+
+    *s = *p == delim ? p + 1 : p;
+    return length;
+}
+
+bool ReplaceCommand(char *cmd)
+{
+    char *s = cmd;
+    int from = curRow, to = curRow;
+
+    if (*s == '%')
+    {
+        from = 0;
+        to = curBuffer->numLines - 1;
+        s++;
+    }
+    else if ((from = parseAddress(&s)) != -1)
+    {
+        to = from;
+        if (*s == ',')
+        {
+            s++;
+            if ((to = parseAddress(&s)) == -1)
+                return false;
+        }
+    }
+    else
+        from = curRow;
+
+    // Any delimiter that can not be part of a command name
+    if (s[0] != 's' || s[1] == 0 || isalnum(s[1]) || s[1] == ' ')
+        return false;
+
+    char delim = s[1];
+    s += 2;
+
+    char search[MAX_SEARCH];
+    char replace[MAX_SEARCH];
+    int searchLen = parsePart(&s, delim, search, false);
+    int replaceLen = parsePart(&s, delim, replace, true);
+
+    bool all = false;
+    for (; *s != 0; s++)
+    {
+        if (*s != 'g')
+        {
+            SetError("unknown flag, usage: [range]s/old/new/[g]");
+            return true;
+        }
+
+        all = true;
+    }
+
+    // Empty pattern uses the last search like vim
+    if (searchLen == 0)
+    {
+        searchLen = curBuffer->matches.length;
+        memcpy(search, curBuffer->matches.search, searchLen);
+    }
+
+    if (searchLen == 0)
+        SetError("no previous search");
+    else if (curBuffer->readOnly)
+        SetError("buffer is read-only");
+    else
+    {
+        if (from > to)
+        {
+            int tmp = from;
+            from = to;
+            to = tmp;
+        }
+
+        int count = ReplaceText(search, searchLen, replace, replaceLen, from, to, all);
+        if (count == -1)
+            SetError("invalid pattern");
+        else if (count == 0)
+            SetError("pattern not found");
+    }
+
+    return true;
+}
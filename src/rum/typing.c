@@ -88,7 +88,7 @@ void TypingBackspace()
         // Delete tab if prefixed whitespace is >= tabsize
         BufferDelete(curBuffer, config.tabSize);
         CursorMove(curBuffer, -config.tabSize, 0);
-        UndoSaveAction(A_BACKSPACE, editor.padBuffer, config.tabSize);
+        UndoSaveAction(A_BACKSPACE, EditorPadding(config.tabSize), config.tabSize);
         return;
     }
 
@@ -123,7 +123,7 @@ void TypingNewline()
     int pos = curLine.indent;
     UndoSaveActionEx(A_INSERT_LINE, curRow + 1, curCol, curLine.chars, curLine.length);
     BufferInsertLine(curBuffer, curRow + 1);
-    BufferWriteEx(curBuffer, curRow + 1, 0, editor.padBuffer, pos);
+    BufferWriteEx(curBuffer, curRow + 1, 0, EditorPadding(pos), pos);
     BufferMoveTextDown(curBuffer);
     CursorSetPos(curBuffer, pos, curRow + 1, false);
     if (config.matchParen)
@@ -147,7 +147,7 @@ void TypingInsertTab()
     if (curBuffer->readOnly)
         return;
     int tabs = min(config.tabSize, 8);
-    TypingWrite(editor.padBuffer, tabs);
+    TypingWrite(EditorPadding(tabs), tabs);
 }
 
 // Order sensitive
@@ -314,7 +314,9 @@ void TypingCommentOutLines(int from, int to)
     if (lineBegin == 0xFFFF) // Empty line
         return;
 
-    char comment[] = "//"; // Todo: comment in lang config
+    char *comment = "//";
+    if (curBuffer->lang != NULL && strlen(curBuffer->lang->comment) > 0)
+        comment = curBuffer->lang->comment;
     int commentLen = strlen(comment);
 
     bool commentOut = true;
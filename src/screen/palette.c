@@ -0,0 +1,81 @@
+// Conversion from 24-bit colors to the xterm 256 and 16 color palettes, used
+// for terminals that do not support truecolor or to reduce output size.
+
+#include "rum.h"
+
+// Standard xterm values for the 16 basic colors
+static const unsigned basic[16] = {
+    0x000000, 0x800000, 0x008000, 0x808000, 0x000080, 0x800080, 0x008080, 0xc0c0c0,
+    0x808080, 0xff0000, 0x00ff00, 0xffff00, 0x0000ff, 0xff00ff, 0x00ffff, 0xffffff,
+};
+
+// Levels of each component in the 6x6x6 color cube, index 16-231
+static const int cubeLevels[6] = {0, 95, 135, 175, 215, 255};
+
+static inline int distance(unsigned a, unsigned b)
+{
+    int dr = (int)((a >> 16) & 0xff) - (int)((b >> 16) & 0xff);
+    int dg = (int)((a >> 8) & 0xff) - (int)((b >> 8) & 0xff);
+    int db = (int)(a & 0xff) - (int)(b & 0xff);
+    return dr * dr + dg * dg + db * db;
+}
+
+static inline int cubeIndex(int v)
+{
+    if (v < 48)
+        return 0;
+    if (v < 115)
+        return 1;
+    return (v - 35) / 40;
+}
+
+static unsigned paletteColor(int idx)
+{
+    if (idx < 16)
+        return basic[idx];
+
+    if (idx < 232)
+    {
+        idx -= 16;
+        return (cubeLevels[idx / 36] << 16) | (cubeLevels[(idx / 6) % 6] << 8) | cubeLevels[idx % 6];
+    }
+
+    int gray = 8 + (idx - 232) * 10;
+    return (gray << 16) | (gray << 8) | gray;
+}
+
+// Returns nearest color in the cube or grayscale ramp. The 16 basic colors are
+// skipped since terminals often change them.
+static int nearest256(unsigned rgb)
+{
+    int r = (rgb >> 16) & 0xff, g = (rgb >> 8) & 0xff, b = rgb & 0xff;
+
+    int cube = 16 + cubeIndex(r) * 36 + cubeIndex(g) * 6 + cubeIndex(b);
+
+    int avg = (r + g + b) / 3;
+    int gray = 232 + clamp(0, 23, (avg - 3) / 10);
+
+    return distance(rgb, paletteColor(cube)) <= distance(rgb, paletteColor(gray)) ? cube : gray;
+}
+
+static int nearest16(unsigned rgb)
+{
+    int best = 0;
+    for (int i = 1; i < 16; i++)
+        if (distance(rgb, basic[i]) < distance(rgb, basic[best]))
+            best = i;
+    return best;
+}
+
+int ScreenColorIndex(unsigned rgb, ColorDepth depth)
+{
+    rgb &= 0xffffff;
+    return depth == COLOR_DEPTH_16 ? nearest16(rgb) : nearest256(rgb);
+}
+
+unsigned ScreenQuantizeColor(unsigned rgb, ColorDepth depth)
+{
+    if (depth == COLOR_DEPTH_TRUE)
+        return rgb;
+    return paletteColor(ScreenColorIndex(rgb, depth)) | (rgb & ~0xffffff);
+}
@@ -68,16 +68,13 @@ static void drawWelcomeScreen()
 // Renders everything to the terminal. Sets cursor position. Shows welcome screen.
 void Render()
 {
-    if (editor.hbuffer == INVALID_HANDLE_VALUE)
-        Error("Render called before csb init");
-
     if (editor.splitBuffers)
         BufferRenderSplit(editor.buffers[editor.leftBuffer], editor.buffers[editor.rightBuffer]);
     else
         BufferRenderFull(editor.buffers[editor.leftBuffer]);
 
     // Command line
-    CharBuf buf = CbNew(editor.renderBuffer);
+    CharBuf buf = CbNew(&editor.renderStore);
     drawCommandLine(&buf);
     CbRender(&buf, 0, editor.height - 1);
 
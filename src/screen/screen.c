@@ -1,11 +1,175 @@
+// The screen is a grid of cells that everything is drawn to. On flush the grid is
+// compared to what was last written to the terminal, and only changed runs of
+// cells are written, with as few cursor moves and color changes as possible.
+
 #include "rum.h"
 
 extern Editor editor;
 extern Config config;
 
+#define FLUSH_GAP 8         // Max unchanged cells to rewrite instead of moving the cursor
+#define FLUSH_CELL_SIZE 48  // Worst case bytes written per cell
+#define FLUSH_PREFIX_SIZE 16 // Space left before the frame for escapes known after drawing
+#define CURSOR_HIDE "\x1b[?25l"
+#define CURSOR_SHOW "\x1b[?25h"
+#define SYNC_BEGIN "\x1b[?2026h" // Terminal holds repaints until SYNC_END
+#define SYNC_END "\x1b[?2026l"
+
+typedef struct screen
+{
+    int width, height;
+    Cell *front; // What the terminal shows
+    Cell *back;  // What the next frame should show
+    bool fullRedraw;
+
+    int x, y;      // Draw position
+    unsigned fg;   // Draw colors
+    unsigned bg;   //
+    bool visible;  // Cursor visibility after flush
+
+    int cursorX, cursorY; // Last flushed cursor state
+    bool cursorVisible;
+
+    char *out; // Flush buffer
+    char scrollSeq[256]; // Scroll region escapes written before next flush
+    int scrollSeqLength;
+    ScreenStats stats;
+} screen;
+
+static screen scr = {0};
+
+// Reallocates the grids if the editor size has changed.
+static void screenFit()
+{
+    if (scr.width == editor.width && scr.height == editor.height && scr.back != NULL)
+        return;
+
+    if (scr.back != NULL)
+    {
+        MemFree(scr.front);
+        MemFree(scr.back);
+        MemFree(scr.out);
+    }
+
+    scr.width = max(editor.width, 1);
+    scr.height = max(editor.height, 1);
+
+    int size = scr.width * scr.height;
+    scr.front = MemZeroAlloc(size * sizeof(Cell));
+    scr.back = MemZeroAlloc(size * sizeof(Cell));
+    scr.out = MemAlloc(size * FLUSH_CELL_SIZE + KB(4));
+    AssertNotNull(scr.front);
+    AssertNotNull(scr.back);
+    AssertNotNull(scr.out);
+
+    for (int i = 0; i < size; i++)
+        scr.back[i] = (Cell){.ch = ' '};
+
+    scr.fullRedraw = true;
+    scr.cursorX = -1;
+    scr.cursorVisible = true; // Unknown, make sure it is hidden while drawing
+}
+
+// Parses "rrr;ggg;bbb" to a packed color.
+static unsigned parseColor(const char *s)
+{
+    unsigned rgb[3] = {0};
+    for (int i = 0; i < 3 && *s != 0; i++)
+    {
+        while (*s >= '0' && *s <= '9')
+            rgb[i] = rgb[i] * 10 + (*s++ - '0');
+        if (*s == ';')
+            s++;
+    }
+
+    return CELL_COLOR_SET | (rgb[0] << 16) | (rgb[1] << 8) | rgb[2];
+}
+
+// Applies escape sequence beginning at s[i]. Returns index of last byte in sequence.
+static int applyEscape(char *s, int length, int i)
+{
+    int params[8] = {0};
+    int numParams = 0;
+
+    i += 2; // ESC [
+    for (; i < length; i++)
+    {
+        char c = s[i];
+        if (c >= '0' && c <= '9')
+        {
+            params[numParams] = params[numParams] * 10 + (c - '0');
+            continue;
+        }
+
+        if (c == ';')
+        {
+            if (numParams < 7)
+                numParams++;
+            continue;
+        }
+
+        if (c != 'm') // Only colors are drawn to the grid
+            return i;
+
+        numParams++;
+        for (int p = 0; p < numParams; p++)
+        {
+            int code = params[p];
+            if (code == 0)
+                scr.fg = scr.bg = 0;
+            else if (code == 39)
+                scr.fg = 0;
+            else if (code == 49)
+                scr.bg = 0;
+            else if ((code == 38 || code == 48) && p + 4 < numParams && params[p + 1] == 2)
+            {
+                unsigned col = CELL_COLOR_SET | (params[p + 2] << 16) | (params[p + 3] << 8) | params[p + 4];
+                code == 38 ? (scr.fg = col) : (scr.bg = col);
+                p += 4;
+            }
+        }
+
+        return i;
+    }
+
+    return i;
+}
+
 void ScreenWrite(char *string, int length)
 {
-    TermWrite(string, length);
+    screenFit();
+    scr.stats.lastFrameIn += length;
+
+    for (int i = 0; i < length; i++)
+    {
+        char c = string[i];
+
+        if (c == '\x1b' && i + 1 < length && string[i + 1] == '[')
+        {
+            i = applyEscape(string, length, i);
+            continue;
+        }
+
+        if (c == '\n')
+        {
+            scr.x = 0;
+            scr.y++;
+            continue;
+        }
+
+        if (scr.y >= scr.height)
+            continue;
+
+        if (scr.x >= 0 && scr.y >= 0)
+            scr.back[scr.y * scr.width + scr.x] = (Cell){.fg = scr.fg, .bg = scr.bg, .ch = c};
+
+        // Wrap to next line like the terminal does
+        if (++scr.x >= scr.width)
+        {
+            scr.x = 0;
+            scr.y++;
+        }
+    }
 }
 
 void ScreenWriteAt(int x, int y, char *text)
@@ -16,6 +180,18 @@ void ScreenWriteAt(int x, int y, char *text)
     CursorShow();
 }
 
+void ScreenSetPos(int x, int y)
+{
+    screenFit();
+    scr.x = clamp(0, scr.width - 1, x);
+    scr.y = clamp(0, scr.height - 1, y);
+}
+
+void ScreenSetCursorVisible(bool visible)
+{
+    scr.visible = visible;
+}
+
 void ScreenColor(char *bg, char *fg)
 {
     ScreenBg(bg);
@@ -26,25 +202,234 @@ void ScreenBg(char *bg)
 {
     if (config.rawMode)
         return;
-    char col[32];
-    sprintf(col, "\x1b[48;2;%sm", bg);
-    ScreenWrite(col, strlen(col));
+    scr.bg = parseColor(bg);
 }
 
 void ScreenFg(char *fg)
 {
     if (config.rawMode)
         return;
-    char col[32];
-    sprintf(col, "\x1b[38;2;%sm", fg);
-    ScreenWrite(col, strlen(col));
+    scr.fg = parseColor(fg);
 }
 
-#define COL_RESET "\x1b[0m"
-
 void ScreenColorReset()
 {
-    if (config.rawMode)
+    scr.fg = scr.bg = 0;
+}
+
+void ScreenInvalidate()
+{
+    scr.fullRedraw = true;
+}
+
+void ScreenScroll(int top, int bottom, int n)
+{
+    screenFit();
+    top = max(top, 0);
+    bottom = min(bottom, scr.height - 1);
+
+    int rows = bottom - top + 1;
+    if (scr.fullRedraw || n == 0 || abs(n) >= rows || scr.scrollSeqLength > (int)sizeof(scr.scrollSeq) - 32)
         return;
-    ScreenWrite(COL_RESET, 4);
-}
\ No newline at end of file
+
+    // Set region, scroll up (S) or down (T), reset region
+    scr.scrollSeqLength += sprintf(scr.scrollSeq + scr.scrollSeqLength, "\x1b[%d;%dr\x1b[%d%c\x1b[r",
+                                   top + 1, bottom + 1, abs(n), n > 0 ? 'S' : 'T');
+
+    // Move front rows to match what the terminal shows after scrolling
+    int w = scr.width;
+    int moved = rows - abs(n);
+    Cell *region = scr.front + top * w;
+
+    if (n > 0)
+        memmove(region, region + n * w, moved * w * sizeof(Cell));
+    else
+        memmove(region - n * w, region, moved * w * sizeof(Cell));
+
+    // Exposed rows are cleared with the default colors
+    Cell *exposed = n > 0 ? region + moved * w : region;
+    for (int i = 0; i < abs(n) * w; i++)
+        exposed[i] = (Cell){.ch = ' '};
+}
+
+ScreenStats ScreenGetStats()
+{
+    return scr.stats;
+}
+
+static inline bool cellEqual(Cell a, Cell b)
+{
+    return a.ch == b.ch && a.fg == b.fg && a.bg == b.bg;
+}
+
+// Appends color parameters for fg (base 38) or bg (base 48) in the configured
+// color depth. Returns bytes written.
+static int writeColorParams(char *out, unsigned col, int base)
+{
+    if (!(col & CELL_COLOR_SET))
+        return sprintf(out, "%d", base + 1); // Default color
+
+    switch (config.colorDepth)
+    {
+    case COLOR_DEPTH_256:
+        return sprintf(out, "%d;5;%d", base, ScreenColorIndex(col, COLOR_DEPTH_256));
+
+    case COLOR_DEPTH_16:
+    {
+        // 30-37 and 90-97 for fg, 40-47 and 100-107 for bg
+        int idx = ScreenColorIndex(col, COLOR_DEPTH_16);
+        int code = idx < 8 ? base - 8 + idx : base + 52 + idx - 8;
+        return sprintf(out, "%d", code);
+    }
+
+    default:
+        return sprintf(out, "%d;2;%d;%d;%d", base, (col >> 16) & 0xff, (col >> 8) & 0xff, col & 0xff);
+    }
+}
+
+// Appends escape sequence for fg and/or bg to out. Returns bytes written.
+static int writeColor(char *out, unsigned fg, unsigned bg, bool setFg, bool setBg)
+{
+    int n = 0;
+    out[n++] = '\x1b';
+    out[n++] = '[';
+
+    if (setFg)
+        n += writeColorParams(out + n, fg, 38);
+
+    if (setFg && setBg)
+        out[n++] = ';';
+
+    if (setBg)
+        n += writeColorParams(out + n, bg, 48);
+
+    out[n++] = 'm';
+    return n;
+}
+
+// Appends cursor movement from (cx, cy) to (x, y). Returns bytes written.
+static int writeMove(char *out, int cx, int cy, int x, int y)
+{
+    if (cy == y && cx == x)
+        return 0;
+    if (cy == y && cx >= 0 && x > cx)
+        return sprintf(out, "\x1b[%dC", x - cx);
+    return sprintf(out, "\x1b[%d;%dH", y + 1, x + 1);
+}
+
+void ScreenFlush()
+{
+    screenFit();
+
+    // The whole frame, including cursor position and visibility, is written with
+    // a single TermWrite. Space is left at the start to hide the cursor while drawing.
+    char *out = scr.out + FLUSH_PREFIX_SIZE;
+    int n = 0;
+
+    if (!scr.fullRedraw)
+    {
+        memcpy(out, scr.scrollSeq, scr.scrollSeqLength);
+        n += scr.scrollSeqLength;
+    }
+    scr.scrollSeqLength = 0;
+
+    // Colors are always reset at the end of a flush
+    unsigned fg = 0;
+    unsigned bg = 0;
+    int cx = -1, cy = -1; // Terminal cursor position while writing, -1 if unknown
+
+    for (int y = 0; y < scr.height; y++)
+    {
+        Cell *front = scr.front + y * scr.width;
+        Cell *back = scr.back + y * scr.width;
+
+        int x = 0;
+        while (x < scr.width)
+        {
+            if (!scr.fullRedraw && cellEqual(front[x], back[x]))
+            {
+                x++;
+                continue;
+            }
+
+            // Find end of changed run, including short unchanged gaps
+            int end = x + 1;
+            int gap = 0;
+            while (end < scr.width && gap <= FLUSH_GAP)
+            {
+                if (scr.fullRedraw || !cellEqual(front[end], back[end]))
+                    gap = 0;
+                else
+                    gap++;
+                end++;
+            }
+            end -= gap;
+
+            n += writeMove(out + n, cx, cy, x, y);
+
+            for (; x < end; x++)
+            {
+                Cell c = back[x];
+                if (c.fg != fg || c.bg != bg)
+                {
+                    n += writeColor(out + n, c.fg, c.bg, c.fg != fg, c.bg != bg);
+                    fg = c.fg;
+                    bg = c.bg;
+                }
+                out[n++] = c.ch;
+            }
+
+            // Cursor position is unreliable after writing the last column
+            cx = x < scr.width ? x : -1;
+            cy = y;
+        }
+    }
+
+    char *frame = out;
+    bool drawn = n > 0;
+
+    if (drawn)
+    {
+        n += sprintf(out + n, COL_RESET);
+        scr.cursorX = -1;
+        memcpy(scr.front, scr.back, scr.width * scr.height * sizeof(Cell));
+
+        char prefix[FLUSH_PREFIX_SIZE];
+        int prefixLength = sprintf(prefix, "%s%s", config.syncOutput ? SYNC_BEGIN : "", scr.cursorVisible ? CURSOR_HIDE : "");
+        scr.cursorVisible = false;
+
+        frame -= prefixLength;
+        memcpy(frame, prefix, prefixLength);
+        n += prefixLength;
+    }
+
+    if (scr.cursorX != scr.x || scr.cursorY != scr.y)
+    {
+        n += sprintf(frame + n, "\x1b[%d;%dH", scr.y + 1, scr.x + 1);
+        scr.cursorX = scr.x;
+        scr.cursorY = scr.y;
+    }
+
+    if (scr.cursorVisible != scr.visible)
+    {
+        n += sprintf(frame + n, "%s", scr.visible ? CURSOR_SHOW : CURSOR_HIDE);
+        scr.cursorVisible = scr.visible;
+    }
+
+    if (drawn && config.syncOutput)
+        n += sprintf(frame + n, SYNC_END);
+
+    if (n > 0)
+    {
+        TermWrite(frame, n);
+        scr.stats.writes++;
+        scr.stats.bytesOut += n;
+        if (drawn)
+            scr.stats.frames++;
+    }
+
+    scr.stats.bytesIn += scr.stats.lastFrameIn;
+    scr.stats.lastFrameOut = n;
+    scr.stats.lastFrameIn = 0;
+    scr.fullRedraw = false;
+}
@@ -23,7 +23,7 @@ int drawBorder(int x, int y, int width, int height, char *title)
         width = max(width, titleLen);
     }
 
-    CharBuf cb = CbNew(editor.renderBuffer);
+    CharBuf cb = CbNew(&editor.renderStore);
 
     // Top bar
     CbColor(&cb, colors.bg0, colors.fg0);
@@ -76,7 +76,7 @@ UiStatus UiPromptYesNo(char *message, bool select)
     Render();
     editor.uiOpen = false;
 
-    CharBuf cb = CbNew(editor.renderBuffer);
+    CharBuf cb = CbNew(&editor.renderStore);
 
     int x = curBuffer->width / 2 - messageLen / 2;
     int y = curBuffer->height / 2 - 4;
@@ -123,8 +123,7 @@ void UiFreeResult(UiResult res)
 
 UiResult UiGetTextInput(char *prompt, int maxSize)
 {
-    char cbuf[1024];
-    CharBuf buf = CbNew(cbuf);
+    CharBuf buf = CbNew(&editor.renderStore);
 
     UiResult res = {
         .maxLength = maxSize,
@@ -187,6 +186,23 @@ UiResult UiPromptList(char **items, int numItems, char *prompt)
     return UiPromptListEx(items, numItems, prompt, 0);
 }
 
+void UiDrawList(char **items, int numItems, char *prompt, int selected, int x, int y, int width)
+{
+    int w = drawBorder(x - 1, y - 1, width + 2, numItems + 2, prompt);
+
+    for (int i = 0; i < numItems; i++)
+    {
+        int length = min((int)strlen(items[i]), w - 2);
+        CursorTempPos(x, y + i);
+        if (i == selected)
+            ScreenColor(colors.fg0, colors.bg0);
+        else
+            ScreenColor(colors.bg0, colors.fg0);
+        ScreenWrite(items[i], length);
+        ScreenWrite(EditorPadding(w - length - 2), w - length - 2);
+    }
+}
+
 UiResult UiPromptListEx(char **items, int numItems, char *prompt, int startIdx)
 {
     int width = min(curBuffer->width / 2, 30);
@@ -199,20 +215,7 @@ UiResult UiPromptListEx(char **items, int numItems, char *prompt, int startIdx)
 
     while (true)
     {
-        int w = drawBorder(x - 1, y - 1, width + 2, numItems + 2, prompt);
-
-        for (int i = 0; i < numItems; i++)
-        {
-            int length = strlen(items[i]);
-            CursorTempPos(x, y + i);
-            if (i == selected)
-                ScreenColor(colors.fg0, colors.bg0);
-            else
-                ScreenColor(colors.bg0, colors.fg0);
-            ScreenWrite(items[i], length);
-            ScreenWrite(editor.padBuffer, w - length - 2);
-        }
-
+        UiDrawList(items, numItems, prompt, selected, x, y, width);
         CursorHide();
 
         InputInfo info;
@@ -265,7 +268,7 @@ void UiShowCompletion(char **items, int numItems, int selected)
             : ScreenColor(colors.bg1, colors.fg0);
 
         ScreenWriteAt(x, y + i, items[i]);
-        ScreenWrite(editor.padBuffer, w - strlen(items[i]));
+        ScreenWrite(EditorPadding(w - strlen(items[i])), w - strlen(items[i]));
     }
 
     CursorUpdatePos();
@@ -340,14 +343,19 @@ void UiTextbox(const char *text)
     free(textPtr);
 }
 
+void UiDrawInputBox(char *prompt, char *text)
+{
+    int x = curBuffer->offX;
+    drawBorder(x, 0, curBuffer->width, 3, prompt);
+    ScreenWriteAt(x + 2, 1, text);
+}
+
 UiStatus UiInputBox(char *prompt, char *outBuf, int *outLen, int maxLen)
 {
     if (*outLen == 0)
         memset(outBuf, 0, maxLen);
 
-    int x = curBuffer->offX;
-    drawBorder(x, 0, curBuffer->width, 3, prompt);
-    ScreenWriteAt(x + 2, 1, outBuf);
+    UiDrawInputBox(prompt, outBuf);
 
     InputInfo info;
     while (true)
@@ -0,0 +1,358 @@
+// Shared lexer for all languages. Language definitions are loaded from config/syntax
+// and compiled into a character class table and a perfect hash table of keywords,
+// so highlighting cost does not depend on the language or its number of keywords.
+
+#include "rum.h"
+
+extern Colors colors;
+
+static Language languages[SYNTAX_MAX_LANGUAGES];
+static int numLanguages = 0;
+
+#define MAX_HASH_SIZE (1 << 16) // Max number of slots in keyword table
+#define MAX_HASH_SEEDS 256      // Number of seeds to try for each table size
+
+static inline unsigned hashWord(const char *word, int length, unsigned seed)
+{
+    unsigned h = seed * 2654435761u;
+    for (int i = 0; i < length; i++)
+        h = (h ^ (byte)word[i]) * 16777619u;
+    return h ^ (h >> 15);
+}
+
+void SyntaxInitLanguage(Language *lang)
+{
+    memset(lang, 0, sizeof(Language));
+
+    for (int c = 0; c < 256; c++)
+    {
+        if (isalpha(c) || c == '_')
+            lang->charClass[c] |= CC_WORD_START | CC_WORD;
+        if (isdigit(c))
+            lang->charClass[c] |= CC_DIGIT | CC_NUMBER | CC_WORD;
+    }
+}
+
+void SyntaxSetCharClass(Language *lang, const char *chars, CharClass class)
+{
+    for (; *chars != 0; chars++)
+        lang->charClass[(byte)*chars] |= class;
+}
+
+bool SyntaxCompileKeywords(Language *lang, char words[][SYNTAX_WORD_SIZE], byte *kinds, int numWords)
+{
+    Keyword *keywords = MemZeroAlloc(max(numWords, 1) * sizeof(Keyword));
+    AssertNotNull(keywords);
+
+    // Remove duplicates, first kind wins
+    int n = 0;
+    for (int i = 0; i < numWords; i++)
+    {
+        int length = strlen(words[i]);
+        bool duplicate = false;
+
+        for (int j = 0; j < n && !duplicate; j++)
+            duplicate = keywords[j].length == length && !memcmp(keywords[j].word, words[i], length);
+
+        if (duplicate || length == 0)
+            continue;
+
+        memcpy(keywords[n].word, words[i], length);
+        keywords[n].length = length;
+        keywords[n].kind = kinds[i];
+        n++;
+    }
+
+    // Find the smallest table size and seed with no collisions
+    int size = 16;
+    while (size < n * 4)
+        size *= 2;
+
+    for (; size <= MAX_HASH_SIZE; size *= 2)
+    {
+        unsigned short *slots = MemAlloc(size * sizeof(unsigned short));
+        AssertNotNull(slots);
+
+        for (unsigned seed = 1; seed <= MAX_HASH_SEEDS; seed++)
+        {
+            memset(slots, 0, size * sizeof(unsigned short));
+            bool ok = true;
+
+            for (int i = 0; i < n && ok; i++)
+            {
+                unsigned h = hashWord(keywords[i].word, keywords[i].length, seed) & (size - 1);
+                ok = slots[h] == 0;
+                slots[h] = i + 1;
+            }
+
+            if (ok)
+            {
+                lang->keywords = keywords;
+                lang->numKeywords = n;
+                lang->slots = slots;
+                lang->hashSeed = seed;
+                lang->hashMask = size - 1;
+                return true;
+            }
+        }
+
+        MemFree(slots);
+    }
+
+    MemFree(keywords);
+    return false;
+}
+
+bool SyntaxAddLanguage(Language *lang)
+{
+    if (numLanguages == SYNTAX_MAX_LANGUAGES)
+        return false;
+
+    // Mark first character of multi-char tokens so the lexer only
+    // compares prefixes when there can be a match
+    char *prefixes[] = {lang->comment, lang->blockCommentStart, lang->macroPrefix};
+    for (int i = 0; i < 3; i++)
+        lang->charClass[(byte)prefixes[i][0]] |= CC_SPECIAL;
+    for (int i = 0; i < lang->numObjectPrefixes; i++)
+        lang->charClass[(byte)lang->objectPrefixes[i][0]] |= CC_SPECIAL;
+    lang->charClass[0] &= ~CC_SPECIAL;
+
+    languages[numLanguages++] = *lang;
+    Logf("Added language %s with %d keywords", lang->name, lang->numKeywords);
+    return true;
+}
+
+Language *SyntaxFindLanguage(const char *extension)
+{
+    for (int i = 0; i < numLanguages; i++)
+    {
+        Language *lang = &languages[i];
+        if (!strcmp(lang->name, extension))
+            return lang;
+
+        for (int j = 0; j < lang->numExtensions; j++)
+            if (!strcmp(lang->extensions[j], extension))
+                return lang;
+    }
+
+    return NULL;
+}
+
+WordKind SyntaxLookupWord(Language *lang, const char *word, int length)
+{
+    if (lang->slots == NULL || length >= SYNTAX_WORD_SIZE)
+        return WORD_NONE;
+
+    int idx = lang->slots[hashWord(word, length, lang->hashSeed) & lang->hashMask];
+    if (idx == 0)
+        return WORD_NONE;
+
+    Keyword *k = &lang->keywords[idx - 1];
+    if (k->length == length && !memcmp(k->word, word, length))
+        return k->kind;
+
+    return WORD_NONE;
+}
+
+int SyntaxNumLanguages()
+{
+    return numLanguages;
+}
+
+Language *SyntaxGetLanguage(int idx)
+{
+    Assert(idx >= 0 && idx < numLanguages);
+    return &languages[idx];
+}
+
+typedef struct lexer
+{
+    const char *line;
+    int length;
+    CharBuf *cb;
+} lexer;
+
+// Appends line[start:end] with the given color.
+static inline void emit(lexer *lx, char *color, int start, int end)
+{
+    if (end <= start)
+        return;
+
+    CbFg(lx->cb, color); // Skipped when color is unchanged
+    CbAppend(lx->cb, (char *)lx->line + start, end - start);
+}
+
+// Returns length of seq if it is found at pos, otherwise 0.
+static inline int matchAt(lexer *lx, int pos, const char *seq)
+{
+    int length = strlen(seq);
+    if (length == 0 || pos + length > lx->length)
+        return 0;
+    return memcmp(lx->line + pos, seq, length) ? 0 : length;
+}
+
+static inline int scanWhile(lexer *lx, const byte *cls, int pos, byte class)
+{
+    while (pos < lx->length && (cls[(byte)lx->line[pos]] & class))
+        pos++;
+    return pos;
+}
+
+static char *wordColor(Language *lang, lexer *lx, int start, int end)
+{
+    const char *s = lx->line;
+
+    switch (SyntaxLookupWord(lang, s + start, end - start))
+    {
+    case WORD_KEYWORD:
+        return colors.keyword;
+    case WORD_TYPE:
+        return colors.type;
+    default:
+        break;
+    }
+
+    if (lang->functions && end < lx->length && s[end] == '(')
+        return colors.function;
+
+    if (lang->userTypes)
+    {
+        // Capitalized words or two words following eachother, eg. Buffer b
+        if (isupper(s[start]))
+            return colors.userType;
+        if (end + 1 < lx->length && s[end] == ' ' && (lang->charClass[(byte)s[end + 1]] & CC_WORD_START))
+            return colors.userType;
+    }
+
+    return colors.fg0;
+}
+
+void SyntaxColorLine(Language *lang, HlLine line, CharBuf *cb, int *state)
+{
+    const byte *cls = lang->charClass;
+    const char *s = line.line;
+    int n = line.length;
+    int i = 0;
+    bool isInclude = false;
+
+    lexer lx = {
+        .line = s,
+        .length = n,
+        .cb = cb,
+    };
+
+    while (i < n)
+    {
+        // Color everything grey until block comment ends
+        if (*state == LEX_BLOCK_COMMENT)
+        {
+            int start = i;
+            int endLen = 0;
+            while (i < n && (endLen = matchAt(&lx, i, lang->blockCommentEnd)) == 0)
+                i++;
+
+            i = min(i + endLen, n);
+            emit(&lx, colors.bg2, start, i);
+            if (endLen > 0)
+                *state = LEX_NORMAL;
+            continue;
+        }
+
+        byte c = s[i];
+        byte class = cls[c];
+        int start = i;
+        int length;
+
+        if (class & CC_SPECIAL)
+        {
+            // Single line comment
+            if (matchAt(&lx, i, lang->comment))
+            {
+                emit(&lx, colors.bg2, i, n);
+                return;
+            }
+
+            // Block comment begin
+            if ((length = matchAt(&lx, i, lang->blockCommentStart)) > 0)
+            {
+                emit(&lx, colors.bg2, i, i + length);
+                i += length;
+                *state = LEX_BLOCK_COMMENT;
+                continue;
+            }
+
+            // Macros and decorators, eg. #include or @property
+            if ((length = matchAt(&lx, i, lang->macroPrefix)) > 0)
+            {
+                emit(&lx, colors.bracket, i, i + length);
+                i += length;
+                int wordStart = i;
+                i = scanWhile(&lx, cls, i, CC_WORD);
+                emit(&lx, colors.symbol, wordStart, i);
+
+                int wordLen = i - wordStart;
+                if (wordLen > 0 && wordLen == (int)strlen(lang->includeWord) && !memcmp(s + wordStart, lang->includeWord, wordLen))
+                    isInclude = true;
+                continue;
+            }
+
+            // Object members, eg. .foo or ->foo
+            bool isObject = false;
+            for (int p = 0; p < lang->numObjectPrefixes && !isObject; p++)
+            {
+                length = matchAt(&lx, i, lang->objectPrefixes[p]);
+                if (length > 0 && i + length < n && (cls[(byte)s[i + length]] & CC_WORD_START))
+                {
+                    emit(&lx, colors.bracket, i, i + length);
+                    i += length;
+                    int wordStart = i;
+                    i = scanWhile(&lx, cls, i, CC_WORD);
+                    emit(&lx, colors.object, wordStart, i);
+                    isObject = true;
+                }
+            }
+
+            if (isObject)
+                continue;
+        }
+
+        // Stringify <foo.h>
+        if (isInclude && c == '<')
+        {
+            emit(&lx, colors.string, i, n);
+            return;
+        }
+
+        if (class & CC_STRING)
+        {
+            i++;
+            while (i < n && s[i] != c)
+                i += s[i] == '\\' ? 2 : 1;
+            i = min(i + 1, n);
+            emit(&lx, colors.string, start, i);
+            continue;
+        }
+
+        if (class & CC_DIGIT)
+        {
+            i = scanWhile(&lx, cls, i, CC_NUMBER);
+            emit(&lx, colors.number, start, i);
+            continue;
+        }
+
+        if (class & CC_WORD_START)
+        {
+            i = scanWhile(&lx, cls, i, CC_WORD);
+            emit(&lx, wordColor(lang, &lx, start, i), start, i);
+            continue;
+        }
+
+        if (class & CC_BRACKET)
+            emit(&lx, colors.bracket, i, i + 1);
+        else if (class & CC_SYMBOL)
+            emit(&lx, colors.symbol, i, i + 1);
+        else
+            emit(&lx, colors.fg0, i, i + 1);
+        i++;
+    }
+}
@@ -4,10 +4,8 @@ extern Editor editor;
 extern Colors colors;
 extern Config config;
 
-// Buffer written to and rendered with highlights.
-// Note: may cause segfault with long ass lines.
-#define HL_BUFSIZE 2048
-char hlBuffer[HL_BUFSIZE];
+// Buffer written to and rendered with highlights. Grows to fit long lines.
+static CbStore hlStore = {0};
 
 // Inserts highlight color at column a to b. b can be -1 to indicate end of line.
 static void highlightFromTo(HlLine *line, int a, int b, char *color)
@@ -15,9 +13,12 @@ static void highlightFromTo(HlLine *line, int a, int b, char *color)
     if (a == b)
         return;
 
-    // Switch to using hlbuffer
-    strncpy(hlBuffer, line->line, line->length);
-    line->line = hlBuffer;
+    // Switch to using hlStore, room for two highlight colors and the line color
+    bool inStore = line->line == hlStore.data;
+    CbStoreReserve(&hlStore, line->length + COLOR_BYTE_LENGTH * 3 + 1);
+    if (!inStore)
+        memcpy(hlStore.data, line->line, line->length);
+    line->line = hlStore.data;
 
     int rawLength = 0;
     int colLen = COLOR_BYTE_LENGTH;
@@ -97,34 +98,16 @@ HlLine HighlightLine(Buffer *b, HlLine line)
 // terminator. Writes byte length of highlighted text to newLength.
 HlLine ColorLine(Buffer *b, HlLine line)
 {
-    if (line.length == 0)
+    if (line.length == 0 || b->lang == NULL)
         return line;
 
-    CharBuf cb = CbNew(hlBuffer);
-    LineIterator iter = NewLineIterator(line.line, line.length);
+    char *lineBg = line.isCurrentLine && !b->showHighlight && b->showCurrentLineMark ? colors.bg1 : colors.bg0;
 
-    switch (b->fileType)
-    {
-    case FT_C:
-        langC(line, &iter, &cb);
-        break;
-
-    case FT_PYTHON:
-        langPy(line, &iter, &cb);
-        break;
-
-    case FT_JSON:
-        langJson(line, &iter, &cb);
-        break;
-
-    default:
-        return line;
-    }
-
-    if (line.isCurrentLine && !b->showHighlight && b->showCurrentLineMark)
-        CbColor(&cb, colors.bg1, colors.fg0);
-    else
-        CbColor(&cb, colors.bg0, colors.fg0);
+    // The line is rendered right after the line number, which sets the same colors
+    CharBuf cb = CbNew(&hlStore);
+    CbSetColorState(&cb, lineBg, colors.fg0);
+    SyntaxColorLine(b->lang, line, &cb, &b->hlState);
+    CbColor(&cb, lineBg, colors.fg0);
 
     return (HlLine){
         .length = CbLength(&cb),
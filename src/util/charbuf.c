@@ -5,13 +5,41 @@
 extern Editor editor;
 extern Config config;
 
-// Returns empty CharBuf mapped to input buffer.
-CharBuf CbNew(char *buffer)
+static long long escapeBytes = 0;
+
+void CbStoreReserve(CbStore *store, int size)
+{
+    if (size <= store->cap)
+        return;
+
+    // Grow in whole chunks, at least doubling to keep reallocation rare
+    int cap = max(store->cap * 2, ((size + CB_CHUNK_SIZE - 1) / CB_CHUNK_SIZE) * CB_CHUNK_SIZE);
+    store->data = store->data == NULL ? MemAlloc(cap) : MemRealloc(store->data, cap);
+    AssertNotNull(store->data);
+    store->cap = cap;
+}
+
+void CbStoreFree(CbStore *store)
+{
+    if (store->data != NULL)
+        MemFree(store->data);
+    store->data = NULL;
+    store->cap = 0;
+}
+
+// Returns empty CharBuf writing to store.
+CharBuf CbNew(CbStore *store)
 {
+    CbStoreReserve(store, CB_CHUNK_SIZE);
+
     CharBuf b;
-    b.buffer = buffer;
-    b.pos = buffer;
+    b.store = store;
+    b.buffer = store->data;
+    b.pos = store->data;
+    b.end = store->data + store->cap;
     b.lineLength = 0;
+    b.bg = NULL;
+    b.fg = NULL;
     return b;
 }
 
@@ -20,10 +48,28 @@ void CbReset(CharBuf *buf)
 {
     buf->pos = buf->buffer;
     buf->lineLength = 0;
+    buf->bg = NULL;
+    buf->fg = NULL;
+}
+
+// Makes room for size more bytes. Includes space for a NULL terminator.
+static inline void reserve(CharBuf *buf, int size)
+{
+    if (buf->pos + size < buf->end)
+        return;
+
+    int length = buf->pos - buf->buffer;
+    CbStoreReserve(buf->store, length + size + 1);
+    buf->buffer = buf->store->data;
+    buf->pos = buf->buffer + length;
+    buf->end = buf->buffer + buf->store->cap;
 }
 
 void CbAppend(CharBuf *buf, char *src, int length)
 {
+    if (length <= 0)
+        return;
+    reserve(buf, length);
     memcpy(buf->pos, src, length);
     buf->pos += length;
     buf->lineLength += length;
@@ -31,17 +77,18 @@ void CbAppend(CharBuf *buf, char *src, int length)
 
 void CbRepeat(CharBuf *buf, char c, int count)
 {
-    for (int i = 0; i < count; i++)
-        *(buf->pos++) = c;
+    if (count <= 0)
+        return;
+    reserve(buf, count);
+    memset(buf->pos, c, count);
+    buf->pos += count;
     buf->lineLength += count;
 }
 
 // Fills remaining line with space characters based on editor width.
 void CbNextLine(CharBuf *buf)
 {
-    int size = editor.width - buf->lineLength;
-    for (int i = 0; i < size; i++)
-        *(buf->pos++) = ' ';
+    CbRepeat(buf, ' ', editor.width - buf->lineLength);
     buf->lineLength = 0;
 }
 
@@ -58,26 +105,31 @@ void CbColorWord(CharBuf *cb, char *fg, char *word, int wordlen)
     CbAppend(cb, word, wordlen);
 }
 
+static inline bool sameColor(char *a, char *b)
+{
+    return a == b || (a != NULL && !strcmp(a, b));
+}
+
 void CbBg(CharBuf *buf, char *bg)
 {
-    if (config.rawMode)
+    if (config.rawMode || sameColor(buf->bg, bg))
         return;
-    char col[32];
-    sprintf(col, "\x1b[48;2;%sm", bg);
-    int length = strlen(col);
-    memcpy(buf->pos, col, length);
+    reserve(buf, 32);
+    int length = sprintf(buf->pos, "\x1b[48;2;%sm", bg);
     buf->pos += length;
+    buf->bg = bg;
+    escapeBytes += length;
 }
 
 void CbFg(CharBuf *buf, char *fg)
 {
-    if (config.rawMode)
+    if (config.rawMode || sameColor(buf->fg, fg))
         return;
-    char col[32];
-    sprintf(col, "\x1b[38;2;%sm", fg);
-    int length = strlen(col);
-    memcpy(buf->pos, col, length);
+    reserve(buf, 32);
+    int length = sprintf(buf->pos, "\x1b[38;2;%sm", fg);
     buf->pos += length;
+    buf->fg = fg;
+    escapeBytes += length;
 }
 
 // Resets colors in buffer
@@ -86,8 +138,23 @@ void CbColorReset(CharBuf *buf)
     if (config.rawMode)
         return;
     int length = strlen(COL_RESET);
+    reserve(buf, length);
     memcpy(buf->pos, COL_RESET, length);
     buf->pos += length;
+    buf->bg = NULL;
+    buf->fg = NULL;
+    escapeBytes += length;
+}
+
+void CbSetColorState(CharBuf *buf, char *bg, char *fg)
+{
+    buf->bg = bg;
+    buf->fg = fg;
+}
+
+long long CbEscapeBytes()
+{
+    return escapeBytes;
 }
 
 // Prints buffer at x, y with accumulated length only.
@@ -6,6 +6,13 @@ typedef void (*PlugInitFunc)(void);
 // Returns number of results. Returns -1 on error.
 int LoadPlugins(char *pluginDir, PlugInitFunc *results, size_t maxResults)
 {
+#ifndef _WIN32
+    // Plugins are DLLs, not supported on other platforms yet
+    (void)pluginDir;
+    (void)results;
+    (void)maxResults;
+    return 0;
+#else
     SetCurrentDirectoryA(pluginDir);
 
     WIN32_FIND_DATAA data;
@@ -42,4 +49,5 @@ int LoadPlugins(char *pluginDir, PlugInitFunc *results, size_t maxResults)
     } while (FindNextFileA(hfind, &data) != 0 && count < (int)maxResults);
 
     return count;
+#endif
 }
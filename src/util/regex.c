@@ -0,0 +1,1007 @@
+// Regular expressions for search. A pattern compiles to a Thompson NFA. Lines
+// are tested with a DFA built lazily from it, and match positions are found by
+// running the NFA as a Pike VM. Both take time linear in the length of the
+// text, there is no backtracking. Literal text the pattern starts with is
+// found with the substring search first, so only parts of the text that can
+// match are run through the automata.
+//
+// Syntax: . [abc] [^a-z] \d \w \s \D \W \S * + ? {n} {n,} {n,m} | ( ) ^ $
+// Any other character after \ is matched literally.
+
+#include "rum.h"
+
+#define NFA_MAX_STATES 20000 // Limits counted repetition
+#define REPEAT_MAX 1000      // Largest count in {n,m}
+#define DFA_MAX_STATES 1024  // Cached DFA states, the cache is flushed when full
+#define DFA_TABLE_SIZE 4096  // Hash table of DFA states, power of two
+
+#define TRANS_UNKNOWN -1 // Transition not computed yet
+#define TRANS_MATCH -2   // Transition to a state that contains the match
+
+typedef enum NfaType
+{
+    NFA_SET,   // Consumes a byte in set
+    NFA_SPLIT, // Continues at out and out1, out has priority
+    NFA_EMPTY, // Continues at out
+    NFA_BOL,   // Continues at out at beginning of text
+    NFA_EOL,   // Continues at out at end of text
+    NFA_MATCH,
+} NfaType;
+
+typedef struct nfaState
+{
+    NfaType type;
+    int out, out1;
+    int set; // Index of byte set for NFA_SET
+} nfaState;
+
+typedef struct byteSet
+{
+    unsigned bits[8];
+} byteSet;
+
+// Set of NFA states the NFA can be in after reading some text. Only states that
+// consume bytes, end of text checks and the match state are kept.
+typedef struct dfaState
+{
+    int ids;         // Offset of sorted NFA state ids in the pool
+    int numIds;
+    bool isMatch;    // Contains the match state
+    bool matchAtEnd; // Matches if the text ends here
+} dfaState;
+
+// Thread of the Pike VM
+typedef struct thread
+{
+    int pc;
+    int start; // Where the match started
+} thread;
+
+typedef struct threadList
+{
+    thread *threads;
+    int count;
+    unsigned gen; // Marks states on this list
+} threadList;
+
+struct Regex
+{
+    nfaState *states;
+    int numStates;
+    int capStates;
+    byteSet *sets;
+    int numSets;
+    int capSets;
+    int start;
+    bool ignoreCase; // Sets have both cases of each letter
+
+    char prefix[MAX_SEARCH]; // Literal text every match starts with
+    int prefixLen;
+    Searcher prefixSearch;
+
+    // Bytes that can begin a match. The DFA stays in its start state on any
+    // other byte, so they are skipped. 0 if there are too many to be worth it.
+    int numFirstBytes;
+    bool firstBytes[256];
+    byte firstByte; // The only one if there is one
+
+    dfaState *dfa;
+    int numDfa;
+    int *trans; // 256 transitions per DFA state. Index of next state * 256, or TRANS_*
+    int *pool; // NFA state ids of all DFA states
+    int poolLength;
+    int poolCap;
+    int table[DFA_TABLE_SIZE]; // DFA state index + 1, 0 if empty
+    int startDfa[2];           // Start state after text and at beginning of text, -1 if not added
+    int flushes;               // Number of times the DFA cache was flushed
+
+    // Scratch memory, sized by number of NFA states
+    unsigned *marks;
+    unsigned gen;
+    int *stack;
+    int *work;
+    threadList lists[2];
+};
+
+typedef struct fragment
+{
+    int start;
+    int end; // NFA_EMPTY state with no out yet
+} fragment;
+
+typedef struct parser
+{
+    Regex *re;
+    const char *p;
+    const char *end;
+    bool error;
+} parser;
+
+static inline bool setHas(byteSet *s, byte c)
+{
+    return s->bits[c >> 5] & (1u << (c & 31));
+}
+
+static inline void setAdd(byteSet *s, byte c)
+{
+    s->bits[c >> 5] |= 1u << (c & 31);
+}
+
+static void setAddClass(byteSet *s, char c)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        bool in = false;
+        switch (tolower(c))
+        {
+        case 'd':
+            in = isdigit(i);
+            break;
+        case 'w':
+            in = isalnum(i) || i == '_';
+            break;
+        case 's':
+            in = isspace(i);
+            break;
+        }
+
+        // Upper case letter is the complement
+        if (in != (bool)isupper(c))
+            setAdd(s, i);
+    }
+}
+
+// Adds the other case of each letter in s.
+static void setFoldCase(byteSet *s)
+{
+    for (int c = 'a'; c <= 'z'; c++)
+    {
+        if (setHas(s, c) || setHas(s, toupper(c)))
+        {
+            setAdd(s, c);
+            setAdd(s, toupper(c));
+        }
+    }
+}
+
+static bool isClassEscape(char c)
+{
+    return strchr("dwsDWS", c) != NULL && c != 0;
+}
+
+// Returns the byte for escape sequence \c.
+static byte escapedByte(char c)
+{
+    switch (c)
+    {
+    case 't':
+        return '\t';
+    case 'n':
+        return '\n';
+    case 'r':
+        return '\r';
+    }
+    return c;
+}
+
+static int newState(parser *p, NfaType type, int out, int out1)
+{
+    Regex *re = p->re;
+    if (re->numStates == NFA_MAX_STATES)
+    {
+        p->error = true;
+        return 0;
+    }
+
+    if (re->numStates == re->capStates)
+    {
+        re->capStates = max(re->capStates * 2, 64);
+        re->states = re->states == NULL
+                         ? MemAlloc(re->capStates * sizeof(nfaState))
+                         : MemRealloc(re->states, re->capStates * sizeof(nfaState));
+        AssertNotNull(re->states);
+    }
+
+    re->states[re->numStates] = (nfaState){.type = type, .out = out, .out1 = out1, .set = -1};
+    return re->numStates++;
+}
+
+static int newSet(parser *p)
+{
+    Regex *re = p->re;
+    if (re->numSets == re->capSets)
+    {
+        re->capSets = max(re->capSets * 2, 16);
+        re->sets = re->sets == NULL
+                       ? MemAlloc(re->capSets * sizeof(byteSet))
+                       : MemRealloc(re->sets, re->capSets * sizeof(byteSet));
+        AssertNotNull(re->sets);
+    }
+
+    re->sets[re->numSets] = (byteSet){0};
+    return re->numSets++;
+}
+
+static void patch(parser *p, int from, int to)
+{
+    p->re->states[from].out = to;
+}
+
+static fragment fragEmpty(parser *p)
+{
+    int s = newState(p, NFA_EMPTY, -1, -1);
+    return (fragment){s, s};
+}
+
+// Fragment of a single state followed by an empty end state.
+static fragment fragSingle(parser *p, NfaType type, int set)
+{
+    int end = newState(p, NFA_EMPTY, -1, -1);
+    int s = newState(p, type, end, -1);
+    p->re->states[s].set = set;
+    return (fragment){s, end};
+}
+
+static fragment fragConcat(parser *p, fragment a, fragment b)
+{
+    patch(p, a.end, b.start);
+    return (fragment){a.start, b.end};
+}
+
+static fragment fragAlt(parser *p, fragment a, fragment b)
+{
+    int end = newState(p, NFA_EMPTY, -1, -1);
+    int s = newState(p, NFA_SPLIT, a.start, b.start);
+    patch(p, a.end, end);
+    patch(p, b.end, end);
+    return (fragment){s, end};
+}
+
+static fragment fragStar(parser *p, fragment a)
+{
+    int end = newState(p, NFA_EMPTY, -1, -1);
+    int s = newState(p, NFA_SPLIT, a.start, end);
+    patch(p, a.end, s);
+    return (fragment){s, end};
+}
+
+static fragment fragPlus(parser *p, fragment a)
+{
+    int end = newState(p, NFA_EMPTY, -1, -1);
+    int s = newState(p, NFA_SPLIT, a.start, end);
+    patch(p, a.end, s);
+    return (fragment){a.start, end};
+}
+
+static fragment fragQuest(parser *p, fragment a)
+{
+    int end = newState(p, NFA_EMPTY, -1, -1);
+    int s = newState(p, NFA_SPLIT, a.start, end);
+    patch(p, a.end, end);
+    return (fragment){s, end};
+}
+
+static fragment parseAlt(parser *p);
+static void closure(Regex *re, int s, bool bol, int *count);
+
+// Parses the inside of [...]. p is after the opening bracket.
+static fragment parseClass(parser *p)
+{
+    int set = newSet(p);
+    byteSet s = {0};
+
+    bool negate = p->p < p->end && *p->p == '^';
+    if (negate)
+        p->p++;
+
+    bool first = true;
+    while (p->p < p->end && (*p->p != ']' || first))
+    {
+        first = false;
+        byte c = *p->p++;
+
+        if (c == '\\' && p->p < p->end)
+        {
+            char e = *p->p++;
+            if (isClassEscape(e))
+            {
+                setAddClass(&s, e);
+                continue;
+            }
+            c = escapedByte(e);
+        }
+
+        // Range, a trailing - is literal
+        byte last = c;
+        if (p->end - p->p >= 2 && p->p[0] == '-' && p->p[1] != ']')
+        {
+            p->p++;
+            last = *p->p++;
+            if (last == '\\' && p->p < p->end)
+                last = escapedByte(*p->p++);
+            if (last < c)
+            {
+                p->error = true;
+                return fragEmpty(p);
+            }
+        }
+
+        for (int i = c; i <= last; i++)
+            setAdd(&s, i);
+    }
+
+    if (p->p == p->end)
+    {
+        p->error = true;
+        return fragEmpty(p);
+    }
+
+    p->p++; // ]
+    if (p->re->ignoreCase)
+        setFoldCase(&s);
+    if (negate)
+        for (int i = 0; i < 8; i++)
+            s.bits[i] = ~s.bits[i];
+
+    p->re->sets[set] = s;
+    return fragSingle(p, NFA_SET, set);
+}
+
+static fragment parseAtom(parser *p)
+{
+    char c = *p->p++;
+    int set;
+
+    switch (c)
+    {
+    case '(':
+    {
+        fragment f = parseAlt(p);
+        if (p->p == p->end || *p->p != ')')
+            p->error = true;
+        else
+            p->p++;
+        return f;
+    }
+
+    case '[':
+        return parseClass(p);
+
+    case '.':
+        set = newSet(p);
+        memset(p->re->sets[set].bits, 0xff, sizeof(byteSet));
+        return fragSingle(p, NFA_SET, set);
+
+    case '^':
+        return fragSingle(p, NFA_BOL, -1);
+
+    case '$':
+        return fragSingle(p, NFA_EOL, -1);
+
+    case '*':
+    case '+':
+    case '?':
+        p->error = true; // Nothing to repeat
+        return fragEmpty(p);
+    }
+
+    set = newSet(p);
+    if (c == '\\')
+    {
+        if (p->p == p->end)
+        {
+            p->error = true;
+            return fragEmpty(p);
+        }
+
+        c = *p->p++;
+        if (isClassEscape(c))
+        {
+            setAddClass(&p->re->sets[set], c);
+            return fragSingle(p, NFA_SET, set);
+        }
+        c = escapedByte(c);
+    }
+
+    setAdd(&p->re->sets[set], c);
+    if (p->re->ignoreCase)
+        setFoldCase(&p->re->sets[set]);
+    return fragSingle(p, NFA_SET, set);
+}
+
+// Parses {n}, {n,} or {n,m}. Hi is -1 if there is no upper bound. Returns
+// false and leaves p unchanged if it is not a count, the { is then a literal.
+static bool parseCount(parser *p, int *lo, int *hi)
+{
+    const char *s = p->p + 1;
+    if (s >= p->end || !isdigit(*s))
+        return false;
+
+    *lo = 0;
+    while (s < p->end && isdigit(*s) && *lo <= REPEAT_MAX)
+        *lo = *lo * 10 + *s++ - '0';
+
+    *hi = *lo;
+    if (s < p->end && *s == ',')
+    {
+        s++;
+        *hi = -1;
+        if (s < p->end && isdigit(*s))
+        {
+            *hi = 0;
+            while (s < p->end && isdigit(*s) && *hi <= REPEAT_MAX)
+                *hi = *hi * 10 + *s++ - '0';
+        }
+    }
+
+    if (s == p->end || *s != '}')
+        return false;
+
+    if (*lo > REPEAT_MAX || *hi > REPEAT_MAX || (*hi != -1 && *hi < *lo))
+        p->error = true;
+
+    p->p = s + 1;
+    return true;
+}
+
+// Parses atom again to get a copy of its states.
+static fragment copyAtom(parser *p, const char *atom)
+{
+    const char *pos = p->p;
+    p->p = atom;
+    fragment f = parseAtom(p);
+    p->p = pos;
+    return f;
+}
+
+static fragment parseRepeat(parser *p)
+{
+    const char *atom = p->p;
+    fragment f = parseAtom(p);
+    bool repeated = false;
+
+    while (p->p < p->end && !p->error)
+    {
+        char c = *p->p;
+        int lo, hi;
+
+        if (c == '*')
+            f = fragStar(p, f);
+        else if (c == '+')
+            f = fragPlus(p, f);
+        else if (c == '?')
+            f = fragQuest(p, f);
+        else if (c == '{' && !repeated && parseCount(p, &lo, &hi))
+        {
+            // The parsed atom is the first copy
+            fragment r = lo > 0 ? f : fragEmpty(p);
+            for (int i = 1; i < lo && !p->error; i++)
+                r = fragConcat(p, r, copyAtom(p, atom));
+
+            if (hi == -1)
+                r = fragConcat(p, r, fragStar(p, lo > 0 ? copyAtom(p, atom) : f));
+            for (int i = max(lo, 1); i < hi && !p->error; i++)
+                r = fragConcat(p, r, fragQuest(p, copyAtom(p, atom)));
+            if (lo == 0 && hi > 0)
+                r = fragConcat(p, r, fragQuest(p, f));
+
+            f = r;
+            repeated = true;
+            continue;
+        }
+        else
+            break;
+
+        p->p++;
+        repeated = true;
+    }
+
+    return f;
+}
+
+static fragment parseConcat(parser *p)
+{
+    fragment f = fragEmpty(p);
+    while (p->p < p->end && *p->p != '|' && *p->p != ')' && !p->error)
+        f = fragConcat(p, f, parseRepeat(p));
+    return f;
+}
+
+static fragment parseAlt(parser *p)
+{
+    fragment f = parseConcat(p);
+    while (p->p < p->end && *p->p == '|' && !p->error)
+    {
+        p->p++;
+        f = fragAlt(p, f, parseConcat(p));
+    }
+    return f;
+}
+
+// Follows the chain of single bytes from the start state. Every match begins
+// with them since there is no other way through the chain.
+static void findPrefix(Regex *re)
+{
+    int s = re->start;
+    re->prefixLen = 0;
+
+    while (re->prefixLen < MAX_SEARCH)
+    {
+        nfaState *st = &re->states[s];
+        if (st->type == NFA_EMPTY)
+        {
+            s = st->out;
+            continue;
+        }
+
+        if (st->type != NFA_SET)
+            break;
+
+        byteSet *set = &re->sets[st->set];
+        int count = 0;
+        int c = 0;
+        for (int i = 0; i < 8; i++)
+            count += __builtin_popcount(set->bits[i]);
+
+        while (!setHas(set, c))
+            c++;
+
+        // Ignoring case a letter is in the set with its uppercase, which comes first
+        bool letterPair = re->ignoreCase && count == 2 && isupper(c) && setHas(set, tolower(c));
+        if (count != 1 && !letterPair)
+            break;
+
+        re->prefix[re->prefixLen++] = letterPair ? tolower(c) : c;
+        s = st->out;
+    }
+
+    SearchInit(&re->prefixSearch, re->prefix, re->prefixLen, re->ignoreCase);
+}
+
+#define MAX_FIRST_BYTES 16
+
+static void findFirstBytes(Regex *re)
+{
+    int count = 0;
+    re->gen++;
+    closure(re, re->start, false, &count);
+
+    byteSet first = {0};
+    for (int i = 0; i < count; i++)
+    {
+        nfaState *st = &re->states[re->work[i]];
+        if (st->type != NFA_SET)
+            return; // Matches an empty string
+
+        for (int j = 0; j < 8; j++)
+            first.bits[j] |= re->sets[st->set].bits[j];
+    }
+
+    for (int c = 0; c < 256; c++)
+    {
+        re->firstBytes[c] = setHas(&first, c);
+        if (re->firstBytes[c])
+        {
+            re->firstByte = c;
+            re->numFirstBytes++;
+        }
+    }
+
+    if (re->numFirstBytes > MAX_FIRST_BYTES)
+        re->numFirstBytes = 0;
+}
+
+// Returns position of first byte at or after i that can begin a match, length if none.
+static int skipToFirstByte(Regex *re, const char *text, int i, int length)
+{
+    if (re->numFirstBytes == 1)
+    {
+        char *p = memchr(text + i, re->firstByte, length - i);
+        return p != NULL ? p - text : length;
+    }
+
+    while (i < length && !re->firstBytes[(byte)text[i]])
+        i++;
+    return i;
+}
+
+static void dfaFlush(Regex *re)
+{
+    re->numDfa = 0;
+    re->flushes++;
+    re->poolLength = 0;
+    re->startDfa[0] = re->startDfa[1] = -1;
+    memset(re->table, 0, sizeof(re->table));
+}
+
+Regex *RegexCompile(const char *pattern, int length, bool ignoreCase)
+{
+    Regex *re = MemZeroAlloc(sizeof(Regex));
+    AssertNotNull(re);
+    re->ignoreCase = ignoreCase;
+
+    parser p = {.re = re, .p = pattern, .end = pattern + length};
+    fragment f = parseAlt(&p);
+
+    // Stopped early at an unmatched )
+    if (p.p != p.end)
+        p.error = true;
+
+    if (!p.error)
+    {
+        int match = newState(&p, NFA_MATCH, -1, -1);
+        patch(&p, f.end, match);
+        re->start = f.start;
+    }
+
+    if (p.error)
+    {
+        RegexFree(re);
+        return NULL;
+    }
+
+    findPrefix(re);
+
+    int n = re->numStates;
+    re->marks = MemZeroAlloc(n * sizeof(unsigned));
+    re->stack = MemAlloc((n * 2 + 2) * sizeof(int)); // States push at most two others
+    re->work = MemAlloc(n * sizeof(int));
+    re->lists[0].threads = MemAlloc(n * sizeof(thread));
+    re->lists[1].threads = MemAlloc(n * sizeof(thread));
+    re->dfa = MemAlloc(DFA_MAX_STATES * sizeof(dfaState));
+    re->trans = MemAlloc(DFA_MAX_STATES * 256 * sizeof(int));
+    AssertNotNull(re->dfa);
+    AssertNotNull(re->trans);
+
+    findFirstBytes(re);
+    dfaFlush(re);
+    return re;
+}
+
+void RegexFree(Regex *re)
+{
+    if (re == NULL)
+        return;
+
+    MemFree(re->states);
+    MemFree(re->sets);
+    MemFree(re->marks);
+    MemFree(re->stack);
+    MemFree(re->work);
+    MemFree(re->lists[0].threads);
+    MemFree(re->lists[1].threads);
+    MemFree(re->dfa);
+    MemFree(re->trans);
+    MemFree(re->pool);
+    MemFree(re);
+}
+
+const char *RegexPrefix(Regex *re, int *length)
+{
+    *length = re->prefixLen;
+    return re->prefix;
+}
+
+// Adds the states reachable from s without consuming a byte to the work set.
+static void closure(Regex *re, int s, bool bol, int *count)
+{
+    int top = 0;
+    re->stack[top++] = s;
+
+    while (top > 0)
+    {
+        s = re->stack[--top];
+        if (re->marks[s] == re->gen)
+            continue;
+        re->marks[s] = re->gen;
+
+        nfaState *st = &re->states[s];
+        switch (st->type)
+        {
+        case NFA_EMPTY:
+            re->stack[top++] = st->out;
+            break;
+        case NFA_SPLIT:
+            re->stack[top++] = st->out1;
+            re->stack[top++] = st->out;
+            break;
+        case NFA_BOL:
+            if (bol)
+                re->stack[top++] = st->out;
+            break;
+        default:
+            re->work[(*count)++] = s;
+            break;
+        }
+    }
+}
+
+// Returns true if the match state can be reached from s at the end of text.
+static bool matchesAtEnd(Regex *re, int s)
+{
+    re->gen++;
+    int top = 0;
+    re->stack[top++] = s;
+
+    while (top > 0)
+    {
+        s = re->stack[--top];
+        if (re->marks[s] == re->gen)
+            continue;
+        re->marks[s] = re->gen;
+
+        nfaState *st = &re->states[s];
+        if (st->type == NFA_MATCH)
+            return true;
+        if (st->type == NFA_SPLIT)
+            re->stack[top++] = st->out1;
+        if (st->type == NFA_SPLIT || st->type == NFA_EMPTY || st->type == NFA_EOL)
+            re->stack[top++] = st->out;
+    }
+
+    return false;
+}
+
+static int compareInt(const void *a, const void *b)
+{
+    return *(int *)a - *(int *)b;
+}
+
+static unsigned hashIds(int *ids, int count)
+{
+    unsigned h = 2166136261u;
+    for (int i = 0; i < count; i++)
+        h = (h ^ ids[i]) * 16777619u;
+    return h;
+}
+
+// Returns the DFA state for the set of NFA states in work, adding it if it is new.
+static int dfaAdd(Regex *re, int count)
+{
+    int *ids = re->work;
+    qsort(ids, count, sizeof(int), compareInt);
+
+    unsigned h = hashIds(ids, count) & (DFA_TABLE_SIZE - 1);
+    while (re->table[h] != 0)
+    {
+        dfaState *d = &re->dfa[re->table[h] - 1];
+        if (d->numIds == count && !memcmp(re->pool + d->ids, ids, count * sizeof(int)))
+            return re->table[h] - 1;
+        h = (h + 1) & (DFA_TABLE_SIZE - 1);
+    }
+
+    // Cache is full, start over. Only the new state is kept.
+    if (re->numDfa == DFA_MAX_STATES)
+    {
+        dfaFlush(re);
+        return dfaAdd(re, count);
+    }
+
+    if (re->poolLength + count > re->poolCap)
+    {
+        re->poolCap = max(re->poolCap * 2, re->poolLength + count + 1024);
+        re->pool = re->pool == NULL
+                       ? MemAlloc(re->poolCap * sizeof(int))
+                       : MemRealloc(re->pool, re->poolCap * sizeof(int));
+        AssertNotNull(re->pool);
+    }
+
+    int idx = re->numDfa++;
+    dfaState *d = &re->dfa[idx];
+    d->ids = re->poolLength;
+    d->numIds = count;
+    d->isMatch = false;
+    d->matchAtEnd = false;
+    memset(re->trans + idx * 256, 0xff, 256 * sizeof(int)); // TRANS_UNKNOWN
+    memcpy(re->pool + d->ids, ids, count * sizeof(int));
+    re->poolLength += count;
+
+    for (int i = 0; i < count; i++)
+    {
+        NfaType type = re->states[ids[i]].type;
+        if (type == NFA_MATCH)
+            d->isMatch = true;
+        if (type == NFA_EOL && !d->matchAtEnd)
+            d->matchAtEnd = matchesAtEnd(re, ids[i]);
+    }
+
+    d->matchAtEnd |= d->isMatch;
+    re->table[h] = idx + 1;
+    return idx;
+}
+
+static int dfaStart(Regex *re, bool bol)
+{
+    if (re->startDfa[bol] == -1)
+    {
+        int count = 0;
+        re->gen++;
+        closure(re, re->start, bol, &count);
+        re->startDfa[bol] = dfaAdd(re, count);
+    }
+
+    return re->startDfa[bol];
+}
+
+// Computes the state after reading c in state d. A new match can start at
+// every position, so the start state is always added too.
+static int dfaStep(Regex *re, int d, byte c)
+{
+    int count = 0;
+    re->gen++;
+
+    dfaState *from = &re->dfa[d];
+    int *ids = re->pool + from->ids;
+    for (int i = 0; i < from->numIds; i++)
+    {
+        nfaState *st = &re->states[ids[i]];
+        if (st->type == NFA_SET && setHas(&re->sets[st->set], c))
+            closure(re, st->out, false, &count);
+    }
+    closure(re, re->start, false, &count);
+
+    int flushes = re->flushes;
+    int next = dfaAdd(re, count);
+
+    // A flush removes d, so the transition is only kept if there was none
+    if (re->flushes == flushes)
+        re->trans[d * 256 + c] = re->dfa[next].isMatch ? TRANS_MATCH : next * 256;
+
+    return next;
+}
+
+bool RegexTest(Regex *re, const char *text, int length)
+{
+    int from = 0;
+    if (re->prefixLen > 0)
+    {
+        char *p = SearchFind(&re->prefixSearch, text, length);
+        if (p == NULL)
+            return false;
+        from = p - text;
+    }
+
+    int d = dfaStart(re, from == 0);
+    if (re->dfa[d].isMatch)
+        return true;
+
+    // Offset of the current state in trans. Every step depends on the one
+    // before, so the loop does as little as possible to get the next state.
+    int s = d * 256;
+    int start = dfaStart(re, false) * 256;
+    const int *trans = re->trans;
+
+    for (int i = from; i < length; i++)
+    {
+        if (s == start && re->numFirstBytes > 0)
+        {
+            i = skipToFirstByte(re, text, i, length);
+            if (i == length)
+                break;
+        }
+
+        byte c = text[i];
+        int next = trans[s + c];
+        if (next < 0)
+        {
+            if (next == TRANS_MATCH)
+                return true;
+
+            int flushes = re->flushes;
+            d = dfaStep(re, s / 256, c);
+            if (re->dfa[d].isMatch)
+                return true;
+            next = d * 256;
+
+            // A flush keeps only the new state. The start state is added back
+            // so skipping to the first byte goes on, which can not flush again.
+            if (re->flushes != flushes)
+                start = dfaStart(re, false) * 256;
+        }
+
+        s = next;
+    }
+
+    return re->dfa[s / 256].matchAtEnd;
+}
+
+// Adds thread and the threads reachable from it without consuming a byte to
+// list, in priority order. Pos is the position of the next byte.
+static void addThread(Regex *re, threadList *list, int pc, int start, int pos, int length)
+{
+    int top = 0;
+    re->stack[top++] = pc;
+
+    while (top > 0)
+    {
+        pc = re->stack[--top];
+        if (re->marks[pc] == list->gen)
+            continue;
+        re->marks[pc] = list->gen;
+
+        nfaState *st = &re->states[pc];
+        switch (st->type)
+        {
+        case NFA_EMPTY:
+            re->stack[top++] = st->out;
+            break;
+        case NFA_SPLIT:
+            re->stack[top++] = st->out1;
+            re->stack[top++] = st->out;
+            break;
+        case NFA_BOL:
+            if (pos == 0)
+                re->stack[top++] = st->out;
+            break;
+        case NFA_EOL:
+            if (pos == length)
+                re->stack[top++] = st->out;
+            break;
+        default:
+            list->threads[list->count++] = (thread){pc, start};
+            break;
+        }
+    }
+}
+
+static void clearList(Regex *re, threadList *list)
+{
+    list->count = 0;
+    list->gen = ++re->gen;
+}
+
+bool RegexFind(Regex *re, const char *text, int length, int from, int *start, int *end)
+{
+    if (re->prefixLen > 0)
+    {
+        char *p = SearchFind(&re->prefixSearch, text + from, length - from);
+        if (p == NULL)
+            return false;
+        from = p - text;
+    }
+
+    threadList *clist = &re->lists[0];
+    threadList *nlist = &re->lists[1];
+    clearList(re, clist);
+
+    bool matched = false;
+    for (int pos = from; pos <= length; pos++)
+    {
+        // Threads that started earlier come first and win
+        if (!matched)
+            addThread(re, clist, re->start, pos, pos, length);
+        if (clist->count == 0)
+        {
+            // An anchor like $ only adds a thread where it can match
+            if (matched)
+                break;
+            clearList(re, clist);
+            continue;
+        }
+
+        clearList(re, nlist);
+        for (int i = 0; i < clist->count; i++)
+        {
+            thread t = clist->threads[i];
+            nfaState *st = &re->states[t.pc];
+
+            if (st->type == NFA_MATCH)
+            {
+                // Threads after this one have lower priority
+                matched = true;
+                *start = t.start;
+                *end = pos;
+                break;
+            }
+
+            if (pos < length && setHas(&re->sets[st->set], text[pos]))
+                addThread(re, nlist, st->out, t.start, pos + 1, length);
+        }
+
+        threadList *tmp = clist;
+        clist = nlist;
+        nlist = tmp;
+    }
+
+    return matched;
+}
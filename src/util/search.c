@@ -0,0 +1,353 @@
+// Substring search. Candidates are found by comparing the first and last byte
+// of the needle against a whole vector of positions at once, and verified with
+// memcmp. Horspool is used where vectors do not fit and on other CPUs.
+//
+// Ignoring case, the candidate bytes are ORed with 0x20 before comparing when
+// they are letters, which maps both cases to lowercase. The few other bytes it
+// also maps are rejected when the candidate is verified with a case folded
+// compare.
+
+#include "rum.h"
+
+extern Config config;
+
+static inline byte foldByte(byte c)
+{
+    return (unsigned)(c - 'A') < 26 ? c | 0x20 : c;
+}
+
+static inline bool isLetter(byte c)
+{
+    return (unsigned)((c | 0x20) - 'a') < 26;
+}
+
+#if defined(__x86_64__) || defined(__SSE2__)
+#define SEARCH_X86
+#include <immintrin.h>
+#endif
+
+// Scalar Horspool from start. Skips ahead by the bad character shift of the
+// last byte in the window.
+static char *searchHorspool(const Searcher *s, const char *h, int n, int start)
+{
+    int m = s->length;
+    byte last = s->needle[m - 1];
+
+    for (int i = start; i + m <= n;)
+    {
+        byte c = h[i + m - 1];
+        if (c == last && !memcmp(h + i, s->needle, m - 1))
+            return (char *)h + i;
+        i += s->skip[c];
+    }
+
+    return NULL;
+}
+
+static char *searchScalar(const Searcher *s, const char *h, int n)
+{
+    return searchHorspool(s, h, n, 0);
+}
+
+static inline bool equalFoldScalar(const char *a, const char *b, int length)
+{
+    for (int i = 0; i < length; i++)
+        if (foldByte(a[i]) != foldByte(b[i]))
+            return false;
+    return true;
+}
+
+// Horspool ignoring case. The skip table has both cases of each byte.
+static char *searchHorspoolFold(const Searcher *s, const char *h, int n, int start)
+{
+    int m = s->length;
+    byte last = s->lower[m - 1];
+
+    for (int i = start; i + m <= n;)
+    {
+        byte c = h[i + m - 1];
+        if (foldByte(c) == last && SearchEqualFold(h + i, s->lower, m - 1))
+            return (char *)h + i;
+        i += s->skip[c];
+    }
+
+    return NULL;
+}
+
+static char *searchScalarFold(const Searcher *s, const char *h, int n)
+{
+    return searchHorspoolFold(s, h, n, 0);
+}
+
+#ifdef SEARCH_X86
+
+// Lowercases ASCII letters in x. Moving 'A' to -128 leaves 'A' to 'Z' as the
+// only bytes below -102 as signed.
+static inline __m128i foldSse2(__m128i x)
+{
+    __m128i upper = _mm_cmplt_epi8(_mm_sub_epi8(x, _mm_set1_epi8('A' - 128)), _mm_set1_epi8(-128 + 26));
+    return _mm_or_si128(x, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+// Inlined so the AVX2 search does not run SSE code with the upper halves of
+// the vector registers in use, which is slow.
+static inline __attribute__((always_inline)) bool equalFoldSse2(const char *a, const char *b, int length)
+{
+    int i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i va = foldSse2(_mm_loadu_si128((const __m128i *)(a + i)));
+        __m128i vb = foldSse2(_mm_loadu_si128((const __m128i *)(b + i)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xffff)
+            return false;
+    }
+
+    return equalFoldScalar(a + i, b + i, length - i);
+}
+
+static char *searchSse2(const Searcher *s, const char *h, int n)
+{
+    int m = s->length;
+    const __m128i first = _mm_set1_epi8(s->needle[0]);
+    const __m128i last = _mm_set1_epi8(s->needle[m - 1]);
+
+    int i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16)
+    {
+        __m128i blockFirst = _mm_loadu_si128((const __m128i *)(h + i));
+        __m128i blockLast = _mm_loadu_si128((const __m128i *)(h + i + m - 1));
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast));
+        unsigned mask = _mm_movemask_epi8(eq);
+
+        while (mask != 0)
+        {
+            int bit = __builtin_ctz(mask);
+            if (!memcmp(h + i + bit + 1, s->needle + 1, m - 2))
+                return (char *)h + i + bit;
+            mask &= mask - 1;
+        }
+    }
+
+    return searchHorspool(s, h, n, i);
+}
+
+__attribute__((target("avx2"))) static char *searchAvx2(const Searcher *s, const char *h, int n)
+{
+    int m = s->length;
+    const __m256i first = _mm256_set1_epi8(s->needle[0]);
+    const __m256i last = _mm256_set1_epi8(s->needle[m - 1]);
+
+    int i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32)
+    {
+        __m256i blockFirst = _mm256_loadu_si256((const __m256i *)(h + i));
+        __m256i blockLast = _mm256_loadu_si256((const __m256i *)(h + i + m - 1));
+        __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast));
+        unsigned mask = _mm256_movemask_epi8(eq);
+
+        while (mask != 0)
+        {
+            int bit = __builtin_ctz(mask);
+            if (!memcmp(h + i + bit + 1, s->needle + 1, m - 2))
+                return (char *)h + i + bit;
+            mask &= mask - 1;
+        }
+    }
+
+    // Rest is shorter than a 32 byte block but may fit a 16 byte one
+    return searchSse2(s, h + i, n - i);
+}
+
+static char *searchSse2Fold(const Searcher *s, const char *h, int n)
+{
+    int m = s->length;
+    byte a = s->lower[0], b = s->lower[m - 1];
+    const __m128i maskFirst = _mm_set1_epi8(s->firstMask);
+    const __m128i maskLast = _mm_set1_epi8(s->lastMask);
+    const __m128i first = _mm_set1_epi8(a);
+    const __m128i last = _mm_set1_epi8(b);
+
+    int i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16)
+    {
+        __m128i blockFirst = _mm_or_si128(_mm_loadu_si128((const __m128i *)(h + i)), maskFirst);
+        __m128i blockLast = _mm_or_si128(_mm_loadu_si128((const __m128i *)(h + i + m - 1)), maskLast);
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast));
+        unsigned mask = _mm_movemask_epi8(eq);
+
+        while (mask != 0)
+        {
+            int bit = __builtin_ctz(mask);
+            if (equalFoldSse2(h + i + bit, s->lower, m))
+                return (char *)h + i + bit;
+            mask &= mask - 1;
+        }
+    }
+
+    return searchHorspoolFold(s, h, n, i);
+}
+
+__attribute__((target("avx2"))) static char *searchAvx2Fold(const Searcher *s, const char *h, int n)
+{
+    int m = s->length;
+    byte a = s->lower[0], b = s->lower[m - 1];
+    const __m256i maskFirst = _mm256_set1_epi8(s->firstMask);
+    const __m256i maskLast = _mm256_set1_epi8(s->lastMask);
+    const __m256i first = _mm256_set1_epi8(a);
+    const __m256i last = _mm256_set1_epi8(b);
+
+    int i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32)
+    {
+        __m256i blockFirst = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(h + i)), maskFirst);
+        __m256i blockLast = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(h + i + m - 1)), maskLast);
+        __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast));
+        unsigned mask = _mm256_movemask_epi8(eq);
+
+        while (mask != 0)
+        {
+            int bit = __builtin_ctz(mask);
+            if (equalFoldSse2(h + i + bit, s->lower, m))
+                return (char *)h + i + bit;
+            mask &= mask - 1;
+        }
+    }
+
+    // The compiler leaves this out before the SSE code here, see equalFoldSse2
+    _mm256_zeroupper();
+    return searchSse2Fold(s, h + i, n - i);
+}
+
+#endif
+
+static bool implSupported(SearchImpl impl)
+{
+#ifdef SEARCH_X86
+    if (impl == SEARCH_AVX2)
+        return __builtin_cpu_supports("avx2");
+    return true; // SSE2 is part of x86-64
+#else
+    return impl == SEARCH_SCALAR;
+#endif
+}
+
+SearchImpl SearchBestImpl()
+{
+    static int best = -1;
+    if (best == -1)
+        best = implSupported(SEARCH_AVX2) ? SEARCH_AVX2 : implSupported(SEARCH_SSE2) ? SEARCH_SSE2
+                                                                                      : SEARCH_SCALAR;
+    return best;
+}
+
+bool SearchInitEx(Searcher *s, const char *needle, int length, bool ignoreCase, SearchImpl impl)
+{
+    if (!implSupported(impl))
+        return false;
+
+    s->needle = needle;
+    s->length = length;
+    s->ignoreCase = false;
+    s->func = searchScalar;
+
+    // Without letters case does not matter
+    if (ignoreCase && length <= MAX_SEARCH)
+        for (int i = 0; i < length; i++)
+            s->ignoreCase |= isLetter(needle[i]);
+
+#ifdef SEARCH_X86
+    if (impl == SEARCH_AVX2)
+        s->func = s->ignoreCase ? searchAvx2Fold : searchAvx2;
+    else if (impl == SEARCH_SSE2)
+        s->func = s->ignoreCase ? searchSse2Fold : searchSse2;
+    else if (s->ignoreCase)
+        s->func = searchScalarFold;
+#else
+    if (s->ignoreCase)
+        s->func = searchScalarFold;
+#endif
+
+    for (int c = 0; c < 256; c++)
+        s->skip[c] = max(length, 1);
+    for (int i = 0; i < length - 1; i++)
+    {
+        s->skip[(byte)needle[i]] = length - 1 - i;
+        if (s->ignoreCase && isLetter(needle[i]))
+            s->skip[needle[i] ^ 0x20] = length - 1 - i;
+    }
+
+    if (s->ignoreCase)
+    {
+        for (int i = 0; i < length; i++)
+            s->lower[i] = foldByte(needle[i]);
+        s->firstMask = isLetter(needle[0]) ? 0x20 : 0;
+        s->lastMask = isLetter(needle[length - 1]) ? 0x20 : 0;
+    }
+
+    return true;
+}
+
+void SearchInit(Searcher *s, const char *needle, int length, bool ignoreCase)
+{
+    SearchInitEx(s, needle, length, ignoreCase, SearchBestImpl());
+}
+
+char *SearchFind(const Searcher *s, const char *haystack, int length)
+{
+    if (s->length == 0 || length < s->length)
+        return NULL;
+
+    // Single bytes are faster with the libc search
+    if (s->length == 1 && !s->ignoreCase)
+        return memchr(haystack, s->needle[0], length);
+
+    return s->func(s, haystack, length);
+}
+
+bool SearchEqualFold(const char *a, const char *b, int length)
+{
+#ifdef SEARCH_X86
+    return equalFoldSse2(a, b, length);
+#else
+    return equalFoldScalar(a, b, length);
+#endif
+}
+
+int SearchParseCase(char *dest, const char *search, int length, bool *ignoreCase)
+{
+    int mode = -1; // 1 for \c, 0 for \C
+    bool hasUpper = false;
+    int n = 0;
+
+    for (int i = 0; i < length && n < MAX_SEARCH; i++)
+    {
+        if (search[i] == '\\' && i + 1 < length)
+        {
+            char e = search[i + 1];
+            if (e == 'c' || e == 'C')
+            {
+                mode = e == 'c';
+                i++;
+                continue;
+            }
+
+            // Keep other escapes whole, \D is not an uppercase letter
+            dest[n++] = search[i++];
+            if (n < MAX_SEARCH)
+                dest[n++] = e;
+            continue;
+        }
+
+        hasUpper |= isupper((byte)search[i]) != 0;
+        dest[n++] = search[i];
+    }
+
+    if (mode != -1)
+        *ignoreCase = mode;
+    else if (config.searchCase == SEARCH_CASE_SMART)
+        *ignoreCase = !hasUpper;
+    else
+        *ignoreCase = config.searchCase == SEARCH_CASE_IGNORE;
+
+    return n;
+}
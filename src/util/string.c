@@ -160,6 +160,60 @@ void StrReplace(char *s, char find, char replace)
     }
 }
 
+char *StrReverse(char *s)
+{
+    int length = strlen(s);
+    for (int i = 0; i < length / 2; i++)
+    {
+        char c = s[i];
+        s[i] = s[length - i - 1];
+        s[length - i - 1] = c;
+    }
+
+    return s;
+}
+
+// Two digit pairs for 00-99, so StrFromInt divides once per two digits
+static const char digitPairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+int StrFromInt(char *dest, unsigned int n)
+{
+    int length = StrNumDigits(n);
+    char *pos = dest + length;
+
+    while (n >= 100)
+    {
+        int pair = (n % 100) * 2;
+        n /= 100;
+        *--pos = digitPairs[pair + 1];
+        *--pos = digitPairs[pair];
+    }
+
+    if (n >= 10)
+    {
+        *--pos = digitPairs[n * 2 + 1];
+        *--pos = digitPairs[n * 2];
+    }
+    else
+        *--pos = '0' + n;
+
+    return length;
+}
+
+int StrNumDigits(unsigned int n)
+{
+    int digits = 1;
+    while (n >= 10)
+    {
+        n /= 10;
+        digits++;
+    }
+    return digits;
+}
+
 #define kilo (1000)
 #define mega (kilo * 1000)
 #define giga (mega * 1000)
@@ -0,0 +1,86 @@
+// Directory walk shared by :grep, :index and the file finder, so they skip the
+// same files and give the same relative paths, which grep looks up in the index.
+
+#include "rum.h"
+
+bool IoJoinPath(char *dest, int size, const char *dir, const char *path)
+{
+    int dirLen = strlen(dir);
+    if (dirLen == 0 || !strcmp(dir, "."))
+        return snprintf(dest, size, "%s", path) < size;
+
+    return snprintf(dest, size, dir[dirLen - 1] == '/' || dir[dirLen - 1] == '\\' ? "%s%s" : "%s/%s", dir, path) < size;
+}
+
+static char *copyPath(const char *path)
+{
+    int length = strlen(path);
+    char *copy = MemAlloc(length + 1);
+    AssertNotNull(copy);
+    memcpy(copy, path, length + 1);
+    return copy;
+}
+
+void IoWalkDir(const char *dir, WalkFunc func, void *arg)
+{
+    // Directories left to list, relative to dir. A stack instead of recursion
+    // keeps deep trees off the small stacks of worker threads.
+    int cap = 64, top = 0;
+    char **stack = MemAlloc(cap * sizeof(char *));
+    AssertNotNull(stack);
+    stack[top++] = copyPath("");
+
+    char listed[PATH_MAX];
+    char path[PATH_MAX];
+    bool stopped = false;
+
+    while (top > 0 && !stopped)
+    {
+        char *rel = stack[--top];
+        int count = 0;
+        DirEntry *entries = NULL;
+        if (IoJoinPath(listed, PATH_MAX, dir, rel[0] != 0 ? rel : "."))
+            entries = IoListDir(listed, &count);
+
+        int firstDir = top;
+        for (int i = 0; entries != NULL && i < count && !stopped; i++)
+        {
+            DirEntry *e = &entries[i];
+            if (e->name[0] == '.' || (e->isDir && e->isLink))
+                continue;
+
+            if (!IoJoinPath(path, PATH_MAX, rel, e->name))
+                continue;
+
+            if (!e->isDir)
+            {
+                stopped = !func(path, e, arg);
+                continue;
+            }
+
+            if (top == cap)
+            {
+                cap *= 2;
+                stack = MemRealloc(stack, cap * sizeof(char *));
+                AssertNotNull(stack);
+            }
+            stack[top++] = copyPath(path);
+        }
+
+        // Popped in name order
+        for (int i = firstDir, j = top - 1; i < j; i++, j--)
+        {
+            char *tmp = stack[i];
+            stack[i] = stack[j];
+            stack[j] = tmp;
+        }
+
+        if (entries != NULL)
+            MemFree(entries);
+        MemFree(rel);
+    }
+
+    while (top > 0)
+        MemFree(stack[--top]);
+    MemFree(stack);
+}
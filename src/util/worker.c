@@ -0,0 +1,16 @@
+// Number of worker threads used by everything that splits its work between
+// threads: buffer search, :grep, :index and the file finder.
+
+#include "rum.h"
+
+static int numWorkers = 0; // 0 for one per CPU
+
+void WorkerSetCount(int count)
+{
+    numWorkers = count;
+}
+
+int WorkerCount()
+{
+    return clamp(1, MAX_WORKERS, numWorkers > 0 ? numWorkers : CpuCount());
+}